@@ -0,0 +1,925 @@
+//
+// 解析/生成的吞吐量测试
+// gcc -O2 -pthread leptjson.c bench.c -o bench && ./bench
+// 对比 SIMD: 再用 -DLEPT_NO_SIMD 编译一次, 或者加 -mavx2
+// 对比紧凑布局 (16 字节节点): 再用 -DLEPT_COMPACT 编译一次
+// 对比解析时检查 UTF-8 的开销: 再用 -DLEPT_CHECK_UTF8 编译一次
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "leptjson.h"
+
+typedef struct {
+    char* s;
+    size_t len, size;
+} bench_buffer;
+
+static void bench_puts(bench_buffer* b, const char* s, size_t len) {
+    if (b->len + len + 1 > b->size) {
+        while (b->len + len + 1 > b->size)
+            b->size = b->size == 0 ? 4096 : b->size * 2;
+        b->s = (char*)realloc(b->s, b->size);
+    }
+    memcpy(b->s + b->len, s, len);
+    b->len += len;
+    b->s[b->len] = '\0';
+}
+
+#define BENCH_PUTS(b, s) bench_puts(b, s, strlen(s))
+
+static void bench_indent(bench_buffer* b, int pretty, int depth) {
+    if (pretty) {
+        bench_puts(b, "\n", 1);
+        while (depth-- > 0)
+            bench_puts(b, "    ", 4);
+    }
+}
+
+/* n 条记录的数组, pretty 为 1 时每层缩进 4 个空格 */
+static char* bench_make_records(size_t n, int pretty, size_t* len) {
+    bench_buffer b = {NULL, 0, 0};
+    char buf[64];
+    size_t i;
+    bench_puts(&b, "[", 1);
+    for (i = 0; i < n; i++) {
+        if (i > 0) bench_puts(&b, ",", 1);
+        bench_indent(&b, pretty, 1);
+        bench_puts(&b, "{", 1);
+        bench_indent(&b, pretty, 2);
+        sprintf(buf, "\"id\": %lu,", (unsigned long)i);
+        BENCH_PUTS(&b, buf);
+        bench_indent(&b, pretty, 2);
+        BENCH_PUTS(&b, "\"name\": \"user name\",");
+        bench_indent(&b, pretty, 2);
+        BENCH_PUTS(&b, "\"active\": true,");
+        bench_indent(&b, pretty, 2);
+        BENCH_PUTS(&b, "\"tags\": [");
+        bench_indent(&b, pretty, 3);
+        BENCH_PUTS(&b, "\"a\",");
+        bench_indent(&b, pretty, 3);
+        BENCH_PUTS(&b, "\"b\"");
+        bench_indent(&b, pretty, 2);
+        BENCH_PUTS(&b, "],");
+        bench_indent(&b, pretty, 2);
+        BENCH_PUTS(&b, "\"extra\": null");
+        bench_indent(&b, pretty, 1);
+        bench_puts(&b, "}", 1);
+    }
+    bench_indent(&b, pretty, 0);
+    bench_puts(&b, "]", 1);
+    *len = b.len;
+    return b.s;
+}
+
+static double bench_seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void bench_report(const char* name, size_t bytes, int iterations, double seconds) {
+    printf("%-28s %10.1f MB/s\n", name, bytes * (double)iterations / seconds / (1024 * 1024));
+}
+
+#define BENCH_ROUNDS 5
+
+/* 取 BENCH_ROUNDS 轮中最快的一轮 */
+static void bench_parse(const char* name, const char* json, size_t len, int iterations) {
+    lept_value v;
+    double best = 0;
+    int i, r;
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++) {
+            lept_init(&v);
+            if (lept_parse(&v, json) != LEPT_PARSE_OK) {
+                fprintf(stderr, "%s: parse error\n", name);
+                exit(1);
+            }
+            lept_free(&v);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report(name, len, iterations, best);
+}
+
+/* 两阶段解析 */
+static void bench_parse_fast(const char* name, const char* json, size_t len, int iterations) {
+    lept_value v;
+    double best = 0;
+    int i, r;
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++) {
+            if (lept_parse_fast(&v, json) != LEPT_PARSE_OK) {
+                fprintf(stderr, "%s: parse error\n", name);
+                exit(1);
+            }
+            lept_free(&v);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report(name, len, iterations, best);
+}
+
+/* 只检查, 不建树 */
+static void bench_validate(const char* name, const char* json, size_t len, int iterations) {
+    double best = 0;
+    int i, r;
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++) {
+            if (lept_validate(json, len) != LEPT_PARSE_OK) {
+                fprintf(stderr, "%s: parse error\n", name);
+                exit(1);
+            }
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report(name, len, iterations, best);
+}
+
+static int bench_sax_count(void* userdata) {
+    ++*(size_t*)userdata;
+    return 1;
+}
+
+/* 只数一下对象的个数, 不构建 lept_value */
+static void bench_sax(const char* name, const char* json, size_t len, int iterations) {
+    lept_handler h;
+    size_t count = 0;
+    double best = 0;
+    int i, r;
+    memset(&h, 0, sizeof(h));
+    h.start_object = bench_sax_count;
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++) {
+            if (lept_parse_sax(json, &h, &count) != LEPT_PARSE_OK) {
+                fprintf(stderr, "%s: parse error\n", name);
+                exit(1);
+            }
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report(name, len, iterations, best);
+}
+
+/* 每次输入 4KB, 模拟从 socket 读到的分块 */
+static void bench_stream(const char* name, const char* json, size_t len, int iterations) {
+    lept_value v;
+    double best = 0;
+    size_t k;
+    int i, r;
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++) {
+            lept_stream_parser* p = lept_stream_create(&v);
+            for (k = 0; k < len; k += 4096)
+                lept_stream_feed(p, json + k, len - k < 4096 ? len - k : 4096);
+            if (lept_stream_finish(p) != LEPT_PARSE_OK) {
+                fprintf(stderr, "%s: parse error\n", name);
+                exit(1);
+            }
+            lept_stream_destroy(p);
+            lept_free(&v);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report(name, len, iterations, best);
+}
+
+/* 不需要 '\0' 结尾的版本 */
+static void bench_parse_n(const char* name, const char* json, size_t len, int iterations) {
+    lept_value v;
+    double best = 0;
+    int i, r;
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++) {
+            if (lept_parse_n(&v, json, len) != LEPT_PARSE_OK) {
+                fprintf(stderr, "%s: parse error\n", name);
+                exit(1);
+            }
+            lept_free(&v);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report(name, len, iterations, best);
+}
+
+/* 指向节点自身的字符串是短字符串, 没有单独分配 */
+#define BENCH_INSIDE(s, p) ((const char*)(s) >= (const char*)(p) && (const char*)(s) < (const char*)((p) + 1))
+
+/* 树占用的内存: 节点、数组/成员块和字符串, 每次分配估计 16 字节的开销; 不计 pool 中的 key */
+static size_t bench_tree_bytes(const lept_value* v, lept_key_pool* pool) {
+    size_t i, n = 0;
+    switch (lept_get_type(v)) {
+        case LEPT_STRING:
+            return BENCH_INSIDE(lept_get_string(v), v) ? 0 : lept_get_string_length(v) + 1 + 16;
+        case LEPT_ARRAY:
+            for (i = 0; i < lept_get_array_size(v); i++)
+                n += sizeof(lept_value) + bench_tree_bytes(lept_get_array_element(v, i), pool);
+            return n + 16;
+        case LEPT_OBJECT:
+            for (i = 0; i < lept_get_object_size(v); i++) {
+                const lept_value* e = lept_get_object_value(v, i);
+                const char* k = lept_get_object_key(v, i);
+                size_t klen = lept_get_object_key_length(v, i);
+                n += sizeof(lept_member) + bench_tree_bytes(e, pool);
+                if (pool != NULL && lept_key_pool_intern(pool, k, klen) == k)
+                    continue;
+                if (!BENCH_INSIDE(k, (const lept_member*)((const char*)e - offsetof(lept_member, v))))
+                    n += klen + 1 + 16;
+            }
+            return n + 16;
+        default:
+            return 0;
+    }
+}
+
+/* tape 的解析速度、内存, 以及遍历所有记录读取 "id" 的速度 */
+static void bench_tape(const char* json, size_t len) {
+    lept_tape t;
+    lept_value v;
+    double best = 0, sum = 0;
+    size_t k, tree;
+    int i, r;
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double s;
+        for (i = 0; i < 20; i++) {
+            if (lept_tape_parse(&t, json) != LEPT_PARSE_OK) {
+                fprintf(stderr, "tape: parse error\n");
+                exit(1);
+            }
+            lept_tape_free(&t);
+        }
+        s = bench_seconds(start);
+        if (r == 0 || s < best)
+            best = s;
+    }
+    bench_report("tape parse minified", len, 20, best);
+
+    lept_init(&v);
+    lept_parse(&v, json);
+    lept_tape_parse(&t, json);
+    tree = sizeof(lept_value) + bench_tree_bytes(&v, NULL);
+    printf("%-28s %10.2f x input (tree %.2f x)\n", "tape memory", (t.size * 8 + t.strings_size) / (double)len, tree / (double)len);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double s;
+        for (i = 0; i < 20; i++)
+            for (k = lept_tape_child(&t, 0); k < t.size; k = lept_tape_next(&t, k))
+                sum += lept_tape_get_number(&t, lept_tape_find(&t, k, "id", 2));
+        s = bench_seconds(start);
+        if (r == 0 || s < best)
+            best = s;
+    }
+    bench_report("tape traverse", len, 20, best);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double s;
+        for (i = 0; i < 20; i++)
+            for (k = 0; k < lept_get_array_size(&v); k++)
+                sum += lept_get_number(lept_find_object_value(lept_get_array_element(&v, k), "id", 2));
+        s = bench_seconds(start);
+        if (r == 0 || s < best)
+            best = s;
+    }
+    bench_report("tree traverse", len, 20, best);
+    if (sum < 0)
+        printf("%g\n", sum);
+    lept_tape_free(&t);
+    lept_free(&v);
+}
+
+static void bench_whitespace() {
+    size_t len;
+    char* json;
+    json = bench_make_records(20000, 1, &len);
+    bench_parse("parse indented", json, len, 20);
+    bench_parse_n("parse_n indented", json, len, 20);
+    bench_parse_fast("parse_fast indented", json, len, 20);
+    free(json);
+    json = bench_make_records(20000, 0, &len);
+    bench_parse("parse minified", json, len, 20);
+    bench_parse_n("parse_n minified", json, len, 20);
+    bench_parse_fast("parse_fast minified", json, len, 20);
+    bench_validate("validate minified", json, len, 20);
+    bench_sax("sax minified", json, len, 20);
+    bench_stream("stream minified", json, len, 20);
+    bench_tape(json, len);
+    free(json);
+}
+
+/* 以较长的字符串为主的文档, 例如日志 */
+static char* bench_make_strings(size_t n, size_t* len) {
+    bench_buffer b = {NULL, 0, 0};
+    size_t i;
+    bench_puts(&b, "[", 1);
+    for (i = 0; i < n; i++) {
+        if (i > 0) bench_puts(&b, ",", 1);
+        BENCH_PUTS(&b, "{\"level\":\"info\",\"message\":\"GET /api/v1/users/12345/profile?fields=name,email 200 OK in 12ms\","
+                       "\"agent\":\"Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\","
+                       "\"note\":\"line one\\nline two \\\"quoted\\\" \\u00e9t\\u00e9\"}");
+    }
+    bench_puts(&b, "]", 1);
+    *len = b.len;
+    return b.s;
+}
+
+/* 遥测数据和地理坐标: 几乎都是数字 */
+static char* bench_make_numbers(size_t n, size_t* len) {
+    bench_buffer b = {NULL, 0, 0};
+    char buf[128];
+    size_t i;
+    bench_puts(&b, "[", 1);
+    for (i = 0; i < n; i++) {
+        if (i > 0) bench_puts(&b, ",", 1);
+        sprintf(buf, "[%.6f,%.6f,%lu,%.2f,%g]", 116.0 + i * 0.000731, 39.0 - i * 0.000417,
+                (unsigned long)(1634000000 + i), 20.0 + (i % 1000) * 0.01, 1.0 / (i + 1));
+        BENCH_PUTS(&b, buf);
+    }
+    bench_puts(&b, "]", 1);
+    *len = b.len;
+    return b.s;
+}
+
+static void bench_stringify(const char* name, const char* json, int iterations) {
+    lept_value v;
+    double best = 0;
+    size_t len = 0;
+    int i, r;
+    lept_init(&v);
+    if (lept_parse(&v, json) != LEPT_PARSE_OK) {
+        fprintf(stderr, "%s: parse error\n", name);
+        exit(1);
+    }
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++)
+            free(lept_stringify(&v, &len));
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report(name, len, iterations, best);
+    lept_free(&v);
+}
+
+static int bench_write_discard(void* ctx, const char* data, size_t len) {
+    (void)data;
+    *(size_t*)ctx += len;
+    return 0;
+}
+
+/* 写入固定大小的缓冲区, 不生成整个字符串 */
+static void bench_stringify_to(const char* name, const char* json, int iterations) {
+    lept_value v;
+    double best = 0;
+    size_t len = 0;
+    int i, r;
+    lept_init(&v);
+    if (lept_parse(&v, json) != LEPT_PARSE_OK) {
+        fprintf(stderr, "%s: parse error\n", name);
+        exit(1);
+    }
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++) {
+            len = 0;
+            lept_stringify_to(&v, bench_write_discard, &len);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report(name, len, iterations, best);
+    lept_free(&v);
+}
+
+static void bench_string() {
+    size_t len;
+    char* json = bench_make_strings(20000, &len);
+    bench_parse("parse strings", json, len, 20);
+    bench_parse_n("parse_n strings", json, len, 20);
+    bench_parse_fast("parse_fast strings", json, len, 20);
+    bench_validate("validate strings", json, len, 20);
+    bench_stringify("stringify strings", json, 20);
+    bench_stringify_to("stringify_to strings", json, 20);
+    free(json);
+}
+
+static void bench_number() {
+    size_t len;
+    char* json = bench_make_numbers(100000, &len);
+    bench_parse("parse numbers", json, len, 10);
+    bench_parse_n("parse_n numbers", json, len, 10);
+    bench_parse_fast("parse_fast numbers", json, len, 10);
+    bench_validate("validate numbers", json, len, 10);
+    bench_stringify("stringify numbers", json, 10);
+    bench_stringify_to("stringify_to numbers", json, 10);
+    free(json);
+}
+
+/* 没有转义的中文字符串, 用来对比 LEPT_CHECK_UTF8 的开销 */
+static void bench_utf8() {
+    bench_buffer b = {NULL, 0, 0};
+    size_t i;
+    bench_puts(&b, "[", 1);
+    for (i = 0; i < 20000; i++) {
+        if (i > 0) bench_puts(&b, ",", 1);
+        BENCH_PUTS(&b, "{\"city\":\"北京\",\"message\":\"用户 12345 在 12ms 内完成了登录, 状态正常\","
+                       "\"note\":\"数据来自 2021 年的日志 \u00e9t\u00e9 ✓\"}");
+    }
+    bench_puts(&b, "]", 1);
+    bench_parse_n("parse_n utf8", b.s, b.len, 20);
+    bench_validate("validate utf8", b.s, b.len, 20);
+    free(b.s);
+}
+
+/* 大数组的内存和遍历速度, 用来对比默认布局和 LEPT_COMPACT */
+static void bench_array() {
+    lept_value v;
+    double best = 0, sum = 0;
+    size_t i, j, n = 0, len;
+    int r;
+    char* json = bench_make_numbers(500000, &len);
+    lept_init(&v);
+    if (lept_parse(&v, json) != LEPT_PARSE_OK) {
+        fprintf(stderr, "array: parse error\n");
+        exit(1);
+    }
+    printf("%-28s %10lu bytes\n", "array node size", (unsigned long)sizeof(lept_value));
+    printf("%-28s %10.1f MB (%.2f x input)\n", "array memory", bench_tree_bytes(&v, NULL) / 1e6, bench_tree_bytes(&v, NULL) / (double)len);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        int k;
+        for (k = 0, n = 0; k < 20; k++)
+            for (i = 0; i < lept_get_array_size(&v); i++) {
+                const lept_value* e = lept_get_array_element(&v, i);
+                for (j = 0; j < lept_get_array_size(e); j++, n++)
+                    sum += lept_get_number(lept_get_array_element(e, j));
+            }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    printf("%-28s %10.1f M/s\n", "array traverse", n / best / 1e6);
+    if (sum < 0)
+        printf("%g\n", sum);
+    lept_free(&v);
+    free(json);
+}
+
+/* 共用 20 个 key 的记录数组: 每次都分配 key 和使用 key 池的解析速度、内存 */
+static void bench_key_pool() {
+    static const char* keys[] = {
+        "id", "status", "customer_account_id", "customer_display_name", "shipping_address_line1",
+        "shipping_address_city", "shipping_postal_code", "billing_address_line1", "created_timestamp",
+        "updated_timestamp", "payment_method_type", "currency", "total_amount_cents", "discount_code",
+        "fulfillment_center_id", "estimated_delivery_date", "gift_wrap", "loyalty_points_earned",
+        "referral_source_channel", "notes"
+    };
+    bench_buffer b = {NULL, 0, 0};
+    lept_key_pool pool;
+    lept_value v;
+    char buf[64];
+    double best = 0;
+    size_t i, k;
+    int j, r;
+    bench_puts(&b, "[", 1);
+    for (i = 0; i < 20000; i++) {
+        bench_puts(&b, i > 0 ? ",{" : "{", i > 0 ? 2 : 1);
+        for (k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+            sprintf(buf, "%s\"%s\":%lu", k > 0 ? "," : "", keys[k], (unsigned long)(i * 31 + k));
+            BENCH_PUTS(&b, buf);
+        }
+        bench_puts(&b, "}", 1);
+    }
+    bench_puts(&b, "]", 1);
+    bench_parse("parse records 20 keys", b.s, b.len, 10);
+    lept_key_pool_init(&pool);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (j = 0; j < 10; j++) {
+            lept_init(&v);
+            if (lept_parse_pooled(&pool, &v, b.s) != LEPT_PARSE_OK) {
+                fprintf(stderr, "key pool: parse error\n");
+                exit(1);
+            }
+            lept_free(&v);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    bench_report("parse_pooled records 20 keys", b.len, 10, best);
+    lept_init(&v);
+    lept_parse(&v, b.s);
+    printf("%-28s %10.2f x input", "key pool memory", bench_tree_bytes(&v, NULL) / (double)b.len);
+    lept_free(&v);
+    lept_parse_pooled(&pool, &v, b.s);
+    printf(" (pooled %.2f x)\n", bench_tree_bytes(&v, &pool) / (double)b.len);
+    lept_free(&v);
+    lept_key_pool_destroy(&pool);
+    free(b.s);
+}
+
+/* 编译一次反复查找, 每次都编译, 以及手写的 find/get 调用链 */
+static void bench_pointer() {
+    static const char path[] = "/data/items/150/customer/address/city";
+    bench_buffer b = {NULL, 0, 0};
+    lept_pointer p;
+    lept_value v;
+    char buf[160];
+    double best[3] = {0, 0, 0};
+    size_t i, n = 1000000, found = 0;
+    int r;
+    BENCH_PUTS(&b, "{\"version\":1,\"data\":{\"total\":200,\"items\":[");
+    for (i = 0; i < 200; i++) {
+        sprintf(buf, "%s{\"id\":%lu,\"customer\":{\"name\":\"n%lu\",\"address\":{\"street\":\"s\",\"city\":\"c%lu\"}}}",
+                i > 0 ? "," : "", (unsigned long)i, (unsigned long)i, (unsigned long)i);
+        BENCH_PUTS(&b, buf);
+    }
+    BENCH_PUTS(&b, "]}}");
+    lept_init(&v);
+    lept_parse(&v, b.s);
+    lept_pointer_compile(&p, path);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start;
+        double t;
+        start = clock();
+        for (i = 0; i < n; i++)
+            found += lept_pointer_get(&v, &p) != NULL;
+        t = bench_seconds(start);
+        if (r == 0 || t < best[0])
+            best[0] = t;
+        start = clock();
+        for (i = 0; i < n; i++) {
+            lept_pointer q;
+            lept_pointer_compile(&q, path);
+            found += lept_pointer_get(&v, &q) != NULL;
+            lept_pointer_free(&q);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best[1])
+            best[1] = t;
+        start = clock();
+        for (i = 0; i < n; i++) {
+            lept_value* e = lept_find_object_value(lept_find_object_value(&v, "data", 4), "items", 5);
+            e = lept_find_object_value(lept_get_array_element(e, 150), "customer", 8);
+            found += lept_find_object_value(lept_find_object_value(e, "address", 7), "city", 4) != NULL;
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best[2])
+            best[2] = t;
+    }
+    printf("%-28s %10.1f M/s\n", "pointer compiled", n / best[0] / 1e6);
+    printf("%-28s %10.1f M/s\n", "pointer compile each time", n / best[1] / 1e6);
+    printf("%-28s %10.1f M/s\n", "find chain", n / best[2] / 1e6);
+    if (found != n * 3 * BENCH_ROUNDS)
+        fprintf(stderr, "pointer: not found\n");
+    lept_pointer_free(&p);
+    lept_free(&v);
+    free(b.s);
+}
+
+/* 大文档中只读取 3 个字段: 完整解析后查找, 对比按需解析 */
+static void bench_cursor() {
+    bench_buffer b = {NULL, 0, 0};
+    char* records;
+    size_t len, i, found = 0;
+    double best[2] = {0, 0};
+    int n = 20, r;
+    records = bench_make_records(20000, 0, &len);
+    BENCH_PUTS(&b, "{\"version\":3,\"items\":");
+    bench_puts(&b, records, len);
+    BENCH_PUTS(&b, ",\"meta\":{\"count\":20000,\"status\":\"ok\"}}");
+    free(records);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start;
+        double t;
+        start = clock();
+        for (i = 0; i < (size_t)n; i++) {
+            lept_value v;
+            lept_value* e;
+            lept_init(&v);
+            lept_parse_n(&v, b.s, b.len);
+            found += lept_find_object_value(&v, "version", 7) != NULL;
+            e = lept_get_array_element(lept_find_object_value(&v, "items", 5), 100);
+            found += lept_find_object_value(e, "name", 4) != NULL;
+            found += lept_find_object_value(lept_find_object_value(&v, "meta", 4), "count", 5) != NULL;
+            lept_free(&v);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best[0])
+            best[0] = t;
+        start = clock();
+        for (i = 0; i < (size_t)n; i++) {
+            lept_doc d;
+            lept_cursor root, c, e;
+            const char* s;
+            size_t k, slen;
+            double x;
+            lept_doc_init(&d, b.s, b.len);
+            lept_doc_root(&d, &root);
+            if (lept_cursor_find(&root, "version", 7, &c) == LEPT_PARSE_OK && lept_cursor_get_number(&c, &x) == LEPT_PARSE_OK)
+                found++;
+            if (lept_cursor_find(&root, "items", 5, &c) == LEPT_PARSE_OK && lept_cursor_child(&c, &e) == LEPT_PARSE_OK) {
+                for (k = 0; k < 100 && lept_cursor_next(&e) == LEPT_PARSE_OK; k++)
+                    ;
+                if (lept_cursor_find(&e, "name", 4, &c) == LEPT_PARSE_OK && lept_cursor_get_string(&c, &s, &slen) == LEPT_PARSE_OK)
+                    found++;
+            }
+            if (lept_cursor_find(&root, "meta", 4, &c) == LEPT_PARSE_OK && lept_cursor_find(&c, "count", 5, &e) == LEPT_PARSE_OK
+                    && lept_cursor_get_number(&e, &x) == LEPT_PARSE_OK)
+                found++;
+            lept_doc_free(&d);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best[1])
+            best[1] = t;
+    }
+    bench_report("parse + find 3 fields", b.len, n, best[0]);
+    bench_report("cursor 3 fields", b.len, n, best[1]);
+    if (found != (size_t)n * 6 * BENCH_ROUNDS)
+        fprintf(stderr, "cursor: not found\n");
+    free(b.s);
+}
+
+/* 60 个字段的事件, 只保留其中 3 个: 完整解析对比投影解析 */
+static void bench_projected() {
+    static const char* const paths[] = { "/type", "/user/id", "/metrics/latency_ms" };
+    bench_buffer b = {NULL, 0, 0};
+    char buf[96];
+    double best[2] = {0, 0};
+    size_t i, n = 20000, found = 0;
+    int r;
+    BENCH_PUTS(&b, "{\"type\":\"click\",\"user\":{\"id\":12345,\"name\":\"user name\",\"tags\":[\"a\",\"b\",\"c\"]},");
+    for (i = 0; i < 50; i++) {
+        sprintf(buf, "\"field_%lu\":\"value of the field number %lu\",", (unsigned long)i, (unsigned long)i);
+        BENCH_PUTS(&b, buf);
+    }
+    BENCH_PUTS(&b, "\"context\":{\"page\":\"/home\",\"referrer\":\"https://example.com/\",\"screen\":[1920,1080]},"
+                   "\"metrics\":{\"latency_ms\":12.5,\"bytes\":5120,\"retries\":0}}");
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start;
+        double t;
+        start = clock();
+        for (i = 0; i < n; i++) {
+            lept_value v;
+            lept_init(&v);
+            lept_parse(&v, b.s);
+            found += lept_find_object_value(lept_find_object_value(&v, "metrics", 7), "latency_ms", 10) != NULL;
+            lept_free(&v);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best[0])
+            best[0] = t;
+        start = clock();
+        for (i = 0; i < n; i++) {
+            lept_value v;
+            lept_parse_projected(&v, b.s, paths, 3);
+            found += lept_find_object_value(lept_find_object_value(&v, "metrics", 7), "latency_ms", 10) != NULL;
+            lept_free(&v);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best[1])
+            best[1] = t;
+    }
+    bench_report("parse wide events", b.len, (int)n, best[0]);
+    bench_report("parse_projected 3 fields", b.len, (int)n, best[1]);
+    if (found != n * 2 * BENCH_ROUNDS)
+        fprintf(stderr, "projected: not found\n");
+    free(b.s);
+}
+
+/* 生成 + 解析的往返, JSON 和 CBOR 都按 JSON 的字节数计算吞吐量 */
+static void bench_cbor_roundtrip(const char* name, const char* json, int iterations) {
+    lept_value v;
+    char* out;
+    double best[2] = {0, 0};
+    size_t len, clen = 0, jlen = 0;
+    int i, r;
+    char buf[64];
+    lept_init(&v);
+    lept_parse(&v, json);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < iterations; i++) {
+            out = lept_stringify(&v, &jlen);
+            lept_free(&v);
+            lept_parse(&v, out);
+            free(out);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best[0])
+            best[0] = t;
+        start = clock();
+        for (i = 0; i < iterations; i++) {
+            out = lept_encode_cbor(&v, &clen);
+            lept_free(&v);
+            lept_decode_cbor(&v, out, clen);
+            free(out);
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best[1])
+            best[1] = t;
+    }
+    lept_free(&v);
+    len = strlen(json);
+    sprintf(buf, "%s json roundtrip", name);
+    bench_report(buf, len, iterations, best[0]);
+    sprintf(buf, "%s cbor roundtrip", name);
+    bench_report(buf, len, iterations, best[1]);
+    printf("%-28s %10lu / %lu bytes\n", "  json / cbor size", (unsigned long)jlen, (unsigned long)clen);
+}
+
+static void bench_cbor() {
+    size_t len;
+    char* json = bench_make_records(20000, 0, &len);
+    bench_cbor_roundtrip("records", json, 20);
+    free(json);
+    json = bench_make_numbers(200000, &len);
+    bench_cbor_roundtrip("numbers", json, 20);
+    free(json);
+}
+
+/* 5000 个 key 的对象, 每个 key 查找一次 */
+static void bench_object() {
+    lept_value o;
+    char key[16];
+    double best = 0;
+    size_t i, len;
+    int r;
+    lept_init(&o);
+    lept_set_object(&o, 0);
+    for (i = 0; i < 5000; i++) {
+        len = sprintf(key, "feature_%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&o, key, len), i);
+    }
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < 5000; i++) {
+            len = sprintf(key, "feature_%lu", (unsigned long)i);
+            if (lept_find_object_value(&o, key, len) == NULL) {
+                fprintf(stderr, "object lookup: missing key\n");
+                exit(1);
+            }
+        }
+        t = bench_seconds(start);
+        if (r == 0 || t < best)
+            best = t;
+    }
+    printf("%-28s %10.1f M/s\n", "object lookup", 5000 / best / 1e6);
+    lept_free(&o);
+}
+
+static double bench_wall() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 每个 worker 启动时加载参考文档: 解析 JSON 文件 vs 映射快照, 然后按下标和 key 读取一个字段 */
+static void bench_snapshot() {
+    static const char* json_path = "leptjson_bench.json";
+    static const char* snapshot_path = "leptjson_bench.snapshot";
+    lept_value v;
+    lept_snapshot s;
+    FILE* fp;
+    double best[2] = {0, 0}, sum = 0;
+    size_t len, i, k;
+    int r, n = 50;
+    char* json = bench_make_records(100000, 0, &len);
+    fp = fopen(json_path, "wb");
+    fwrite(json, 1, len, fp);
+    fclose(fp);
+    lept_init(&v);
+    lept_parse(&v, json);
+    lept_snapshot_write(&v, snapshot_path);
+    lept_free(&v);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        double start = bench_wall(), t;
+        for (i = 0; i < (size_t)n; i++) {
+            lept_parse_file(&v, json_path, 0);
+            sum += lept_get_number(lept_find_object_value(lept_get_array_element(&v, i * 997), "id", 2));
+            lept_free(&v);
+        }
+        t = bench_wall() - start;
+        if (r == 0 || t < best[0])
+            best[0] = t;
+        start = bench_wall();
+        for (i = 0; i < (size_t)n; i++) {
+            lept_snapshot_open(&s, snapshot_path, 0);
+            sum += lept_snapshot_get_number(&s, lept_snapshot_find(&s, lept_snapshot_get_element(&s, 0, i * 997), "id", 2));
+            lept_snapshot_close(&s);
+        }
+        t = bench_wall() - start;
+        if (r == 0 || t < best[1])
+            best[1] = t;
+    }
+    printf("%-28s %10.3f ms\n", "startup parse_file", best[0] * 1000 / n);
+    printf("%-28s %10.3f ms\n", "startup snapshot_open", best[1] * 1000 / n);
+
+    /* 遍历所有记录读取 "id" */
+    lept_snapshot_open(&s, snapshot_path, LEPT_FILE_POPULATE);
+    printf("%-28s %10.2f x input\n", "snapshot size", s.map.size / (double)len);
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        clock_t start = clock();
+        double t;
+        for (i = 0; i < 20; i++)
+            for (k = 0; k < lept_snapshot_get_size(&s, 0); k++)
+                sum += lept_snapshot_get_number(&s, lept_snapshot_find(&s, lept_snapshot_get_element(&s, 0, k), "id", 2));
+        t = bench_seconds(start);
+        if (r == 0 || t < best[0])
+            best[0] = t;
+    }
+    bench_report("snapshot traverse", len, 20, best[0]);
+    lept_snapshot_close(&s);
+    if (sum < 0)
+        printf("%g\n", sum);
+    remove(json_path);
+    remove(snapshot_path);
+    free(json);
+}
+
+static int bench_ndjson_line(void* userdata, size_t offset, lept_value* v, int ret) {
+    (void)userdata;
+    (void)offset;
+    (void)v;
+    return ret == LEPT_PARSE_OK;
+}
+
+/* 每行一条记录, 不同线程数的吞吐量 (墙上时间, clock() 会把各线程的 CPU 时间加起来) */
+static void bench_ndjson() {
+    bench_buffer b = {NULL, 0, 0};
+    char buf[256], name[64];
+    size_t i;
+    int n, ordered, r;
+    for (i = 0; i < 500000; i++) {
+        sprintf(buf, "{\"id\":%lu,\"level\":\"info\",\"message\":\"GET /api/v1/users/%lu 200 OK\",\"ms\":%.3f,\"tags\":[\"a\",\"b\"]}\n",
+                (unsigned long)i, (unsigned long)(i * 7919 % 100000), (i % 1000) * 0.125);
+        BENCH_PUTS(&b, buf);
+    }
+    for (ordered = 0; ordered <= 1; ordered++)
+        for (n = 1; n <= 16; n *= 2) {
+            double best = 0;
+            for (r = 0; r < BENCH_ROUNDS; r++) {
+                double t = bench_wall();
+                if (lept_ndjson_parse_parallel(b.s, b.len, n, ordered, bench_ndjson_line, NULL) != LEPT_PARSE_OK) {
+                    fprintf(stderr, "ndjson: parse error\n");
+                    exit(1);
+                }
+                t = bench_wall() - t;
+                if (r == 0 || t < best)
+                    best = t;
+            }
+            sprintf(name, "ndjson %s %d threads", ordered ? "ordered" : "unordered", n);
+            bench_report(name, b.len, 1, best);
+        }
+    free(b.s);
+}
+
+int main() {
+    bench_whitespace();
+    bench_string();
+    bench_number();
+    bench_utf8();
+    bench_array();
+    bench_key_pool();
+    bench_object();
+    bench_pointer();
+    bench_cursor();
+    bench_projected();
+    bench_cbor();
+    bench_snapshot();
+    bench_ndjson();
+    return 0;
+}
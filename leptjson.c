@@ -4,18 +4,109 @@
 #include "leptjson.h"
 #include <assert.h> // assert
 #include <stdlib.h> // NULL malloc realloc free strtod
-#include <errno.h>  // errno, ERANGE
 #include <math.h> // HUGE_VAL
+#include <float.h> // FLT_EVAL_METHOD
 #include <string.h> // memcpy
 #include <stdio.h> // sprintf()
+#include <stdint.h> // uintptr_t
+#include <errno.h> // errno
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#include <sys/mman.h> // mmap madvise
+#include <sys/stat.h> // fstat
+#define LEPT_POSIX // 可以使用 mmap / write 等 POSIX 接口
+#endif
+
+#if defined(LEPT_POSIX) && !defined(LEPT_NO_THREADS)
+#include <pthread.h> // 需要 -pthread
+#define LEPT_THREADS
+#endif
+
+/* 定义 LEPT_NO_SIMD 可以关闭 SIMD 代码; SIMD 只在剩余的输入不少于 16/32 字节时使用, 不会越界读取 */
+
+#if !defined(LEPT_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define LEPT_AVX2
+#elif !defined(LEPT_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define LEPT_SSE2
+#endif
+
+/* 定义 LEPT_CHECK_UTF8 时解析也检查字符串是否为合法的 UTF-8, 不合法时返回 LEPT_PARSE_INVALID_UTF8 */
 
 
 #ifndef LEPT_PARSE_STACK_INIT_SIZE
 #define LEPT_PARSE_STACK_INIT_SIZE 256
 #endif
 
-#define EXPECT(c, ch)       do { assert(*c->json == (ch)); c->json++; } while(0)
+/* lept_stringify_to 的缓冲区满了之后写给 lept_write_fn */
+#ifndef LEPT_WRITE_BUFFER_SIZE
+#define LEPT_WRITE_BUFFER_SIZE (64 * 1024)
+#endif
+
+#ifndef LEPT_ARENA_CHUNK_SIZE
+#define LEPT_ARENA_CHUNK_SIZE (64 * 1024)
+#endif
+
+/* NDJSON 并行解析时每个线程一次取走的输入大小 (延长到行尾) */
+#ifndef LEPT_NDJSON_CHUNK_SIZE
+#define LEPT_NDJSON_CHUNK_SIZE (1024 * 1024)
+#endif
+
+/* lept_parse_fast 每次为多少字节的输入建立结构索引 (64 的倍数), 索引的内存只和它有关 */
+#ifndef LEPT_STRUCTURAL_WINDOW
+#define LEPT_STRUCTURAL_WINDOW (16 * 1024)
+#endif
+
+/* 成员数不少于该值的对象使用哈希索引查找 key */
+#ifndef LEPT_OBJECT_INDEX_MIN
+#define LEPT_OBJECT_INDEX_MIN 16
+#endif
+
+/* 数组/对象的最大容量和字符串的最大长度, 紧凑布局中容量只有 23 位, 长度只有 32 位 */
+#if defined(LEPT_COMPACT)
+#define LEPT_MAX_CAPACITY ((size_t)LEPT_COMPACT_MAX_CAPACITY)
+#define LEPT_MAX_STRING_LENGTH ((size_t)UINT32_MAX)
+#else
+#define LEPT_MAX_CAPACITY ((size_t)-1 / sizeof(lept_member))
+#define LEPT_MAX_STRING_LENGTH ((size_t)-1 - 1)
+#endif
+/* 容量翻倍, 不超过 LEPT_MAX_CAPACITY */
+#define LEPT_GROW_CAPACITY(n) ((n) == 0 ? 1 : (n) < LEPT_MAX_CAPACITY / 2 ? (n) * 2 : LEPT_MAX_CAPACITY)
+
+/* 短字符串 (LEPT_FLAG_INLINE) 的最后一个字节是剩余的空间, 长度最大时它正好是结尾的 '\0' */
+#define LEPT_SHORT_STRING_MAX (sizeof(((lept_value*)0)->ss) - 1)
+#define LEPT_STRING(v) (((v)->flags & LEPT_FLAG_INLINE) ? (v)->ss : (v)->s)
+#define LEPT_STRING_LEN(v) (((v)->flags & LEPT_FLAG_INLINE) ? \
+    LEPT_SHORT_STRING_MAX - (unsigned char)(v)->ss[LEPT_SHORT_STRING_MAX] : (size_t)(v)->len)
+
+/*
+ * 短 key 的 ks[LEPT_KEY_TAG] 和 klen 的最高字节重合, 保存 0x80 | 长度, 其它字节保存内容和结尾的 '\0';
+ * 其它 key 的长度用不到最高字节, ks[LEPT_KEY_TAG] 为 0
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define LEPT_KEY_TAG 0
+#define LEPT_KEY_CHARS 1
+#else
+#define LEPT_KEY_TAG (sizeof(((lept_member*)0)->ks) - 1)
+#define LEPT_KEY_CHARS 0
+#endif
+#define LEPT_SHORT_KEY_MAX (sizeof(((lept_member*)0)->ks) - 2)
+#define LEPT_KEY_IS_SHORT(m) ((unsigned char)(m)->ks[LEPT_KEY_TAG] & 0x80)
+#define LEPT_KEY(m) (LEPT_KEY_IS_SHORT(m) ? (m)->ks + LEPT_KEY_CHARS : (m)->k)
+#define LEPT_KEY_LEN(m) (LEPT_KEY_IS_SHORT(m) ? (size_t)((unsigned char)(m)->ks[LEPT_KEY_TAG] & 0x7F) : (m)->klen)
+/* 来自同一个 key 池的 key 指针相同, 先比较指针 */
+#define LEPT_KEY_EQUAL(m, key, klen) \
+    (LEPT_KEY_LEN(m) == (klen) && (LEPT_KEY(m) == (key) || memcmp(LEPT_KEY(m), key, klen) == 0))
 
+/* 输入到 end 为止, 读到 end 时相当于读到了 '\0', 所以词法分析都不需要输入以 '\0' 结尾 */
+#define AT(p, end) ((p) < (end) ? *(p) : '\0')
+#define PEEK(c) AT((c)->json, (c)->end)
+#define EXPECT(c, ch)       do { assert(PEEK(c) == (ch)); c->json++; } while(0)
+
+#define ISWHITESPACE(ch) ((ch) == ' ' || (ch) == '\t' || (ch) == '\n' || (ch) == '\r')
 #define ISDIGIT(ch) ((ch) >= '0' && (ch) <= '9')
 #define ISDIG1TO9(ch) ((ch) >= '1' && (ch) <= '9')
 #define PUTC(c, ch)         do { *(char*)lept_context_push(c, sizeof(char)) = (ch); } while(0)
@@ -23,10 +114,162 @@
 
 typedef struct {
     const char* json;
+    const char* end; // 输入的结尾
     char* stack;
     size_t size, top;
+    lept_arena* arena; // 不为 NULL 时解析结果的内存从 arena 分配
+    lept_key_pool* keys; // 不为 NULL 时长 key 从池中取得
+    int insitu; // 字符串和 key 原地解码到输入中
+    lept_write_fn write; // 生成 JSON 时不为 NULL 则分段输出到 write
+    void* write_ctx;
+    int write_ret; // write 返回的第一个非 0 值
 }lept_context;
 
+struct lept_arena_chunk {
+    lept_arena_chunk* next;
+    size_t size, used;
+    /* 数据紧跟在块头后面 */
+};
+
+#define LEPT_ARENA_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+void lept_arena_init(lept_arena* a, size_t chunk_size) {
+    assert(a != NULL);
+    a->head = NULL;
+    a->chunk_size = chunk_size > 0 ? chunk_size : LEPT_ARENA_CHUNK_SIZE;
+}
+
+static lept_arena_chunk* lept_arena_new_chunk(size_t size) {
+    lept_arena_chunk* k = (lept_arena_chunk*)malloc(sizeof(lept_arena_chunk) + size);
+    k->next = NULL;
+    k->size = size;
+    k->used = 0;
+    return k;
+}
+
+void* lept_arena_alloc(lept_arena* a, size_t size) {
+    lept_arena_chunk* k;
+    void* ret;
+    assert(a != NULL);
+    size = LEPT_ARENA_ALIGN(size);
+    k = a->head;
+    if (k == NULL || k->used + size > k->size) {
+        if (size > a->chunk_size / 2) {
+            // 大块单独分配, 挂在当前块后面, 当前块剩余的空间继续使用
+            k = lept_arena_new_chunk(size);
+            if (a->head != NULL) {
+                k->next = a->head->next;
+                a->head->next = k;
+            } else {
+                a->head = k;
+            }
+        } else {
+            k = lept_arena_new_chunk(a->chunk_size);
+            k->next = a->head;
+            a->head = k;
+        }
+    }
+    ret = (char*)(k + 1) + k->used;
+    k->used += size;
+    return ret;
+}
+
+void lept_arena_reset(lept_arena* a) {
+    lept_arena_chunk *k, *next;
+    assert(a != NULL);
+    if (a->head == NULL)
+        return;
+    for (k = a->head->next; k != NULL; k = next) {
+        next = k->next;
+        free(k);
+    }
+    a->head->next = NULL;
+    a->head->used = 0;
+}
+
+void lept_arena_destroy(lept_arena* a) {
+    lept_arena_chunk *k, *next;
+    assert(a != NULL);
+    for (k = a->head; k != NULL; k = next) {
+        next = k->next;
+        free(k);
+    }
+    a->head = NULL;
+}
+
+static uint32_t lept_hash_key(const char* key, size_t klen); // 向前申明
+
+struct lept_key_pool_slot {
+    const char* k; // NULL 表示空槽
+    size_t klen;
+    uint32_t hash;
+};
+
+void lept_key_pool_init(lept_key_pool* p) {
+    assert(p != NULL);
+    lept_arena_init(&p->arena, 0);
+    p->slots = NULL;
+    p->size = p->capacity = 0;
+}
+
+static void lept_key_pool_grow(lept_key_pool* p) {
+    size_t i, h, capacity = p->capacity == 0 ? 64 : p->capacity * 2;
+    lept_key_pool_slot* slots = (lept_key_pool_slot*)calloc(capacity, sizeof(lept_key_pool_slot));
+    for (i = 0; i < p->capacity; i++) {
+        if (p->slots[i].k == NULL)
+            continue;
+        for (h = p->slots[i].hash & (capacity - 1); slots[h].k != NULL; h = (h + 1) & (capacity - 1))
+            ;
+        slots[h] = p->slots[i];
+    }
+    free(p->slots);
+    p->slots = slots;
+    p->capacity = capacity;
+}
+
+const char* lept_key_pool_intern(lept_key_pool* p, const char* key, size_t klen) {
+    uint32_t hash;
+    size_t h;
+    char* k;
+    assert(p != NULL && (key != NULL || klen == 0));
+    if ((p->size + 1) * 4 > p->capacity * 3) // 装载因子不超过 3/4
+        lept_key_pool_grow(p);
+    hash = lept_hash_key(key, klen);
+    for (h = hash & (p->capacity - 1); p->slots[h].k != NULL; h = (h + 1) & (p->capacity - 1)) {
+        const lept_key_pool_slot* slot = &p->slots[h];
+        if (slot->hash == hash && slot->klen == klen && memcmp(slot->k, key, klen) == 0)
+            return slot->k;
+    }
+    k = (char*)lept_arena_alloc(&p->arena, klen + 1);
+    memcpy(k, key, klen);
+    k[klen] = '\0';
+    p->slots[h].k = k;
+    p->slots[h].klen = klen;
+    p->slots[h].hash = hash;
+    p->size++;
+    return k;
+}
+
+void lept_key_pool_destroy(lept_key_pool* p) {
+    assert(p != NULL);
+    lept_arena_destroy(&p->arena);
+    free(p->slots);
+    p->slots = NULL;
+    p->size = p->capacity = 0;
+}
+
+/* 解析结果的内存: 有 arena 时从 arena 分配, 否则 malloc */
+static void* lept_context_alloc(lept_context* c, size_t size) {
+    return c->arena != NULL ? lept_arena_alloc(c->arena, size) : malloc(size);
+}
+
+static char* lept_context_strdup(lept_context* c, const char* s, size_t len) {
+    char* ret = (char*)lept_context_alloc(c, len + 1);
+    memcpy(ret, s, len);
+    ret[len] = '\0';
+    return ret;
+}
+
 
 static void* lept_context_push(lept_context* c, size_t size) {
     void* ret;
@@ -50,11 +293,59 @@ static void* lept_context_pop(lept_context* c, size_t size) {
 }
 
 
+static int lept_ctz64 (uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    for (; !(x & 1); x >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+/*
+ * 缩进的 JSON 中空白很多, 用 SIMD 每次检查 16/32 个字节
+ * 剩下不足 16/32 个字节时逐个检查, 不会读到 end 之后
+ */
 static void lept_parse_whitespace (lept_context* c) {
-    const char *p = c->json;
-    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
-        p++;
+    const char *p = c->json, *end = c->end;
+    if (p == end || !ISWHITESPACE(*p)) // 紧凑的 JSON 大多没有空白
+        return;
+    p++;
+#if defined(LEPT_AVX2)
+    while (end - p >= 32) {
+        __m256i s, x;
+        unsigned mask;
+        s = _mm256_loadu_si256((const __m256i*)p);
+        x = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(s, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\t'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\r'))));
+        mask = ~(unsigned)_mm256_movemask_epi8(x);
+        if (mask != 0) {
+            c->json = p + __builtin_ctz(mask);
+            return;
+        }
+        p += 32;
     }
+#elif defined(LEPT_SSE2)
+    while (end - p >= 16) {
+        __m128i s, x;
+        unsigned mask;
+        s = _mm_loadu_si128((const __m128i*)p);
+        x = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\t'))),
+                _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\r'))));
+        mask = (unsigned)_mm_movemask_epi8(x) ^ 0xFFFF;
+        if (mask != 0) {
+            c->json = p + __builtin_ctz(mask);
+            return;
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && ISWHITESPACE(*p))
+        p++;
     c->json = p;
 }
 
@@ -63,7 +354,7 @@ static int lept_parse_literal (lept_context* c, lept_value* v, const char* liter
     EXPECT(c, literal[0]); // c->json++
 
     for (i = 0; literal[i+1]; i++) {
-        if (c->json[i] != literal[i + 1])
+        if (AT(c->json + i, c->end) != literal[i + 1])
             return LEPT_PARSE_INVALID_VALUE;
     }
     c->json += i;
@@ -71,43 +362,568 @@ static int lept_parse_literal (lept_context* c, lept_value* v, const char* liter
     return LEPT_PARSE_OK;
 }
 
+/*
+ * 数字解析: 在检查语法的同时累积最多 19 位有效数字 w 和十进制指数 q, 值为 w * 10^q
+ * 1. w <= 2^53 且 |q| <= 22 时 w 和 10^q 都能精确表示成 double, 一次乘除即为正确舍入的结果 (Clinger)
+ * 2. 否则用 128 位的 5^q 近似值计算 (Eisel-Lemire), 有效数字不超过 19 位时结果总是正确的
+ * 3. 超过 19 位有效数字时, w 和 w + 1 的结果相同才可以确定, 否则交给 strtod
+ * 不依赖 locale, 结果和 strtod 完全相同
+ */
+#define LEPT_POW5_MIN_EXP (-342)
+#define LEPT_POW5_MAX_EXP 308
+
+/* 5^q 归一化到 128 位 (最高位为 1), q 从 -342 到 308 */
+static const uint64_t lept_pow5_128[][2] = {
+    {0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL}, {0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL},
+    {0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL}, {0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL},
+    {0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL}, {0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL},
+    {0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL}, {0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL},
+    {0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL}, {0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL},
+    {0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL}, {0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL},
+    {0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL}, {0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL},
+    {0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL}, {0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL},
+    {0x84a57695fe98746dULL, 0x014bb630f7604b57ULL}, {0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL},
+    {0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL}, {0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL},
+    {0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL}, {0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL},
+    {0xfd00b897478238d0ULL, 0x8920b098955522b4ULL}, {0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL},
+    {0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL}, {0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL},
+    {0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL}, {0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL},
+    {0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL}, {0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL},
+    {0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL}, {0xeba09271e88d976bULL, 0xf7864a44c633682eULL},
+    {0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL}, {0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL},
+    {0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL}, {0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL},
+    {0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL}, {0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL},
+    {0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL}, {0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL},
+    {0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL}, {0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL},
+    {0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL}, {0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL},
+    {0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL}, {0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL},
+    {0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL}, {0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL},
+    {0xa37fce126597973cULL, 0xe50ff107bab528a0ULL}, {0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL},
+    {0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL}, {0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL},
+    {0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL}, {0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL},
+    {0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL}, {0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL},
+    {0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL}, {0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL},
+    {0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL}, {0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL},
+    {0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL}, {0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL},
+    {0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL}, {0x91376c36d99995beULL, 0x23100809b9c21fa1ULL},
+    {0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL}, {0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL},
+    {0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL}, {0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL},
+    {0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL}, {0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL},
+    {0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL}, {0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL},
+    {0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL}, {0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL},
+    {0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL}, {0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL},
+    {0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL}, {0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL},
+    {0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL}, {0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL},
+    {0xc987434744ac874eULL, 0xa327ffb266b56220ULL}, {0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL},
+    {0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL}, {0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL},
+    {0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL}, {0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL},
+    {0xc0314325637a1939ULL, 0xfa911155fefb5308ULL}, {0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL},
+    {0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL}, {0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL},
+    {0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL}, {0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL},
+    {0xb749faed14125d36ULL, 0xcef980ec671f667bULL}, {0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL},
+    {0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL}, {0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL},
+    {0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL}, {0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL},
+    {0xaecc49914078536dULL, 0x58fae9f773886e18ULL}, {0xda7f5bf590966848ULL, 0xaf39a475506a899eULL},
+    {0x888f99797a5e012dULL, 0x6d8406c952429603ULL}, {0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL},
+    {0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL}, {0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL},
+    {0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL}, {0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL},
+    {0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL}, {0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL},
+    {0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL}, {0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL},
+    {0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL}, {0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL},
+    {0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL}, {0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL},
+    {0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL}, {0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL},
+    {0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL}, {0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL},
+    {0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL}, {0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL},
+    {0xb913179899f68584ULL, 0x28e2557b59846e3fULL}, {0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL},
+    {0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL}, {0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL},
+    {0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL}, {0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL},
+    {0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL}, {0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL},
+    {0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL}, {0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL},
+    {0xd77485cb25823ac7ULL, 0x7d633293366b828bULL}, {0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL},
+    {0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL}, {0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL},
+    {0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL}, {0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL},
+    {0xcd795be870516656ULL, 0x67902e276c921f8bULL}, {0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL},
+    {0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL}, {0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL},
+    {0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL}, {0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL},
+    {0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL}, {0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL},
+    {0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL}, {0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL},
+    {0xef340a98172aace4ULL, 0x86fb897116c87c34ULL}, {0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL},
+    {0xbae0a846d2195712ULL, 0x8974836059cca109ULL}, {0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL},
+    {0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL}, {0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL},
+    {0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL}, {0x8e938662882af53eULL, 0x547eb47b7282ee9cULL},
+    {0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL}, {0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL},
+    {0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL}, {0xae0b158b4738705eULL, 0x9624ab50b148d445ULL},
+    {0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL}, {0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL},
+    {0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL}, {0xd47487cc8470652bULL, 0x7647c3200069671fULL},
+    {0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL}, {0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL},
+    {0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL}, {0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL},
+    {0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL}, {0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL},
+    {0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL}, {0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL},
+    {0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL}, {0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL},
+    {0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL}, {0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL},
+    {0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL}, {0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL},
+    {0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL}, {0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL},
+    {0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL}, {0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL},
+    {0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL}, {0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL},
+    {0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL}, {0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL},
+    {0x8c974f7383725573ULL, 0x1e414218c73a13fbULL}, {0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL},
+    {0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL}, {0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL},
+    {0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL}, {0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL},
+    {0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL}, {0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL},
+    {0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL}, {0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL},
+    {0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL}, {0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL},
+    {0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL}, {0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL},
+    {0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL}, {0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL},
+    {0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL}, {0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL},
+    {0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL}, {0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL},
+    {0xbe89523386091465ULL, 0xf6bbb397f1135823ULL}, {0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL},
+    {0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL}, {0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL},
+    {0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL}, {0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL},
+    {0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL}, {0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL},
+    {0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL}, {0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL},
+    {0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL}, {0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL},
+    {0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL}, {0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL},
+    {0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL}, {0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL},
+    {0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL}, {0x843610cb4bf160cbULL, 0xcedf722a585139baULL},
+    {0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL}, {0xce947a3da6a9273eULL, 0x733d226229feea32ULL},
+    {0x811ccc668829b887ULL, 0x0806357d5a3f525fULL}, {0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL},
+    {0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL}, {0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL},
+    {0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL}, {0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL},
+    {0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL}, {0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL},
+    {0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL}, {0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL},
+    {0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL}, {0xbbe226efb628afeaULL, 0x890489f70a55368bULL},
+    {0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL}, {0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL},
+    {0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL}, {0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL},
+    {0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL}, {0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL},
+    {0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL}, {0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL},
+    {0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL}, {0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL},
+    {0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL}, {0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL},
+    {0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL}, {0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL},
+    {0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL}, {0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL},
+    {0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL}, {0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL},
+    {0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL}, {0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL},
+    {0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL}, {0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL},
+    {0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL}, {0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL},
+    {0xc24452da229b021bULL, 0xfbe85badce996168ULL}, {0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL},
+    {0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL}, {0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL},
+    {0xed246723473e3813ULL, 0x290123e9aab23b68ULL}, {0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL},
+    {0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL}, {0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL},
+    {0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL}, {0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL},
+    {0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL}, {0x8d590723948a535fULL, 0x579c487e5a38ad0eULL},
+    {0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL}, {0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL},
+    {0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL}, {0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL},
+    {0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL}, {0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL},
+    {0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL}, {0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL},
+    {0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL}, {0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL},
+    {0xcdb02555653131b6ULL, 0x3792f412cb06794dULL}, {0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL},
+    {0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL}, {0xc8de047564d20a8bULL, 0xf245825a5a445275ULL},
+    {0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL}, {0x9ced737bb6c4183dULL, 0x55464dd69685606bULL},
+    {0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL}, {0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL},
+    {0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL}, {0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL},
+    {0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL}, {0x95a8637627989aadULL, 0xdde7001379a44aa8ULL},
+    {0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL}, {0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL},
+    {0x9226712162ab070dULL, 0xcab3961304ca70e8ULL}, {0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL},
+    {0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL}, {0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL},
+    {0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL}, {0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL},
+    {0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL}, {0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL},
+    {0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL}, {0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL},
+    {0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL}, {0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL},
+    {0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL}, {0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL},
+    {0xcfb11ead453994baULL, 0x67de18eda5814af2ULL}, {0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL},
+    {0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL}, {0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL},
+    {0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL}, {0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL},
+    {0xc612062576589ddaULL, 0x95364afe032a819eULL}, {0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL},
+    {0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL}, {0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL},
+    {0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL}, {0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL},
+    {0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL}, {0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL},
+    {0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL}, {0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL},
+    {0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL}, {0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL},
+    {0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL}, {0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL},
+    {0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL}, {0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL},
+    {0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL}, {0x89705f4136b4a597ULL, 0x31680a88f8953031ULL},
+    {0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL}, {0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL},
+    {0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL}, {0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL},
+    {0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL}, {0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL},
+    {0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL}, {0xccccccccccccccccULL, 0xcccccccccccccccdULL},
+    {0x8000000000000000ULL, 0x0000000000000000ULL}, {0xa000000000000000ULL, 0x0000000000000000ULL},
+    {0xc800000000000000ULL, 0x0000000000000000ULL}, {0xfa00000000000000ULL, 0x0000000000000000ULL},
+    {0x9c40000000000000ULL, 0x0000000000000000ULL}, {0xc350000000000000ULL, 0x0000000000000000ULL},
+    {0xf424000000000000ULL, 0x0000000000000000ULL}, {0x9896800000000000ULL, 0x0000000000000000ULL},
+    {0xbebc200000000000ULL, 0x0000000000000000ULL}, {0xee6b280000000000ULL, 0x0000000000000000ULL},
+    {0x9502f90000000000ULL, 0x0000000000000000ULL}, {0xba43b74000000000ULL, 0x0000000000000000ULL},
+    {0xe8d4a51000000000ULL, 0x0000000000000000ULL}, {0x9184e72a00000000ULL, 0x0000000000000000ULL},
+    {0xb5e620f480000000ULL, 0x0000000000000000ULL}, {0xe35fa931a0000000ULL, 0x0000000000000000ULL},
+    {0x8e1bc9bf04000000ULL, 0x0000000000000000ULL}, {0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL},
+    {0xde0b6b3a76400000ULL, 0x0000000000000000ULL}, {0x8ac7230489e80000ULL, 0x0000000000000000ULL},
+    {0xad78ebc5ac620000ULL, 0x0000000000000000ULL}, {0xd8d726b7177a8000ULL, 0x0000000000000000ULL},
+    {0x878678326eac9000ULL, 0x0000000000000000ULL}, {0xa968163f0a57b400ULL, 0x0000000000000000ULL},
+    {0xd3c21bcecceda100ULL, 0x0000000000000000ULL}, {0x84595161401484a0ULL, 0x0000000000000000ULL},
+    {0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL}, {0xcecb8f27f4200f3aULL, 0x0000000000000000ULL},
+    {0x813f3978f8940984ULL, 0x4000000000000000ULL}, {0xa18f07d736b90be5ULL, 0x5000000000000000ULL},
+    {0xc9f2c9cd04674edeULL, 0xa400000000000000ULL}, {0xfc6f7c4045812296ULL, 0x4d00000000000000ULL},
+    {0x9dc5ada82b70b59dULL, 0xf020000000000000ULL}, {0xc5371912364ce305ULL, 0x6c28000000000000ULL},
+    {0xf684df56c3e01bc6ULL, 0xc732000000000000ULL}, {0x9a130b963a6c115cULL, 0x3c7f400000000000ULL},
+    {0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL}, {0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL},
+    {0x96769950b50d88f4ULL, 0x1314448000000000ULL}, {0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL},
+    {0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL}, {0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL},
+    {0xb7abc627050305adULL, 0xf14a3d9e40000000ULL}, {0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL},
+    {0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL}, {0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL},
+    {0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL}, {0x8c213d9da502de45ULL, 0x4526f422cc340000ULL},
+    {0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL}, {0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL},
+    {0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL}, {0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL},
+    {0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL}, {0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL},
+    {0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL}, {0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL},
+    {0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL}, {0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL},
+    {0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL}, {0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL},
+    {0x9f4f2726179a2245ULL, 0x01d762422c946590ULL}, {0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL},
+    {0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL}, {0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL},
+    {0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL}, {0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL},
+    {0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL}, {0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL},
+    {0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL}, {0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL},
+    {0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL}, {0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL},
+    {0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL}, {0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL},
+    {0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL}, {0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL},
+    {0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL}, {0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL},
+    {0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL}, {0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL},
+    {0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL}, {0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL},
+    {0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL}, {0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL},
+    {0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL}, {0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL},
+    {0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL}, {0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL},
+    {0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL}, {0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL},
+    {0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL}, {0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL},
+    {0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL}, {0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL},
+    {0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL}, {0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL},
+    {0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL}, {0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL},
+    {0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL}, {0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL},
+    {0x924d692ca61be758ULL, 0x593c2626705f9c56ULL}, {0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL},
+    {0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL}, {0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL},
+    {0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL}, {0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL},
+    {0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL}, {0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL},
+    {0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL}, {0x884134fe908658b2ULL, 0x3109058d147fdcddULL},
+    {0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL}, {0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL},
+    {0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL}, {0xa6539930bf6bff45ULL, 0x84db8346b786151cULL},
+    {0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL}, {0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL},
+    {0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL}, {0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL},
+    {0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL}, {0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL},
+    {0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL}, {0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL},
+    {0x9ae757596946075fULL, 0x3375788de9b06958ULL}, {0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL},
+    {0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL}, {0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL},
+    {0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL}, {0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL},
+    {0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL}, {0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL},
+    {0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL}, {0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL},
+    {0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL}, {0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL},
+    {0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL}, {0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL},
+    {0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL}, {0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL},
+    {0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL}, {0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL},
+    {0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL}, {0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL},
+    {0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL}, {0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL},
+    {0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL}, {0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL},
+    {0x802221226be55a64ULL, 0xc2494954da2c9789ULL}, {0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL},
+    {0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL}, {0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL},
+    {0x9c69a97284b578d7ULL, 0xff2a760414536efbULL}, {0xc38413cf25e2d70dULL, 0xfef5138519684abaULL},
+    {0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL}, {0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL},
+    {0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL}, {0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL},
+    {0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL}, {0xba756174393d88dfULL, 0x94f971119aeef9e4ULL},
+    {0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL}, {0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL},
+    {0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL}, {0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL},
+    {0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL}, {0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL},
+    {0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL}, {0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL},
+    {0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL}, {0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL},
+    {0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL}, {0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL},
+    {0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL}, {0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL},
+    {0xa59bc234db398c25ULL, 0x43fab9837e699095ULL}, {0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL},
+    {0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL}, {0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL},
+    {0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL}, {0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL},
+    {0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL}, {0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL},
+    {0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL}, {0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL},
+    {0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL}, {0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL},
+    {0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL}, {0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL},
+    {0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL}, {0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL},
+    {0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL}, {0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL},
+    {0x8fa475791a569d10ULL, 0xf96e017d694487bcULL}, {0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL},
+    {0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL}, {0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL},
+    {0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL}, {0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL},
+    {0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL}, {0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL},
+    {0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL}, {0x85c7056562757456ULL, 0xf6872d5667844e49ULL},
+    {0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL}, {0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL},
+    {0x82a45b450226b39cULL, 0xecc0024661173473ULL}, {0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL},
+    {0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL}, {0xff290242c83396ceULL, 0x7e67047175a15271ULL},
+    {0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL}, {0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL},
+    {0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL}, {0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL},
+    {0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL}, {0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL},
+    {0x98165af37b2153deULL, 0xc3727a337a8b704aULL}, {0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL},
+    {0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL}, {0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL},
+    {0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL}, {0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL},
+    {0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL}, {0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL},
+    {0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL}, {0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL},
+    {0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL}, {0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL},
+    {0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL}, {0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL},
+    {0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL}, {0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL},
+    {0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL}, {0xd31045a8341ca07cULL, 0x1ede48111209a050ULL},
+    {0x83ea2b892091e44dULL, 0x934aed0aab460432ULL}, {0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL},
+    {0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL}, {0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL},
+    {0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL}, {0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL},
+    {0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL}, {0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL},
+    {0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL}, {0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL},
+    {0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL}, {0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL},
+    {0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL}, {0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL},
+    {0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL}, {0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL},
+    {0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL}, {0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL},
+    {0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL}, {0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL},
+    {0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL}, {0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL},
+    {0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL}, {0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL},
+    {0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL}, {0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL},
+    {0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL}, {0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL},
+    {0x8533285c936b35deULL, 0xd53a88958f87275fULL}, {0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL},
+    {0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL}, {0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL},
+    {0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL}, {0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL},
+    {0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL}, {0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL},
+    {0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL}, {0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL},
+    {0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL}, {0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL},
+    {0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL}, {0x976e41088617ca01ULL, 0xd5be0503e085d813ULL},
+    {0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL}, {0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL},
+    {0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL}, {0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL},
+    {0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL}, {0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL},
+    {0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL}, {0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL},
+    {0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL}, {0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL},
+    {0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL}, {0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL},
+    {0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL}, {0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL},
+    {0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL}, {0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL},
+    {0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL}, {0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL},
+    {0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL}, {0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL},
+    {0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL}, {0xa0555e361951c366ULL, 0xd7e105bcc332621fULL},
+    {0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL}, {0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL},
+    {0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL}, {0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL},
+    {0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL}, {0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL},
+    {0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL}, {0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL},
+    {0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL}, {0xbaa718e68396cffdULL, 0xd30560258f54e6baULL},
+    {0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL}, {0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL},
+    {0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL}, {0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL},
+    {0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL},
+};
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define LEPT_CLINGER
+static const double lept_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#endif
+
+/* 64 x 64 -> 128 位乘法, 返回低 64 位, 高 64 位写入 hi */
+static uint64_t lept_mul128 (uint64_t a, uint64_t b, uint64_t* hi) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = (unsigned __int128)a * b;
+    *hi = (uint64_t)(r >> 64);
+    return (uint64_t)r;
+#else
+    uint64_t al = a & 0xFFFFFFFF, ah = a >> 32, bl = b & 0xFFFFFFFF, bh = b >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (ll & 0xFFFFFFFF);
+#endif
+}
+
+static int lept_clz64 (uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    for (; !(x & 0x8000000000000000ULL); x <<= 1)
+        n++;
+    return n;
+#endif
+}
+
+/* 计算 w * 10^q (w != 0) 最接近的 double 的位模式 (不含符号位) */
+static uint64_t lept_eisel_lemire (uint64_t w, long q) {
+    uint64_t lo, hi, lo2, hi2, mantissa;
+    int lz, upperbit, shift;
+    long power2;
+    const uint64_t* t;
+    if (q < LEPT_POW5_MIN_EXP)
+        return 0;
+    if (q > LEPT_POW5_MAX_EXP)
+        return 0x7FF0000000000000ULL; // inf
+    lz = lept_clz64(w);
+    w <<= lz;
+    t = lept_pow5_128[q - LEPT_POW5_MIN_EXP];
+    lo = lept_mul128(w, t[0], &hi);
+    if ((hi & 0x1FF) == 0x1FF) { // 只用高 64 位不能确定舍入, 再乘上低 64 位
+        lept_mul128(w, t[1], &hi2);
+        lo2 = lo + hi2;
+        if (lo2 < lo)
+            hi++;
+        lo = lo2;
+    }
+    upperbit = (int)(hi >> 63);
+    shift = upperbit + 64 - 52 - 3;
+    mantissa = hi >> shift;
+    /* ((152170 + 65536) * q) >> 16 即 floor(q * log2(10)) */
+    power2 = ((((152170 + 65536) * q) >> 16) + 63) + upperbit - lz + 1023;
+    if (power2 <= 0) { // 非规格化数
+        if (-power2 + 1 >= 64)
+            return 0;
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        /* 舍入之后可能变成最小的规格化数 */
+        return mantissa < (1ULL << 52) ? mantissa : (1ULL << 52);
+    }
+    /* 恰好在两个 double 中间时向偶数舍入, 只有 q 在 [-4, 23] 时才可能 */
+    if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi)
+        mantissa &= ~1ULL;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ULL << 52)) {
+        mantissa = 1ULL << 52;
+        power2++;
+    }
+    mantissa &= ~(1ULL << 52);
+    if (power2 >= 0x7FF)
+        return 0x7FF0000000000000ULL; // inf
+    return mantissa | ((uint64_t)power2 << 52);
+}
+
+/* 有效数字超过 19 位且不能确定舍入时使用 strtod
+ * 去掉小数点, 写成 "整数e指数" 的形式, 这样不受 locale 的小数点影响.
+ * 确定 double 的舍入最多需要 769 位有效数字, 之后的数字只影响是否为 0, 用一个 '1' 代替,
+ * 所以用固定大小的缓冲区, 不分配内存 */
+#define LEPT_STRTOD_DIGITS 800
+static double lept_strtod_exact (const char* p, const char* end, long exp) {
+    char buf[LEPT_STRTOD_DIGITS + 32];
+    size_t n = 0;
+    int in_frac = 0, sticky = 0;
+    for (; p < end && *p != 'e' && *p != 'E'; p++) {
+        if (*p == '.')
+            in_frac = 1;
+        else if (ISDIGIT(*p)) {
+            if (n == 0 && *p == '0') // 前导的 0
+                exp -= in_frac;
+            else if (n < LEPT_STRTOD_DIGITS) {
+                buf[n++] = *p;
+                exp -= in_frac;
+            } else {
+                sticky |= *p != '0';
+                exp += !in_frac;
+            }
+        }
+    }
+    if (sticky) {
+        buf[n++] = '1';
+        exp--;
+    }
+    sprintf(buf + n, "e%ld", exp);
+    return strtod(buf, NULL);
+}
+
 static int lept_parse_number (lept_context* c, lept_value* v) {
-    const char* p = c->json;
+    const char *p = c->json, *end = c->end;
+    uint64_t w = 0, bits;
+    int neg = 0, nd = 0, truncated = 0, exp_neg = 0;
+    long q = 0, exp = 0;
+    double d;
+    char ch;
 
-    if (*p == '-') p++; // 如果是- 号跳过
-    if (*p == '0') p++; // 如果是单值 0 跳过
+    if (AT(p, end) == '-') { neg = 1; p++; } // 如果是- 号跳过
+    if (AT(p, end) == '0') p++; // 如果是单值 0 跳过
     else {
         // 如果是以0开头的数字则非法
-        if (!ISDIG1TO9(*p)) return LEPT_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++); // 遍历剩下的字符是不是数字
+        if (!ISDIG1TO9(AT(p, end))) return LEPT_PARSE_INVALID_VALUE;
+        for (; p < end && ISDIGIT(*p); p++) { // 遍历剩下的字符是不是数字
+            if (nd < 19) {
+                w = w * 10 + (*p - '0');
+                nd++;
+            } else {
+                truncated |= *p != '0';
+                q++;
+            }
+        }
+    }
+    /* 没有小数和指数部分, 并且能用 64 位整数表示时直接保存整数, 不转换成 double ("-0" 除外) */
+    ch = AT(p, end);
+    if (ch != '.' && ch != 'e' && ch != 'E' && !(neg && w == 0)) {
+        if (q == 1 && (w < 1844674407370955161ULL || (w == 1844674407370955161ULL && p[-1] <= '5'))) {
+            w = w * 10 + (p[-1] - '0'); // 第 20 位, 不超过 UINT64_MAX
+            q = 0;
+        }
+        if (q == 0 && (!neg || w <= 0x8000000000000000ULL)) {
+            if (neg) {
+                v->i = w == 0x8000000000000000ULL ? INT64_MIN : -(int64_t)w;
+                v->flags = LEPT_FLAG_INT64;
+            } else if (w <= INT64_MAX) {
+                v->i = (int64_t)w;
+                v->flags = LEPT_FLAG_INT64;
+            } else {
+                v->u = w;
+                v->flags = LEPT_FLAG_UINT64;
+            }
+            c->json = p;
+            v->type = LEPT_NUMBER;
+            return LEPT_PARSE_OK;
+        }
     }
-    if (*p == '.') { // 遇到小数点跳过, 但是小数点后面必须跟数字
+    if (ch == '.') { // 遇到小数点跳过, 但是小数点后面必须跟数字
         p++;
-        if (!ISDIGIT(*p)) return LEPT_PARSE_INVALID_VALUE; // 如果不是数字非法
-        for (p++; ISDIGIT(*p); p++);
+        if (!ISDIGIT(AT(p, end))) return LEPT_PARSE_INVALID_VALUE; // 如果不是数字非法
+        for (; p < end && ISDIGIT(*p); p++) {
+            if (nd < 19) {
+                w = w * 10 + (*p - '0');
+                nd += w != 0; // 前导的 0 不算有效数字
+                q--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
     }
 
-    if (*p == 'E' || *p == 'e') {
+    if ((ch = AT(p, end)) == 'E' || ch == 'e') {
         p++;
-        if (*p == '+' || *p == '-') p++;
-        for (p++; ISDIGIT(*p); p++);
+        if ((ch = AT(p, end)) == '+' || ch == '-') {
+            exp_neg = ch == '-';
+            p++;
+        }
+        if (!ISDIGIT(AT(p, end))) return LEPT_PARSE_INVALID_VALUE;
+        for (; p < end && ISDIGIT(*p); p++) {
+            if (exp < 100000) // 再大结果也是 0 或 inf
+                exp = exp * 10 + (*p - '0');
+        }
+        q += exp_neg ? -exp : exp;
+    }
+
+    if (w == 0) {
+        d = 0.0;
+    } else {
+#if defined(LEPT_CLINGER)
+        if (!truncated && w <= (1ULL << 53) && q >= -22 && q <= 22)
+            d = q < 0 ? (double)w / lept_pow10[-q] : (double)w * lept_pow10[q];
+        else
+#endif
+        {
+            bits = lept_eisel_lemire(w, q);
+            if (truncated && bits != lept_eisel_lemire(w + 1, q))
+                d = lept_strtod_exact(c->json, p, exp_neg ? -exp : exp);
+            else
+                memcpy(&d, &bits, sizeof(d));
+        }
     }
-    errno = 0;
-    v->n = strtod(c->json, NULL);
-    if (errno == ERANGE && (v->n == HUGE_VAL || v->n == -HUGE_VAL)) {
+    if (d == HUGE_VAL) {
         return LEPT_PARSE_NUMBER_TOO_BIG;
     }
+    v->n = neg ? -d : d;
     c->json = p;
     v->type = LEPT_NUMBER;
     return LEPT_PARSE_OK;
 }
 
 
-static const char* lept_parse_hex4(const char* p, unsigned* u) {
+static const char* lept_parse_hex4(const char* p, const char* end, unsigned* u) {
     int i;
     *u = 0;
     for (i = 0; i < 4; ++i) {
-        char ch = *p++;
+        char ch = AT(p, end);
+        p++;
         *u <<= 4;
         if (ch >= '0' && ch <= '9') *u |= ch - '0';
         else if (ch >= 'a' && ch <= 'f') *u |= ch - ('a' - 10);
@@ -117,23 +933,68 @@ static const char* lept_parse_hex4(const char* p, unsigned* u) {
     return p;
 }
 
-static void lept_encode_utf8 (lept_context* c, unsigned u) {
+/* 把码点 u 编码成 UTF-8 写入 w, 返回写入后的位置 */
+static char* lept_encode_utf8 (char* w, unsigned u) {
     if (u <= 0x7F) {
-        PUTC(c, u & 0xFF);
+        *w++ = u & 0xFF;
     } else if (u <= 0x7FF){
-        PUTC(c, 0xC0 | ((u >> 6) & 0xFF ));
-        PUTC(c, 0x80 | ( u & 0x3F));
+        *w++ = 0xC0 | ((u >> 6) & 0xFF );
+        *w++ = 0x80 | ( u & 0x3F);
     } else if (u <= 0xFFFF) {
-        PUTC(c, 0xE0 | ((u >> 12) & 0xFF));
-        PUTC(c, 0x80 | ((u >> 6) & 0x3F));
-        PUTC(c, 0x80 | (u  & 0x3F));
+        *w++ = 0xE0 | ((u >> 12) & 0xFF);
+        *w++ = 0x80 | ((u >> 6) & 0x3F);
+        *w++ = 0x80 | (u  & 0x3F);
     } else {
         assert(u <= 0x10FFFF);
-        PUTC(c, 0xF0 | ((u >> 18) & 0xFF));
-        PUTC(c, 0x80 | ((u >> 12) & 0x3F));
-        PUTC(c, 0x80 | ((u >> 6) & 0x3F));
-        PUTC(c, 0x80 | (u  & 0x3F));
+        *w++ = 0xF0 | ((u >> 18) & 0xFF);
+        *w++ = 0x80 | ((u >> 12) & 0x3F);
+        *w++ = 0x80 | ((u >> 6) & 0x3F);
+        *w++ = 0x80 | (u  & 0x3F);
     }
+    return w;
+}
+
+/* 解析 '\\' 后面的转义序列, 解码结果写入 w (最多 4 字节)
+ * 成功返回写入的字节数, 失败返回负的错误码
+ * 解码后的长度不会超过转义序列本身的长度, 所以 w 可以指向正在解析的输入 (insitu) */
+static int lept_parse_escape (const char** pp, const char* end, char* w) {
+    const char* p = *pp;
+    unsigned u, u2;
+    char ch = AT(p, end);
+    p++;
+    switch (ch) {
+        case '\"': *w = '\"'; break;
+        case '\\': *w = '\\'; break;
+        case '/':  *w = '/' ; break;
+        case 'b':  *w = '\b'; break;
+        case 'f':  *w = '\f'; break;
+        case 'n':  *w = '\n'; break;
+        case 'r':  *w = '\r'; break;
+        case 't':  *w = '\t'; break;
+        case 'u':
+            if (!(p = lept_parse_hex4(p, end, &u))) { // 解析4位16进制数字 \u2020
+                return -LEPT_PARSE_INVALID_UNICODE_HEX; // 解析失败返回解析错误
+            }
+            // 高代理  U+D800 至 U+DBFF     低代理 U+DC00 至 U+DFFF
+            // 检查是否存在低代理 || 低代理不在合法码点范围
+            // 计算码点
+            if (u >= 0xD800 && u <= 0xDBFF) {
+                if (AT(p, end) != '\\' || AT(p + 1, end) != 'u') {
+                    return -LEPT_PARSE_INVALID_UNICODE_SURROGATE;
+                }
+                if (!(p = lept_parse_hex4(p + 2, end, &u2)))
+                    return -LEPT_PARSE_INVALID_UNICODE_HEX;
+                if (u2 < 0xDC00 || u2 > 0xDFFF)
+                    return -LEPT_PARSE_INVALID_UNICODE_SURROGATE;
+                u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
+            }
+            *pp = p;
+            return (int)(lept_encode_utf8(w, u) - w);
+        default:
+            return -LEPT_PARSE_INVALID_STRING_ESCAPE;
+    }
+    *pp = p;
+    return 1;
 }
 
 #define STRING_ERROR(ret) do { c->top = head; return ret; } while(0)
@@ -199,52 +1060,195 @@ static void lept_encode_utf8 (lept_context* c, unsigned u) {
 //    }
 //}
 
+/*
+ * 返回从 p 开始第一个需要单独处理的字节: '"', '\\' 或控制字符 (包括 '\0'), 都没有时返回 end
+ * 中间的字节原样复制即可, SIMD 每次检查 16/32 个字节
+ */
+static const char* lept_scan_string (const char* p, const char* end) {
+#if defined(LEPT_AVX2)
+    while (end - p >= 32) {
+        __m256i s, x;
+        unsigned mask;
+        s = _mm256_loadu_si256((const __m256i*)p);
+        x = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('\"')), _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'))),
+                _mm256_cmpeq_epi8(_mm256_min_epu8(s, _mm256_set1_epi8(0x1F)), s)); // s <= 0x1F
+        mask = (unsigned)_mm256_movemask_epi8(x);
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#elif defined(LEPT_SSE2)
+    while (end - p >= 16) {
+        __m128i s, x;
+        unsigned mask;
+        s = _mm_loadu_si128((const __m128i*)p);
+        x = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\\'))),
+                _mm_cmpeq_epi8(_mm_min_epu8(s, _mm_set1_epi8(0x1F)), s)); // s <= 0x1F
+        mask = (unsigned)_mm_movemask_epi8(x);
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    /* 最后的几个字节或没有 SIMD 时逐个检查 */
+    while (p < end && *p != '\"' && *p != '\\' && (unsigned char)*p >= 0x20)
+        p++;
+    return p;
+}
+
+/* 返回 p 开始的一个合法 UTF-8 字符之后的位置, 不合法时返回 NULL */
+static const char* lept_utf8_next (const char* p, const char* end) {
+    unsigned char ch = (unsigned char)*p, lo = 0x80, hi = 0xBF;
+    int i, n;
+    if (ch < 0x80)
+        return p + 1;
+    if (ch < 0xC2) // 单独的后续字节, 或者过长的 2 字节编码
+        return NULL;
+    if (ch < 0xE0)
+        n = 1;
+    else if (ch < 0xF0) {
+        n = 2;
+        if (ch == 0xE0) lo = 0xA0; // 过长编码
+        else if (ch == 0xED) hi = 0x9F; // 代理项 U+D800 ~ U+DFFF
+    } else if (ch < 0xF5) {
+        n = 3;
+        if (ch == 0xF0) lo = 0x90; // 过长编码
+        else if (ch == 0xF4) hi = 0x8F; // 超过 U+10FFFF
+    } else
+        return NULL;
+    if (end - p <= n)
+        return NULL;
+    ch = (unsigned char)p[1];
+    if (ch < lo || ch > hi)
+        return NULL;
+    for (i = 2; i <= n; i++)
+        if ((p[i] & 0xC0) != 0x80)
+            return NULL;
+    return p + n + 1;
+}
+
+#if defined(LEPT_AVX2)
+/*
+ * Keiser & Lemire 的查表法: 每个字节和它前面的 1 个字节的高/低 4 位各查一张表, 三个结果相与后
+ * 不为 0 的位就是错误 (过短、过长、过长编码、超出范围、代理项); 3/4 字节编码的第 3/4 个字节单独检查.
+ * 只处理完整的 32 字节块, 返回最后一个可能没有结束的字符的开始位置, 出错时返回 NULL
+ */
+static const char* lept_utf8_avx2 (const char* p, const char* end) {
+    const char* start = p;
+    const __m256i b1h = _mm256_setr_epi8(
+        0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, (char)0x80, (char)0x80, (char)0x80, (char)0x80, 0x21, 0x01, 0x15, 0x49,
+        0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, (char)0x80, (char)0x80, (char)0x80, (char)0x80, 0x21, 0x01, 0x15, 0x49);
+    const __m256i b1l = _mm256_setr_epi8(
+        (char)0xE7, (char)0xA3, (char)0x83, (char)0x83, (char)0x8B, (char)0xCB, (char)0xCB, (char)0xCB,
+        (char)0xCB, (char)0xCB, (char)0xCB, (char)0xCB, (char)0xCB, (char)0xDB, (char)0xCB, (char)0xCB,
+        (char)0xE7, (char)0xA3, (char)0x83, (char)0x83, (char)0x8B, (char)0xCB, (char)0xCB, (char)0xCB,
+        (char)0xCB, (char)0xCB, (char)0xCB, (char)0xCB, (char)0xCB, (char)0xDB, (char)0xCB, (char)0xCB);
+    const __m256i b2h = _mm256_setr_epi8(
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, (char)0xE6, (char)0xAE, (char)0xBA, (char)0xBA, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, (char)0xE6, (char)0xAE, (char)0xBA, (char)0xBA, 0x01, 0x01, 0x01, 0x01);
+    /* 块的最后 3 个字节中不能有还没结束的字符的开始 */
+    const __m256i last = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)0xEF, (char)0xDF, (char)0xBF);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i prev = _mm256_setzero_si256(), incomplete = prev, err = prev;
+    for (; end - p >= 32; p += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)p);
+        if (_mm256_movemask_epi8(s) == 0) // 全是 ASCII, 只需要上一块已经结束
+            err = _mm256_or_si256(err, incomplete);
+        else {
+            __m256i t = _mm256_permute2x128_si256(prev, s, 0x21); // 上一块的后 16 字节和这一块的前 16 字节
+            __m256i prev1 = _mm256_alignr_epi8(s, t, 15);
+            __m256i sc = _mm256_and_si256(_mm256_and_si256(
+                    _mm256_shuffle_epi8(b1h, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                    _mm256_shuffle_epi8(b1l, _mm256_and_si256(prev1, nibble))),
+                    _mm256_shuffle_epi8(b2h, _mm256_and_si256(_mm256_srli_epi16(s, 4), nibble)));
+            /* 前 2 个字节不小于 0xE0 或前 3 个字节不小于 0xF0 时, 这个字节必须是后续字节 */
+            __m256i must23 = _mm256_or_si256(
+                    _mm256_subs_epu8(_mm256_alignr_epi8(s, t, 14), _mm256_set1_epi8(0xE0 - 0x80)),
+                    _mm256_subs_epu8(_mm256_alignr_epi8(s, t, 13), _mm256_set1_epi8(0xF0 - 0x80)));
+            err = _mm256_or_si256(err, _mm256_xor_si256(_mm256_and_si256(must23, _mm256_set1_epi8((char)0x80)), sc));
+        }
+        incomplete = _mm256_subs_epu8(s, last);
+        prev = s;
+    }
+    if (!_mm256_testz_si256(err, err))
+        return NULL;
+    /* 退回到最后一个字符的开始, 交给逐个字符的检查 */
+    if (p > start && (unsigned char)p[-1] >= 0x80) {
+        int i;
+        for (i = 0; i < 3 && p > start && (p[-1] & 0xC0) == 0x80; i++)
+            p--;
+        if (p > start && (unsigned char)p[-1] >= 0xC0)
+            p--;
+    }
+    return p;
+}
+#endif
+
+/*
+ * [p, p + n) 是否为合法的 UTF-8. 字符串中的 '"' 和 '\\' 不会出现在多字节字符中间,
+ * 所以 lept_scan_string 分出的每一段可以单独检查. 大多是 ASCII, 先按块跳过
+ */
+static int lept_utf8_valid (const char* p, size_t n) {
+    const char* end = p + n;
+#if defined(LEPT_AVX2)
+    if (n >= 32 && (p = lept_utf8_avx2(p, end)) == NULL)
+        return 0;
+#endif
+    while (p < end) {
+        uint64_t w;
+#if defined(LEPT_SSE2)
+        if (end - p >= 16 && _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p)) == 0) {
+            p += 16;
+            continue;
+        }
+#endif
+        if (end - p >= 8) {
+            memcpy(&w, p, 8);
+            if ((w & 0x8080808080808080ULL) == 0) {
+                p += 8;
+                continue;
+            }
+        }
+        if ((p = lept_utf8_next(p, end)) == NULL)
+            return 0;
+    }
+    return 1;
+}
+
 /* 解析 JSON 字符串，把结果写入 str 和 len */
 /* str 指向 c->stack 中的元素，需要在 c->stack  */
+static int lept_parse_string_insitu (lept_context* c, char** str, size_t* len);
 static int lept_parse_string_raw (lept_context* c, char** str, size_t* len) {
     size_t head = c->top;
-    unsigned u, u2;
+    char buf[4];
+    int n;
     const char* p;
+    if (c->insitu)
+        return lept_parse_string_insitu(c, str, len);
     EXPECT(c, '\"');
     p = c->json;
     for (;;) {
-        char ch =  *p++;
+        const char* q = lept_scan_string(p, c->end);
+        char ch;
+        if (q != p) { // 一次复制不需要转义的整段
+#if defined(LEPT_CHECK_UTF8)
+            if (!lept_utf8_valid(p, q - p))
+                STRING_ERROR(LEPT_PARSE_INVALID_UTF8);
+#endif
+            PUTS(c, p, q - p);
+            p = q;
+        }
+        ch = AT(p, c->end);
+        p++;
         switch (ch) {
             case '\\':
-                switch (*p++) {
-                    case '\"': PUTC(c, '\"'); break;
-                    case '\\': PUTC(c, '\\'); break;
-                    case '/':  PUTC(c, '/' ); break;
-                    case 'b':  PUTC(c, '\b'); break;
-                    case 'f':  PUTC(c, '\f'); break;
-                    case 'n':  PUTC(c, '\n'); break;
-                    case 'r':  PUTC(c, '\r'); break;
-                    case 't':  PUTC(c, '\t'); break;
-                    case 'u':
-                        if (!(p = lept_parse_hex4(p, &u))) { // 解析4位16进制数字 \u2020
-                            STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_HEX); // 解析失败返回解析错误
-                        }
-                        // 高代理  U+D800 至 U+DBFF     低代理 U+DC00 至 U+DFFF
-                        // 检查是否存在低代理 || 低代理不在合法码点范围
-                        // 计算码点
-                        if (u >= 0xD800 && u <= 0xDBFF) {
-                            if (*p++ != '\\') {
-                                STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
-                            }
-                            if (*p++ != 'u') {
-                                STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
-                            }
-                            if (!(p = lept_parse_hex4(p, &u2)))
-                                STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_HEX);
-                            if (u2 < 0xDC00 || u2 > 0xDFFF)
-                                STRING_ERROR(LEPT_PARSE_INVALID_UNICODE_SURROGATE);
-                            u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
-                        }
-                        lept_encode_utf8(c, u); // 写入缓冲区
-                        break;
-                    default:
-                        STRING_ERROR(LEPT_PARSE_INVALID_STRING_ESCAPE);
-                }
+                if ((n = lept_parse_escape(&p, c->end, buf)) < 0)
+                    STRING_ERROR(-n);
+                PUTS(c, buf, n); // 写入缓冲区
                 break;
             case '\"':
                 *len = c->top - head;
@@ -253,12 +1257,53 @@ static int lept_parse_string_raw (lept_context* c, char** str, size_t* len) {
                 c->json = p;
                 return LEPT_PARSE_OK;
             case '\0':
-                STRING_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK);
+                if (p > c->end) // 读到了 end, 而不是输入中的 '\0'
+                    STRING_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK);
+                /* fall through */
             default:
-                if ((unsigned char)ch < 0x20) {
-                    STRING_ERROR(LEPT_PARSE_INVALID_STRING_CHAR);
-                }
-                PUTC(c, ch);
+                assert((unsigned char)ch < 0x20);
+                STRING_ERROR(LEPT_PARSE_INVALID_STRING_CHAR);
+        }
+    }
+}
+
+/* 在输入中原地解码字符串, str 指向输入中的位置, 并以 '\0' 结尾 */
+static int lept_parse_string_insitu (lept_context* c, char** str, size_t* len) {
+    char *p, *w;
+    int n;
+    EXPECT(c, '\"');
+    p = w = *str = (char*)c->json; // insitu 模式下输入是可写的
+    for (;;) {
+        char* q = (char*)lept_scan_string(p, c->end);
+        char ch;
+#if defined(LEPT_CHECK_UTF8)
+        if (!lept_utf8_valid(p, q - p))
+            return LEPT_PARSE_INVALID_UTF8;
+#endif
+        if (w != p) // 遇到过转义, 后面的字节要往前移
+            memmove(w, p, q - p);
+        w += q - p;
+        p = q;
+        ch = AT(p, c->end);
+        p++;
+        switch (ch) {
+            case '\\':
+                if ((n = lept_parse_escape((const char**)&p, c->end, w)) < 0)
+                    return -n;
+                w += n;
+                break;
+            case '\"':
+                *len = w - *str;
+                *w = '\0'; // w 最多到结尾的引号处
+                c->json = p;
+                return LEPT_PARSE_OK;
+            case '\0':
+                if (p > c->end)
+                    return LEPT_PARSE_MISS_QUOTATION_MARK;
+                /* fall through */
+            default:
+                assert((unsigned char)ch < 0x20);
+                return LEPT_PARSE_INVALID_STRING_CHAR;
         }
     }
 }
@@ -268,19 +1313,48 @@ static int lept_parse_string (lept_context* c, lept_value* v) {
     char* s;
     size_t  len;
     if ( (ret = lept_parse_string_raw(c, &s, &len)) == LEPT_PARSE_OK) {
-        lept_set_string(v, s, len);
+        if (len > LEPT_MAX_STRING_LENGTH)
+            return LEPT_PARSE_TOO_LARGE;
+        if (c->insitu) { // 直接指向输入, 短字符串也不复制
+            lept_free(v);
+            v->s = s;
+            v->len = len;
+            v->type = LEPT_STRING;
+            v->flags = LEPT_FLAG_BORROWED;
+        } else if (c->arena == NULL || len <= LEPT_SHORT_STRING_MAX) {
+            lept_set_string(v, s, len);
+        } else {
+            lept_free(v);
+            v->s = lept_context_strdup(c, s, len);
+            v->len = len;
+            v->type = LEPT_STRING;
+            v->flags = LEPT_FLAG_BORROWED;
+        }
     }
     return ret;
 }
 
 
+/* 把栈顶的 size 个元素移到新分配的数组中 */
+static void lept_context_pop_array (lept_context* c, lept_value* v, size_t size) {
+    size_t s = size * sizeof(lept_value);
+    assert(size <= LEPT_MAX_CAPACITY);
+    v->type = LEPT_ARRAY;
+    v->size = size;
+    v->capacity = size;
+    if (c->arena != NULL) v->flags = LEPT_FLAG_BORROWED;
+    v->e = size > 0 ? (lept_value*)memcpy(lept_context_alloc(c, s), lept_context_pop(c, s), s) : NULL;
+}
+
+static void lept_context_pop_object (lept_context* c, lept_value* v, size_t size); // 向前申明
+
 static int lept_parse_value(lept_context* c, lept_value* v); // 向前申明
 static int lept_parse_array (lept_context* c, lept_value* v) {
     size_t size = 0;
     int ret;
     EXPECT(c, '[');
     lept_parse_whitespace(c);
-    if (*c->json == ']') {
+    if (PEEK(c) == ']') {
         v->type = LEPT_ARRAY;
         v->e = NULL;
         v->size = 0;
@@ -294,19 +1368,20 @@ static int lept_parse_array (lept_context* c, lept_value* v) {
         if ( (ret = lept_parse_value(c, &e)) != LEPT_PARSE_OK) {
             break;
         }
+        if (size == LEPT_MAX_CAPACITY) { // 紧凑布局中容量只有 23 位
+            lept_free(&e);
+            ret = LEPT_PARSE_TOO_LARGE;
+            break;
+        }
         memcpy(lept_context_push(c, sizeof(lept_value)), &e, sizeof(lept_value));
         size++;
         lept_parse_whitespace(c);
-        if (*c->json == ',') {
+        if (PEEK(c) == ',') {
             c->json++;
 //            lept_parse_whitespace(c);
-        } else if (*c->json == ']') {
-            v->type = LEPT_ARRAY;
+        } else if (PEEK(c) == ']') {
             c->json++;
-            v->size = size;
-            v->capacity = size;
-            size *= sizeof(lept_value);
-            memcpy(v->e = (lept_value*)malloc(size), lept_context_pop(c, size), size);
+            lept_context_pop_array(c, v, size);
             return LEPT_PARSE_OK;
         } else {
             ret = LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
@@ -321,6 +1396,103 @@ static int lept_parse_array (lept_context* c, lept_value* v) {
 }
 
 
+#define LEPT_KEYS_OWNED(c) ((c)->arena == NULL && !(c)->insitu && (c)->keys == NULL)
+
+/*
+ * 大对象的哈希索引: 开放寻址 (线性探测), 放在 m[capacity] 之后, 和成员数组是同一块内存,
+ * 所以小对象没有额外开销. 槽里保存成员下标 + 1, 0 表示空槽.
+ * 槽数是不小于 2 * capacity 的 2 的幂, 负载因子不超过 0.5.
+ * 槽的空间在分配成员数组时就留好 (capacity 不小于 LEPT_OBJECT_INDEX_MIN 时), 查找时只填充, 不移动成员数组,
+ * 之前取得的值和 key 的指针仍然有效.
+ * 解析时直接建好; 修改时若维护代价和重建相当 (扩容、删除、清空), 只清除 LEPT_FLAG_INDEXED,
+ * 下次查找时再重建.
+ */
+#define LEPT_OBJECT_SLOTS(v) ((uint32_t*)((v)->o.m + (v)->o.capacity))
+#define LEPT_OBJECT_HAS_SLOTS(capacity) ((capacity) >= LEPT_OBJECT_INDEX_MIN && (capacity) <= 0x7FFFFFFF)
+#define LEPT_OBJECT_INDEXABLE(v) ((v)->o.size >= LEPT_OBJECT_INDEX_MIN && LEPT_OBJECT_HAS_SLOTS((v)->o.capacity))
+
+static size_t lept_object_index_size(size_t capacity) {
+    size_t n = 2 * LEPT_OBJECT_INDEX_MIN;
+    while (n < capacity * 2)
+        n <<= 1;
+    return n;
+}
+
+/* capacity 个成员的数组加上索引的槽 */
+static size_t lept_object_bytes(size_t capacity) {
+    size_t s = capacity * sizeof(lept_member);
+    if (LEPT_OBJECT_HAS_SLOTS(capacity))
+        s += lept_object_index_size(capacity) * sizeof(uint32_t);
+    return s;
+}
+
+/* klen 不超过 LEPT_SHORT_KEY_MAX, 复制到 m 中 */
+static void lept_set_short_key(lept_member* m, const char* key, size_t klen) {
+    assert(klen <= LEPT_SHORT_KEY_MAX);
+    if (klen)
+        memcpy(m->ks + LEPT_KEY_CHARS, key, klen);
+    m->ks[LEPT_KEY_CHARS + klen] = '\0';
+    m->ks[LEPT_KEY_TAG] = (char)(0x80 | klen);
+}
+
+static uint32_t lept_hash_key(const char* key, size_t klen) {
+    uint32_t h = 2166136261u; /* FNV-1a */
+    while (klen--) {
+        h ^= (unsigned char)*key++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* 返回 key 所在的槽或者应该插入的空槽 */
+static uint32_t* lept_object_index_probe(const lept_value* v, const char* key, size_t klen) {
+    uint32_t* slots = LEPT_OBJECT_SLOTS(v);
+    size_t mask = lept_object_index_size(v->o.capacity) - 1;
+    size_t h = lept_hash_key(key, klen) & mask;
+    for (;; h = (h + 1) & mask) {
+        const lept_member* m;
+        if (slots[h] == 0)
+            return &slots[h];
+        m = &v->o.m[slots[h] - 1];
+        if (LEPT_KEY_EQUAL(m, key, klen))
+            return &slots[h];
+    }
+}
+
+/* 重复的 key 只索引第一个, 和线性查找的结果一致 */
+static void lept_object_index_insert(lept_value* v, size_t index) {
+    uint32_t* slot = lept_object_index_probe(v, LEPT_KEY(&v->o.m[index]), LEPT_KEY_LEN(&v->o.m[index]));
+    if (*slot == 0)
+        *slot = (uint32_t)(index + 1);
+}
+
+static void lept_object_index_fill(lept_value* v) {
+    size_t i;
+    memset(LEPT_OBJECT_SLOTS(v), 0, lept_object_index_size(v->o.capacity) * sizeof(uint32_t));
+    for (i = 0; i < v->o.size; i++)
+        lept_object_index_insert(v, i);
+    v->flags |= LEPT_FLAG_INDEXED;
+}
+
+/* 把栈顶的 size 个成员移到新分配的成员数组中 */
+static void lept_context_pop_object (lept_context* c, lept_value* v, size_t size) {
+    size_t s = sizeof(lept_member) * size;
+    assert(size <= LEPT_MAX_CAPACITY);
+    v->type = LEPT_OBJECT;
+    v->o.size = size;
+    v->o.capacity = size;
+    if (c->arena != NULL) v->flags = LEPT_FLAG_BORROWED | LEPT_FLAG_KEYS_BORROWED;
+    else if (c->insitu || c->keys != NULL) v->flags = LEPT_FLAG_KEYS_BORROWED;
+    if (size == 0)
+        v->o.m = NULL;
+    else {
+        /* 大对象一次分配成员数组和索引 */
+        memcpy(v->o.m = (lept_member*)lept_context_alloc(c, lept_object_bytes(size)), lept_context_pop(c, s), s);
+        if (LEPT_OBJECT_INDEXABLE(v))
+            lept_object_index_fill(v);
+    }
+}
+
 static int lept_parse_object (lept_context* c, lept_value* v) {
     size_t size;
     lept_member m;
@@ -329,7 +1501,7 @@ static int lept_parse_object (lept_context* c, lept_value* v) {
 
     lept_parse_whitespace(c); // filter  whitespace
 
-    if (*c->json == '}') { // not content
+    if (PEEK(c) == '}') { // not content
         v->o.size = 0;
         v->type = LEPT_OBJECT;
         v->o.m = 0;  //
@@ -338,23 +1510,34 @@ static int lept_parse_object (lept_context* c, lept_value* v) {
     }
 
     m.k = NULL;
+    m.klen = 0;
     size = 0;
 
     for (;;) {
         lept_init(&m.v);
         char* str;
-        if (*c->json != '\"') {
+        size_t klen;
+        if (PEEK(c) != '\"') {
             ret = LEPT_PARSE_MISS_KEY;
             break;
         }
-        if (( ret = lept_parse_string_raw(c, &str, &m.klen)) != LEPT_PARSE_OK) {
+        if (( ret = lept_parse_string_raw(c, &str, &klen)) != LEPT_PARSE_OK) {
             break;
         }
-        memcpy(m.k = (char*)malloc(m.klen+1), str, m.klen);
-        m.k[m.klen] = '\0';
+        if (!c->insitu && klen <= LEPT_SHORT_KEY_MAX)
+            lept_set_short_key(&m, str, klen);
+        else {
+            if (c->insitu)
+                m.k = str;
+            else if (c->keys != NULL)
+                m.k = (char*)lept_key_pool_intern(c->keys, str, klen);
+            else
+                m.k = lept_context_strdup(c, str, klen);
+            m.klen = klen;
+        }
         lept_parse_whitespace(c);
 
-        if ( *c->json == ':') {
+        if ( PEEK(c) == ':') {
             c->json++;
             lept_parse_whitespace(c);
         } else {
@@ -365,20 +1548,23 @@ static int lept_parse_object (lept_context* c, lept_value* v) {
         if ( (ret = lept_parse_value(c, &m.v)) != LEPT_PARSE_OK) {
             break;
         }
+        if (size == LEPT_MAX_CAPACITY) {
+            lept_free(&m.v);
+            ret = LEPT_PARSE_TOO_LARGE;
+            break;
+        }
         memcpy(lept_context_push(c, sizeof(lept_member)), &m, sizeof(lept_member));
         lept_parse_whitespace(c);
         size++;
         m.k = NULL; /* ownership is transferred to member on stack */
+        m.klen = 0;
         /* parse ws [comma | right-curly-brace] ws */
-        if (*c->json == ',') {
+        if (PEEK(c) == ',') {
             c->json++;
             lept_parse_whitespace(c);
-        } else if (*c->json == '}') {
-            v->type = LEPT_OBJECT;
-            v->size = size;
+        } else if (PEEK(c) == '}') {
             c->json++;
-            size_t s = sizeof(lept_member) * size;
-            memcpy(v->o.m = (lept_member*)malloc(s), lept_context_pop(c, s), s);
+            lept_context_pop_object(c, v, size);
             return LEPT_PARSE_OK;
 
         } else {
@@ -387,90 +1573,2404 @@ static int lept_parse_object (lept_context* c, lept_value* v) {
         }
     }
 
-    free(m.k);
+    if (LEPT_KEYS_OWNED(c) && !LEPT_KEY_IS_SHORT(&m))
+        free(m.k);
     /*Pop and free members on the stack */
     for (size_t i = 0; i < size; ++i) {
         lept_member *m = (lept_member*)lept_context_pop(c, sizeof(lept_member));
-        free(m->k);
+        if (LEPT_KEYS_OWNED(c) && !LEPT_KEY_IS_SHORT(m))
+            free(m->k);
         lept_free(&m->v);
     }
     return ret;
 }
 
 static int lept_parse_value(lept_context* c, lept_value* v) {
-    switch (*c->json) { // *c->json => *(c->json)
+    switch (PEEK(c)) {
         case '[': return lept_parse_array(c, v);
         case 'n':  return lept_parse_literal(c, v, "null", LEPT_NULL);
         case 't':  return lept_parse_literal(c, v, "true", LEPT_TRUE);
         case 'f':  return lept_parse_literal(c, v, "false", LEPT_FALSE);
-        case '\0': return LEPT_PARSE_EXPECT_VALUE;
+        case '\0': return c->json == c->end ? LEPT_PARSE_EXPECT_VALUE : LEPT_PARSE_INVALID_VALUE;
         case '"': return lept_parse_string(c, v);
         case '{': return lept_parse_object(c, v);
         default:   return lept_parse_number(c,v);
     }
 }
 
-int lept_parse (lept_value* v, const char* json) {
-    lept_context   c;
+/* 解析 [c->json, c->end) 中的一个 JSON, c->stack 留给调用者复用或释放 */
+static int lept_parse_document (lept_context* c, lept_value* v) {
     int ret ;
-    assert(v != NULL);
-    c.json = json;
-    c.stack = NULL;
-    c.size = c.top = 0;
     lept_init(v);
-    lept_parse_whitespace(&c);
-    if ((ret = lept_parse_value(&c, v)) == LEPT_PARSE_OK) {
-        lept_parse_whitespace(&c);
-        if (*c.json != '\0') { // *c.json => *(c.json)
-            v->type = LEPT_NULL;
+    lept_parse_whitespace(c);
+    if ((ret = lept_parse_value(c, v)) == LEPT_PARSE_OK) {
+        lept_parse_whitespace(c);
+        if (c->json != c->end) {
+            lept_free(v);
             ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
         }
     }
-    assert(c.top == 0);
-    free(c.stack);
+    assert(c->top == 0);
     return  ret;
 }
 
-void lept_free (lept_value* v) {
+static int lept_parse_root (lept_context* c, lept_value* v) {
+    int ret = lept_parse_document(c, v);
+    free(c->stack);
+    return  ret;
+}
+
+int lept_parse (lept_value* v, const char* json) {
+    lept_context   c;
     assert(v != NULL);
-    size_t i;
-    switch (v->type) {
-        case LEPT_STRING:
-            free(v->s);
-            break;
-        case LEPT_ARRAY:
-            for (i = 0; i < v->size; i++) {
-                lept_free(&v->e[i]);
-            }
-            free(v->e);
-            break;
-        case LEPT_OBJECT:
-            for (i = 0; i < v->o.size; ++i) {
-                free(v->o.m[i].k);
-                lept_free(&v->o.m[i].v);
-            }
-            free(v->o.m);
-        default:break;
-    }
-    v->type = LEPT_NULL;
+    c.json = json;
+    c.end = json + strlen(json);
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = NULL;
+    c.insitu = 0;
+    return lept_parse_root(&c, v);
 }
 
-void lept_move(lept_value* dst, lept_value* src) {
-    assert(dst != NULL && src != NULL && src != dst);
-    lept_free(dst);
-    memcpy(dst, src, sizeof(lept_value));
-    lept_init(src);
+/* 所有的词法分析都检查 c.end, 不会读取 json + len 及之后的字节 */
+int lept_parse_n (lept_value* v, const char* json, size_t len) {
+    lept_context   c;
+    assert(v != NULL && (json != NULL || len == 0));
+    c.json = json;
+    c.end = json + len;
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = NULL;
+    c.insitu = 0;
+    return lept_parse_root(&c, v);
 }
 
+/* lept_validate: 和 lept_parse_value 相同的语法, 只检查不保存; 字符串的转义解码到局部的 buf 中 */
+static int lept_validate_value (lept_context* c);
 
-void lept_swap(lept_value* lhs, lept_value* rhs) {
-    assert(lhs != NULL && rhs != NULL);
-    if (lhs != rhs) {
-        lept_value temp;
-        memcpy(&temp, lhs, sizeof(lept_value));
-        memcpy(lhs,   rhs, sizeof(lept_value));
-        memcpy(rhs, &temp, sizeof(lept_value));
-    }
+static int lept_validate_string (lept_context* c) {
+    const char* p;
+    char buf[4];
+    int n;
+    EXPECT(c, '\"');
+    p = c->json;
+    for (;;) {
+        const char* q = lept_scan_string(p, c->end);
+        char ch;
+        if (!lept_utf8_valid(p, q - p))
+            return LEPT_PARSE_INVALID_UTF8;
+        ch = AT(q, c->end);
+        p = q + 1;
+        switch (ch) {
+            case '\\':
+                if ((n = lept_parse_escape(&p, c->end, buf)) < 0)
+                    return -n;
+                break;
+            case '\"':
+                c->json = p;
+                return LEPT_PARSE_OK;
+            case '\0':
+                if (p > c->end)
+                    return LEPT_PARSE_MISS_QUOTATION_MARK;
+                /* fall through */
+            default:
+                return LEPT_PARSE_INVALID_STRING_CHAR;
+        }
+    }
+}
+
+static int lept_validate_array (lept_context* c) {
+    int ret;
+    EXPECT(c, '[');
+    lept_parse_whitespace(c);
+    if (PEEK(c) == ']') {
+        c->json++;
+        return LEPT_PARSE_OK;
+    }
+    for (;;) {
+        if ((ret = lept_validate_value(c)) != LEPT_PARSE_OK)
+            return ret;
+        lept_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            lept_parse_whitespace(c);
+        } else if (PEEK(c) == ']') {
+            c->json++;
+            return LEPT_PARSE_OK;
+        } else
+            return LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+    }
+}
+
+static int lept_validate_object (lept_context* c) {
+    int ret;
+    EXPECT(c, '{');
+    lept_parse_whitespace(c);
+    if (PEEK(c) == '}') {
+        c->json++;
+        return LEPT_PARSE_OK;
+    }
+    for (;;) {
+        if (PEEK(c) != '\"')
+            return LEPT_PARSE_MISS_KEY;
+        if ((ret = lept_validate_string(c)) != LEPT_PARSE_OK)
+            return ret;
+        lept_parse_whitespace(c);
+        if (PEEK(c) != ':')
+            return LEPT_PARSE_MISS_COLON;
+        c->json++;
+        lept_parse_whitespace(c);
+        if ((ret = lept_validate_value(c)) != LEPT_PARSE_OK)
+            return ret;
+        lept_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            lept_parse_whitespace(c);
+        } else if (PEEK(c) == '}') {
+            c->json++;
+            return LEPT_PARSE_OK;
+        } else
+            return LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    }
+}
+
+static int lept_validate_value (lept_context* c) {
+    lept_value v; // 字面量和数字不分配内存
+    switch (PEEK(c)) {
+        case '[': return lept_validate_array(c);
+        case 'n': return lept_parse_literal(c, &v, "null", LEPT_NULL);
+        case 't': return lept_parse_literal(c, &v, "true", LEPT_TRUE);
+        case 'f': return lept_parse_literal(c, &v, "false", LEPT_FALSE);
+        case '\0': return c->json == c->end ? LEPT_PARSE_EXPECT_VALUE : LEPT_PARSE_INVALID_VALUE;
+        case '"': return lept_validate_string(c);
+        case '{': return lept_validate_object(c);
+        default: return lept_parse_number(c, &v);
+    }
+}
+
+int lept_validate (const char* json, size_t len) {
+    lept_context c;
+    int ret;
+    assert(json != NULL || len == 0);
+    c.json = json;
+    c.end = json + len;
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = NULL;
+    c.insitu = 0;
+    lept_parse_whitespace(&c);
+    if ((ret = lept_validate_value(&c)) == LEPT_PARSE_OK) {
+        lept_parse_whitespace(&c);
+        if (c.json != c.end)
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    assert(c.stack == NULL);
+    return ret;
+}
+
+/*
+ * 两阶段解析 (simdjson 的做法):
+ * 第一阶段每次处理 64 字节, 用 SIMD 得到引号、'\\'、空白、结构字符 ({}[]:,) 和控制字符的位图,
+ * 去掉被转义的引号后用前缀异或得到字符串内部的掩码, 然后把字符串外的结构字符、所有的引号,
+ * 以及空白或结构字符之后的其它字符 (数字和字面量的开始) 的位置写入索引.
+ * 字符串内部的 '\\' 和控制字符记在 dirty 中.
+ * 第二阶段沿着索引分派: 字符串的结束引号就是下一个索引位置, dirty 中没有标记的字符串不再逐字节扫描, 直接复制;
+ * 两个索引位置之间只可能是空白, 所以也不需要跳过空白.
+ */
+typedef struct {
+    const char* pos, *end; // pos 为下一个还没有建立索引的块
+    const char* base; // idx 和 dirty 中的位置都相对于 base
+    uint64_t in_string; // 上一块结束时在字符串中为全 1, 否则为 0
+    uint64_t escaped; // 上一块最后是没有被转义的 '\\' 时为 1
+    uint64_t sep; // 上一块最后一个字节是空白或结构字符时为 1
+    uint64_t dirty[LEPT_STRUCTURAL_WINDOW / 64]; // 每块中字符串内部的 '\\' 和控制字符
+    uint32_t* idx;
+    size_t head, count;
+} lept_structural;
+
+/* 64 个字节的分类: m[0] 引号, m[1] '\\', m[2] 空白, m[3] 结构字符, m[4] 控制字符 (< 0x20) */
+static void lept_structural_classify (const char* p, uint64_t m[5]) {
+    int i;
+    m[0] = m[1] = m[2] = m[3] = m[4] = 0;
+#if defined(LEPT_AVX2)
+    /* 按高低 4 位查表再相与: 空白得到 0x18 中的位, 结构字符得到 0x07 中的位, 其它字符为 0 */
+    const __m256i lo = _mm256_setr_epi8(16, 0, 0, 0, 0, 0, 0, 0, 0, 8, 12, 1, 2, 9, 0, 0,
+                                        16, 0, 0, 0, 0, 0, 0, 0, 0, 8, 12, 1, 2, 9, 0, 0);
+    const __m256i hi = _mm256_setr_epi8(8, 0, 18, 4, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+                                        8, 0, 18, 4, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i zero = _mm256_setzero_si256();
+    for (i = 0; i < 64; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i k = _mm256_and_si256(_mm256_shuffle_epi8(lo, s),
+                _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(s, 4), _mm256_set1_epi8(0x0F))));
+        m[0] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('"'))) << i;
+        m[1] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'))) << i;
+        m[2] |= (uint64_t)(uint32_t)~_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(k, _mm256_set1_epi8(0x18)), zero)) << i;
+        m[3] |= (uint64_t)(uint32_t)~_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(k, _mm256_set1_epi8(0x07)), zero)) << i;
+        m[4] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(s, _mm256_set1_epi8(0x1F)), s)) << i;
+    }
+#elif defined(LEPT_SSE2)
+    for (i = 0; i < 64; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i l = _mm_or_si128(s, _mm_set1_epi8(0x20));
+        m[0] |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(s, _mm_set1_epi8('"'))) << i;
+        m[1] |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(s, _mm_set1_epi8('\\'))) << i;
+        m[2] |= (uint64_t)_mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\t'))),
+                _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\r'))))) << i;
+        m[3] |= (uint64_t)_mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('{')), _mm_cmpeq_epi8(l, _mm_set1_epi8('}'))),
+                _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8(':')), _mm_cmpeq_epi8(s, _mm_set1_epi8(','))))) << i;
+        m[4] |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(s, _mm_set1_epi8(0x1F)), s)) << i;
+    }
+#else
+    for (i = 0; i < 64; i++) {
+        uint64_t bit = (uint64_t)1 << i;
+        if ((unsigned char)p[i] < 0x20)
+            m[4] |= bit;
+        switch (p[i]) {
+            case '"': m[0] |= bit; break;
+            case '\\': m[1] |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': m[2] |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': m[3] |= bit; break;
+        }
+    }
+#endif
+}
+
+/* 前缀异或: 第 i 位为 x 的第 0..i 位的异或, 两个引号之间 (包括开始的引号) 为 1 */
+static uint64_t lept_prefix_xor (uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/* 被 '\\' 转义的字节; 连续的 '\\' 两两配对, 只有 '\\' 的块才需要循环 */
+static uint64_t lept_structural_escaped (lept_structural* s, uint64_t backslash) {
+    uint64_t escaped = s->escaped;
+    s->escaped = 0;
+    backslash &= ~escaped;
+    while (backslash != 0) {
+        uint64_t b = backslash & (0 - backslash);
+        if (b == (uint64_t)1 << 63)
+            s->escaped = 1;
+        escaped |= b << 1;
+        backslash &= ~(b | b << 1);
+    }
+    return escaped;
+}
+
+static int lept_popcount64 (uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+    for (; x != 0; x &= x - 1)
+        n++;
+    return n;
+#endif
+}
+
+/* 为下一个窗口的输入建立索引 */
+static void lept_structural_fill (lept_structural* s) {
+    char tail[64];
+    const char* p = s->pos, *end = s->end, *stop;
+    uint64_t m[5], in_string, sep, bits, prev_in_string = s->in_string, prev_sep = s->sep;
+    uint32_t* out = s->idx;
+    size_t block = 0;
+    s->base = p;
+    stop = (size_t)(end - p) > LEPT_STRUCTURAL_WINDOW ? p + LEPT_STRUCTURAL_WINDOW : end;
+    for (; p < stop; p += 64, block++) {
+        uint32_t offset = (uint32_t)(p - s->base);
+        if (end - p < 64) { // 最后不足 64 字节时用空白补齐, 不会越界读取
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, p, end - p);
+            lept_structural_classify(tail, m);
+        } else
+            lept_structural_classify(p, m);
+        if (m[1] != 0 || s->escaped != 0)
+            m[0] &= ~lept_structural_escaped(s, m[1]);
+        in_string = lept_prefix_xor(m[0]) ^ prev_in_string;
+        prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+        s->dirty[block] = (m[1] | m[4]) & in_string;
+        sep = m[2] | m[3];
+        bits = (m[3] & ~in_string) | m[0] | (~(sep | m[0]) & ~in_string & (sep << 1 | prev_sep));
+        prev_sep = sep >> 63;
+        /* 每次写 4 个, 多写的位置会被后面覆盖 (idx 留有余量); 或上最高位避免 ctz(0) */
+        if (bits != 0) {
+            uint32_t* next = out + lept_popcount64(bits);
+            do {
+                out[0] = offset + (uint32_t)lept_ctz64(bits | (uint64_t)1 << 63);
+                bits &= bits - 1;
+                out[1] = offset + (uint32_t)lept_ctz64(bits | (uint64_t)1 << 63);
+                bits &= bits - 1;
+                out[2] = offset + (uint32_t)lept_ctz64(bits | (uint64_t)1 << 63);
+                bits &= bits - 1;
+                out[3] = offset + (uint32_t)lept_ctz64(bits | (uint64_t)1 << 63);
+                bits &= bits - 1;
+                out += 4;
+            } while (bits != 0);
+            out = next;
+        }
+    }
+    s->pos = p < end ? p : end;
+    s->in_string = prev_in_string;
+    s->sep = prev_sep;
+    s->head = 0;
+    s->count = (size_t)(out - s->idx);
+}
+
+/* 取出下一个索引位置, 没有了时返回 end */
+static const char* lept_structural_next (lept_structural* s) {
+    while (s->head == s->count) {
+        if (s->pos == s->end)
+            return s->end;
+        lept_structural_fill(s);
+    }
+    return s->base + s->idx[s->head++];
+}
+
+/* 字符串的内容 [p, q) 在当前窗口中, 并且没有 '\\' 和控制字符 */
+static int lept_structural_clean (const lept_structural* s, const char* p, const char* q) {
+    size_t i, last;
+    uint64_t dirty;
+    if (p == q)
+        return 1;
+    if (p < s->base)
+        return 0;
+    i = (size_t)(p - s->base);
+    last = (size_t)(q - 1 - s->base);
+    if (i >> 6 == last >> 6)
+        return (s->dirty[i >> 6] >> (i & 63) & (~(uint64_t)0 >> (63 - (last - i)))) == 0;
+    dirty = s->dirty[i >> 6] >> (i & 63);
+    for (i = (i >> 6) + 1; i < last >> 6; i++)
+        dirty |= s->dirty[i];
+    return (dirty | (s->dirty[last >> 6] & (~(uint64_t)0 >> (63 - (last & 63))))) == 0;
+}
+
+/*
+ * 第二阶段只处理合法的输入, 返回值只区分成功和失败; 失败时 lept_parse_fast 交给 lept_parse 重新解析,
+ * 得到相同的错误码. c->json 为上一个 token 之后的位置.
+ */
+
+/* 下一个 token 的位置; 和上一个 token 之间不只是空白时 (比如 123abc) 返回 NULL */
+static const char* lept_fast_next (lept_context* c, lept_structural* s) {
+    const char* q = lept_structural_next(s);
+    if (q < c->json || (q != c->json && !ISWHITESPACE(*c->json)))
+        return NULL;
+    return q;
+}
+
+#define LEPT_FAST_AT(c, p) ((p) != NULL ? AT(p, (c)->end) : '\0')
+
+/* c->json 为开始的引号, 结束的引号是下一个索引位置 */
+static int lept_fast_string_raw (lept_context* c, lept_structural* s, const char** str, size_t* len) {
+    const char* p = c->json + 1;
+    const char* q = lept_structural_next(s);
+    char* t;
+    int ret;
+    if (q == c->end)
+        return LEPT_PARSE_MISS_QUOTATION_MARK;
+    assert(*q == '\"');
+    if (lept_structural_clean(s, p, q)) { // 没有转义和控制字符, 内容就是输入中的字节
+#if defined(LEPT_CHECK_UTF8)
+        if (!lept_utf8_valid(p, q - p))
+            return LEPT_PARSE_INVALID_UTF8;
+#endif
+        *str = p;
+        *len = q - p;
+        c->json = q + 1;
+        return LEPT_PARSE_OK;
+    }
+    if ((ret = lept_parse_string_raw(c, &t, len)) != LEPT_PARSE_OK)
+        return ret;
+    *str = t;
+    return c->json == q + 1 ? LEPT_PARSE_OK : LEPT_PARSE_INVALID_STRING_CHAR;
+}
+
+static int lept_fast_value (lept_context* c, lept_structural* s, const char* p, lept_value* v); // 向前申明
+
+static int lept_fast_array (lept_context* c, lept_structural* s, lept_value* v) {
+    size_t size = 0;
+    const char* p;
+    int ret;
+    c->json++;
+    p = lept_fast_next(c, s);
+    if (LEPT_FAST_AT(c, p) == ']') {
+        v->type = LEPT_ARRAY;
+        v->e = NULL;
+        v->size = 0;
+        c->json = p + 1;
+        return LEPT_PARSE_OK;
+    }
+    for (;;) {
+        lept_value e;
+        lept_init(&e);
+        if ((ret = lept_fast_value(c, s, p, &e)) != LEPT_PARSE_OK)
+            break;
+        if (size == LEPT_MAX_CAPACITY) {
+            lept_free(&e);
+            ret = LEPT_PARSE_TOO_LARGE;
+            break;
+        }
+        memcpy(lept_context_push(c, sizeof(lept_value)), &e, sizeof(lept_value));
+        size++;
+        p = lept_fast_next(c, s);
+        if (LEPT_FAST_AT(c, p) == ',') {
+            c->json = p + 1;
+            p = lept_fast_next(c, s);
+        } else if (LEPT_FAST_AT(c, p) == ']') {
+            c->json = p + 1;
+            lept_context_pop_array(c, v, size);
+            return LEPT_PARSE_OK;
+        } else {
+            ret = LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            break;
+        }
+    }
+    while (size-- > 0)
+        lept_free((lept_value*)lept_context_pop(c, sizeof(lept_value)));
+    return ret;
+}
+
+static int lept_fast_object (lept_context* c, lept_structural* s, lept_value* v) {
+    size_t size = 0, klen;
+    const char* p, *str;
+    lept_member m;
+    int ret;
+    c->json++;
+    p = lept_fast_next(c, s);
+    if (LEPT_FAST_AT(c, p) == '}') {
+        v->type = LEPT_OBJECT;
+        v->o.size = 0;
+        v->o.m = NULL;
+        c->json = p + 1;
+        return LEPT_PARSE_OK;
+    }
+    for (;;) {
+        if (LEPT_FAST_AT(c, p) != '\"') {
+            ret = LEPT_PARSE_MISS_KEY;
+            break;
+        }
+        c->json = p;
+        if ((ret = lept_fast_string_raw(c, s, &str, &klen)) != LEPT_PARSE_OK)
+            break;
+        if (klen <= LEPT_SHORT_KEY_MAX)
+            lept_set_short_key(&m, str, klen);
+        else {
+            m.k = lept_context_strdup(c, str, klen);
+            m.klen = klen;
+        }
+        lept_init(&m.v);
+        p = lept_fast_next(c, s);
+        if (LEPT_FAST_AT(c, p) != ':') {
+            ret = LEPT_PARSE_MISS_COLON;
+        } else {
+            c->json = p + 1;
+            if ((ret = lept_fast_value(c, s, lept_fast_next(c, s), &m.v)) == LEPT_PARSE_OK && size == LEPT_MAX_CAPACITY) {
+                lept_free(&m.v);
+                ret = LEPT_PARSE_TOO_LARGE;
+            }
+        }
+        if (ret != LEPT_PARSE_OK) {
+            if (!LEPT_KEY_IS_SHORT(&m))
+                free(m.k);
+            break;
+        }
+        memcpy(lept_context_push(c, sizeof(lept_member)), &m, sizeof(lept_member));
+        size++;
+        p = lept_fast_next(c, s);
+        if (LEPT_FAST_AT(c, p) == ',') {
+            c->json = p + 1;
+            p = lept_fast_next(c, s);
+        } else if (LEPT_FAST_AT(c, p) == '}') {
+            c->json = p + 1;
+            lept_context_pop_object(c, v, size);
+            return LEPT_PARSE_OK;
+        } else {
+            ret = LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        }
+    }
+    while (size-- > 0) {
+        lept_member* e = (lept_member*)lept_context_pop(c, sizeof(lept_member));
+        if (!LEPT_KEY_IS_SHORT(e))
+            free(e->k);
+        lept_free(&e->v);
+    }
+    return ret;
+}
+
+/* p 为值的第一个字节 */
+static int lept_fast_value (lept_context* c, lept_structural* s, const char* p, lept_value* v) {
+    const char* str;
+    size_t len;
+    int ret;
+    if (p == NULL)
+        return LEPT_PARSE_INVALID_VALUE;
+    c->json = p;
+    switch (AT(p, c->end)) {
+        case '[': return lept_fast_array(c, s, v);
+        case '{': return lept_fast_object(c, s, v);
+        case '"':
+            if ((ret = lept_fast_string_raw(c, s, &str, &len)) != LEPT_PARSE_OK)
+                return ret;
+            if (len > LEPT_MAX_STRING_LENGTH)
+                return LEPT_PARSE_TOO_LARGE;
+            lept_set_string(v, str, len);
+            return LEPT_PARSE_OK;
+        case 'n': return lept_parse_literal(c, v, "null", LEPT_NULL);
+        case 't': return lept_parse_literal(c, v, "true", LEPT_TRUE);
+        case 'f': return lept_parse_literal(c, v, "false", LEPT_FALSE);
+        case '\0': return LEPT_PARSE_EXPECT_VALUE;
+        default: return lept_parse_number(c, v);
+    }
+}
+
+int lept_parse_fast (lept_value* v, const char* json) {
+    lept_context c;
+    lept_structural s;
+    int ret;
+    assert(v != NULL && json != NULL);
+    c.json = json;
+    c.end = json + strlen(json);
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = NULL;
+    c.insitu = 0;
+    s.pos = s.base = json;
+    s.end = c.end;
+    s.in_string = s.escaped = 0;
+    s.sep = 1; // 开头相当于在空白之后
+    s.idx = (uint32_t*)malloc((LEPT_STRUCTURAL_WINDOW + 4) * sizeof(uint32_t));
+    s.head = s.count = 0;
+    lept_init(v);
+    if ((ret = lept_fast_value(&c, &s, lept_fast_next(&c, &s), v)) == LEPT_PARSE_OK && lept_fast_next(&c, &s) != c.end) {
+        lept_free(v);
+        ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    assert(c.top == 0);
+    free(c.stack);
+    free(s.idx);
+    /* 错误的输入很少见, 重新解析一次得到和 lept_parse 相同的错误码 */
+    return ret == LEPT_PARSE_OK ? ret : lept_parse(v, json);
+}
+
+int lept_parse_arena (lept_arena* a, lept_value* v, const char* json) {
+    lept_context   c;
+    assert(a != NULL && v != NULL);
+    c.json = json;
+    c.end = json + strlen(json);
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = a;
+    c.keys = NULL;
+    c.insitu = 0;
+    return lept_parse_root(&c, v);
+}
+
+int lept_parse_pooled (lept_key_pool* p, lept_value* v, const char* json) {
+    lept_context   c;
+    assert(p != NULL && v != NULL);
+    c.json = json;
+    c.end = json + strlen(json);
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = p;
+    c.insitu = 0;
+    return lept_parse_root(&c, v);
+}
+
+int lept_parse_insitu (lept_value* v, char* json) {
+    lept_context   c;
+    assert(v != NULL && json != NULL);
+    c.json = json;
+    c.end = json + strlen(json);
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = NULL;
+    c.insitu = 1;
+    return lept_parse_root(&c, v);
+}
+
+/*
+ * 把整个文件映射到内存 (不支持 mmap 的平台读入堆内存), 顺序访问.
+ * 文件末尾没有 '\0', 解析时用 [data, data + size) 作为输入.
+ * writable 时使用私有的写时复制映射, insitu 解析的修改不会写回文件.
+ */
+static int lept_map_file (const char* path, int flags, int writable, lept_file_map* map) {
+#if defined(LEPT_POSIX)
+    struct stat st;
+    int fd, e, mflags = MAP_PRIVATE;
+    void* p;
+    map->data = NULL;
+    map->size = 0;
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return LEPT_FILE_IO_ERROR;
+    e = fstat(fd, &st) < 0 ? errno : (uint64_t)st.st_size > SIZE_MAX ? EFBIG : 0;
+    if (e != 0) {
+        close(fd);
+        errno = e;
+        return LEPT_FILE_IO_ERROR;
+    }
+    if (st.st_size > 0) { // 长度为 0 时 mmap 会失败, 当作空的输入
+#if defined(MAP_POPULATE)
+        if (flags & LEPT_FILE_POPULATE)
+            mflags |= MAP_POPULATE;
+#endif
+        p = mmap(NULL, (size_t)st.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, mflags, fd, 0);
+        if (p == MAP_FAILED) {
+            e = errno;
+            close(fd);
+            errno = e;
+            return LEPT_FILE_IO_ERROR;
+        }
+        madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+        map->data = (char*)p;
+        map->size = (size_t)st.st_size;
+    }
+    close(fd);
+    return LEPT_PARSE_OK;
+#else
+    FILE* fp;
+    long size;
+    (void)flags;
+    (void)writable;
+    map->data = NULL;
+    map->size = 0;
+    if ((fp = fopen(path, "rb")) == NULL)
+        return LEPT_FILE_IO_ERROR;
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return LEPT_FILE_IO_ERROR;
+    }
+    map->data = (char*)malloc(size > 0 ? (size_t)size : 1);
+    if ((map->size = fread(map->data, 1, (size_t)size, fp)) != (size_t)size) {
+        fclose(fp);
+        lept_file_unmap(map);
+        return LEPT_FILE_IO_ERROR;
+    }
+    fclose(fp);
+    return LEPT_PARSE_OK;
+#endif
+}
+
+void lept_file_unmap (lept_file_map* map) {
+    assert(map != NULL);
+#if defined(LEPT_POSIX)
+    if (map->data != NULL)
+        munmap(map->data, map->size);
+#else
+    free(map->data);
+#endif
+    map->data = NULL;
+    map->size = 0;
+}
+
+int lept_parse_file (lept_value* v, const char* path, int flags) {
+    lept_file_map map;
+    int ret;
+    assert(v != NULL && path != NULL);
+    if (lept_map_file(path, flags, 0, &map) != LEPT_PARSE_OK) {
+        lept_init(v);
+        return LEPT_FILE_IO_ERROR;
+    }
+    ret = lept_parse_n(v, map.data, map.size); // 字符串都复制出来了, 可以马上解除映射
+    lept_file_unmap(&map);
+    return ret;
+}
+
+int lept_parse_file_insitu (lept_value* v, const char* path, int flags, lept_file_map* map) {
+    lept_context   c;
+    int ret;
+    assert(v != NULL && path != NULL && map != NULL);
+    if (lept_map_file(path, flags, 1, map) != LEPT_PARSE_OK) {
+        lept_init(v);
+        return LEPT_FILE_IO_ERROR;
+    }
+    c.json = map->data;
+    c.end = map->data + map->size;
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = NULL;
+    c.insitu = 1;
+    if ((ret = lept_parse_root(&c, v)) != LEPT_PARSE_OK)
+        lept_file_unmap(map); // 失败时 v 中没有指向映射的字符串
+    return ret;
+}
+
+/* 一行的解析结果, 按顺序交付时整块解析完再回调 */
+typedef struct {
+    lept_value v;
+    size_t offset;
+    int ret;
+} lept_ndjson_record;
+
+/* 所有线程共享的状态, next/chunk/turn/ret 由 lock 保护 */
+typedef struct {
+    const char* json, *end;
+    const char* next; // 下一块的开始
+    size_t chunk; // 下一块的序号
+    size_t turn; // 按顺序交付时, 下一个可以回调的块
+    int ordered, ret;
+    lept_ndjson_fn callback;
+    void* userdata;
+#if defined(LEPT_THREADS)
+    pthread_mutex_t lock;
+    pthread_cond_t cond; // turn 或 ret 改变
+#endif
+} lept_ndjson_job;
+
+/* 每个线程自己的解析栈、arena 和结果数组, 在各行之间复用 */
+typedef struct {
+    lept_ndjson_job* job;
+    lept_context c;
+    lept_arena arena;
+    lept_ndjson_record* records;
+    size_t size, capacity;
+} lept_ndjson_worker;
+
+#if defined(LEPT_THREADS)
+#define LEPT_NDJSON_LOCK(job) pthread_mutex_lock(&(job)->lock)
+#define LEPT_NDJSON_UNLOCK(job) pthread_mutex_unlock(&(job)->lock)
+#else
+#define LEPT_NDJSON_LOCK(job) ((void)0)
+#define LEPT_NDJSON_UNLOCK(job) ((void)0)
+#endif
+
+/* 解析 [p, q) 中的一行, 空行返回 0 */
+static int lept_ndjson_parse_line (lept_ndjson_worker* w, lept_ndjson_record* r, const char* p, const char* q) {
+    w->c.json = p;
+    w->c.end = q;
+    lept_parse_whitespace(&w->c);
+    if (w->c.json == q)
+        return 0;
+    r->offset = (size_t)(p - w->job->json);
+    r->ret = lept_parse_document(&w->c, &r->v);
+    return 1;
+}
+
+/* 按顺序交付: 等到轮到第 k 块再回调, 同时最多有线程数个块的结果在内存中 */
+static void lept_ndjson_deliver (lept_ndjson_worker* w, size_t k) {
+    lept_ndjson_job* job = w->job;
+    size_t i;
+    int ret = LEPT_PARSE_OK;
+    LEPT_NDJSON_LOCK(job);
+#if defined(LEPT_THREADS)
+    while (job->turn != k && job->ret == LEPT_PARSE_OK)
+        pthread_cond_wait(&job->cond, &job->lock);
+#else
+    (void)k; // 单线程时各块本来就按顺序交付
+#endif
+    if (job->ret == LEPT_PARSE_OK) {
+        LEPT_NDJSON_UNLOCK(job); // 其它线程都在等这一块, 回调时不需要持有锁
+        for (i = 0; i < w->size && ret == LEPT_PARSE_OK; i++) {
+            lept_ndjson_record* r = &w->records[i];
+            if (!job->callback(job->userdata, r->offset, &r->v, r->ret))
+                ret = LEPT_PARSE_STOPPED;
+        }
+        LEPT_NDJSON_LOCK(job);
+        job->turn++;
+        if (ret != LEPT_PARSE_OK)
+            job->ret = ret;
+#if defined(LEPT_THREADS)
+        pthread_cond_broadcast(&job->cond);
+#endif
+    }
+    LEPT_NDJSON_UNLOCK(job);
+    w->size = 0; // 结果都在 arena 中, 由调用者重置 arena 一起释放, 不需要 lept_free
+}
+
+static void* lept_ndjson_work (void* arg) {
+    lept_ndjson_worker* w = (lept_ndjson_worker*)arg;
+    lept_ndjson_job* job = w->job;
+    lept_ndjson_record r;
+    const char* p, *q, *end;
+    size_t k;
+    for (;;) {
+        LEPT_NDJSON_LOCK(job);
+        if (job->ret != LEPT_PARSE_OK || job->next == job->end) {
+            LEPT_NDJSON_UNLOCK(job);
+            break;
+        }
+        p = job->next;
+        if ((size_t)(job->end - p) <= LEPT_NDJSON_CHUNK_SIZE)
+            end = job->end;
+        else if ((end = (const char*)memchr(p + LEPT_NDJSON_CHUNK_SIZE, '\n', job->end - p - LEPT_NDJSON_CHUNK_SIZE)) == NULL)
+            end = job->end;
+        else
+            end++;
+        job->next = end;
+        k = job->chunk++;
+        LEPT_NDJSON_UNLOCK(job);
+
+        for (; p != end; p = q == end ? end : q + 1) {
+            if ((q = (const char*)memchr(p, '\n', end - p)) == NULL)
+                q = end;
+            if (job->ordered) {
+                if (w->size == w->capacity) {
+                    w->capacity = w->capacity == 0 ? 256 : w->capacity + (w->capacity >> 1);
+                    w->records = (lept_ndjson_record*)realloc(w->records, w->capacity * sizeof(lept_ndjson_record));
+                }
+                w->size += lept_ndjson_parse_line(w, &w->records[w->size], p, q);
+            } else if (lept_ndjson_parse_line(w, &r, p, q)) {
+                /* 不按顺序时直接在本线程回调, 其它线程正在处理的块在停止之后还可能回调 */
+                int stop = !job->callback(job->userdata, r.offset, &r.v, r.ret);
+                lept_arena_reset(&w->arena);
+                if (stop) {
+                    LEPT_NDJSON_LOCK(job);
+                    job->ret = LEPT_PARSE_STOPPED;
+                    LEPT_NDJSON_UNLOCK(job);
+                    break;
+                }
+            }
+        }
+        if (job->ordered) {
+            lept_ndjson_deliver(w, k);
+            lept_arena_reset(&w->arena);
+        }
+    }
+    return NULL;
+}
+
+static void lept_ndjson_worker_init (lept_ndjson_worker* w, lept_ndjson_job* job) {
+    w->job = job;
+    w->c.stack = NULL;
+    w->c.size = w->c.top = 0;
+    w->c.arena = &w->arena;
+    w->c.keys = NULL;
+    w->c.insitu = 0;
+    lept_arena_init(&w->arena, 0);
+    w->records = NULL;
+    w->size = w->capacity = 0;
+}
+
+static void lept_ndjson_worker_destroy (lept_ndjson_worker* w) {
+    free(w->c.stack);
+    lept_arena_destroy(&w->arena);
+    free(w->records);
+}
+
+int lept_ndjson_parse_parallel (const char* json, size_t len, int nthreads, int ordered, lept_ndjson_fn callback, void* userdata) {
+    lept_ndjson_job job;
+    lept_ndjson_worker* workers;
+    int i;
+    assert((json != NULL || len == 0) && callback != NULL);
+    job.json = job.next = json;
+    job.end = json + len;
+    job.chunk = job.turn = 0;
+    job.ordered = ordered;
+    job.ret = LEPT_PARSE_OK;
+    job.callback = callback;
+    job.userdata = userdata;
+#if defined(LEPT_THREADS)
+    if (nthreads <= 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = n > 0 ? (int)n : 1;
+    }
+    if ((size_t)nthreads > len / LEPT_NDJSON_CHUNK_SIZE + 1) // 每个线程至少有一块
+        nthreads = (int)(len / LEPT_NDJSON_CHUNK_SIZE + 1);
+#else
+    nthreads = 1;
+#endif
+    workers = (lept_ndjson_worker*)malloc(nthreads * sizeof(lept_ndjson_worker));
+    for (i = 0; i < nthreads; i++)
+        lept_ndjson_worker_init(&workers[i], &job);
+#if defined(LEPT_THREADS)
+    {
+        pthread_t* threads = (pthread_t*)malloc(nthreads * sizeof(pthread_t));
+        int n;
+        pthread_mutex_init(&job.lock, NULL);
+        pthread_cond_init(&job.cond, NULL);
+        /* 调用者的线程也参与解析; 创建线程失败时少用几个线程 */
+        for (n = 1; n < nthreads; n++)
+            if (pthread_create(&threads[n], NULL, lept_ndjson_work, &workers[n]) != 0)
+                break;
+        lept_ndjson_work(&workers[0]);
+        for (i = 1; i < n; i++)
+            pthread_join(threads[i], NULL);
+        pthread_cond_destroy(&job.cond);
+        pthread_mutex_destroy(&job.lock);
+        free(threads);
+    }
+#else
+    lept_ndjson_work(&workers[0]);
+#endif
+    for (i = 0; i < nthreads; i++)
+        lept_ndjson_worker_destroy(&workers[i]);
+    free(workers);
+    return job.ret;
+}
+
+int lept_ndjson_parse_file (const char* path, int nthreads, int ordered, lept_ndjson_fn callback, void* userdata) {
+    lept_file_map map;
+    int ret;
+    assert(path != NULL);
+    if (lept_map_file(path, 0, 0, &map) != LEPT_PARSE_OK)
+        return LEPT_FILE_IO_ERROR;
+    ret = lept_ndjson_parse_parallel(map.data, map.size, nthreads, ordered, callback, userdata);
+    lept_file_unmap(&map);
+    return ret;
+}
+
+/*
+ * SAX 解析: 和 lept_parse 使用同样的词法函数, 不构建 lept_value 树.
+ * c->stack 只用来存放当前的字符串, 内存占用和文档大小无关.
+ */
+static int lept_sax_value(lept_context* c, const lept_handler* h, void* userdata); // 向前申明
+
+static int lept_sax_array (lept_context* c, const lept_handler* h, void* userdata) {
+    size_t size = 0;
+    int ret;
+    EXPECT(c, '[');
+    if (h->start_array != NULL && !h->start_array(userdata))
+        return LEPT_PARSE_STOPPED;
+    lept_parse_whitespace(c);
+    if (PEEK(c) == ']') {
+        c->json++;
+        return h->end_array == NULL || h->end_array(userdata, 0) ? LEPT_PARSE_OK : LEPT_PARSE_STOPPED;
+    }
+    for (;;) {
+        lept_parse_whitespace(c);
+        if ((ret = lept_sax_value(c, h, userdata)) != LEPT_PARSE_OK)
+            return ret;
+        size++;
+        lept_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+        } else if (PEEK(c) == ']') {
+            c->json++;
+            return h->end_array == NULL || h->end_array(userdata, size) ? LEPT_PARSE_OK : LEPT_PARSE_STOPPED;
+        } else
+            return LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+    }
+}
+
+static int lept_sax_object (lept_context* c, const lept_handler* h, void* userdata) {
+    size_t size = 0, len;
+    char* str;
+    int ret;
+    EXPECT(c, '{');
+    if (h->start_object != NULL && !h->start_object(userdata))
+        return LEPT_PARSE_STOPPED;
+    lept_parse_whitespace(c);
+    if (PEEK(c) == '}') {
+        c->json++;
+        return h->end_object == NULL || h->end_object(userdata, 0) ? LEPT_PARSE_OK : LEPT_PARSE_STOPPED;
+    }
+    for (;;) {
+        if (PEEK(c) != '\"')
+            return LEPT_PARSE_MISS_KEY;
+        if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+            return ret;
+        if (h->key != NULL && !h->key(userdata, str, len))
+            return LEPT_PARSE_STOPPED;
+        lept_parse_whitespace(c);
+        if (PEEK(c) != ':')
+            return LEPT_PARSE_MISS_COLON;
+        c->json++;
+        lept_parse_whitespace(c);
+        if ((ret = lept_sax_value(c, h, userdata)) != LEPT_PARSE_OK)
+            return ret;
+        size++;
+        lept_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            lept_parse_whitespace(c);
+        } else if (PEEK(c) == '}') {
+            c->json++;
+            return h->end_object == NULL || h->end_object(userdata, size) ? LEPT_PARSE_OK : LEPT_PARSE_STOPPED;
+        } else
+            return LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    }
+}
+
+static int lept_sax_value (lept_context* c, const lept_handler* h, void* userdata) {
+    lept_value v;
+    char* str;
+    size_t len;
+    int ret, go;
+    lept_init(&v);
+    switch (PEEK(c)) {
+        case '[': return lept_sax_array(c, h, userdata);
+        case '{': return lept_sax_object(c, h, userdata);
+        case 'n':
+            if ((ret = lept_parse_literal(c, &v, "null", LEPT_NULL)) != LEPT_PARSE_OK) return ret;
+            go = h->null == NULL || h->null(userdata);
+            break;
+        case 't':
+            if ((ret = lept_parse_literal(c, &v, "true", LEPT_TRUE)) != LEPT_PARSE_OK) return ret;
+            go = h->boolean == NULL || h->boolean(userdata, 1);
+            break;
+        case 'f':
+            if ((ret = lept_parse_literal(c, &v, "false", LEPT_FALSE)) != LEPT_PARSE_OK) return ret;
+            go = h->boolean == NULL || h->boolean(userdata, 0);
+            break;
+        case '\0': return c->json == c->end ? LEPT_PARSE_EXPECT_VALUE : LEPT_PARSE_INVALID_VALUE;
+        case '"':
+            if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK) return ret;
+            go = h->string == NULL || h->string(userdata, str, len);
+            break;
+        default:
+            if ((ret = lept_parse_number(c, &v)) != LEPT_PARSE_OK) return ret;
+            go = h->number == NULL || h->number(userdata, &v);
+            break;
+    }
+    return go ? LEPT_PARSE_OK : LEPT_PARSE_STOPPED;
+}
+
+int lept_parse_sax (const char* json, const lept_handler* handler, void* userdata) {
+    lept_context c;
+    int ret;
+    assert(json != NULL && handler != NULL);
+    c.json = json;
+    c.end = json + strlen(json);
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = NULL;
+    c.insitu = 0;
+    lept_parse_whitespace(&c);
+    if ((ret = lept_sax_value(&c, handler, userdata)) == LEPT_PARSE_OK) {
+        lept_parse_whitespace(&c);
+        if (c.json != c.end)
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    assert(c.top == 0);
+    free(c.stack);
+    return ret;
+}
+
+/*
+ * tape: 整个文档保存在一个 64 位字的数组中, 所有字符串保存在一个缓冲区中, 只读.
+ * 每个节点的第一个字: 高 8 位为 lept_type, 接着 8 位为 LEPT_FLAG_INT64/UINT64, 低 48 位为 payload.
+ *   null/false/true  1 个字
+ *   number           2 个字, 第二个字为 double / int64 / uint64 的位
+ *   string           2 个字, payload 为在 strings 中的偏移, 第二个字为长度 (字符串后面有 '\0')
+ *   array/object     2 个字, payload 为下一个兄弟节点的位置, 第二个字为元素/成员个数;
+ *                    子节点紧跟在后面, 对象的成员为 key (string 节点) 和值交替
+ */
+#define LEPT_TAPE_WORD(type, flags, payload) ((uint64_t)(type) << 56 | (uint64_t)(flags) << 48 | (uint64_t)(payload))
+#define LEPT_TAPE_TYPE(w) ((lept_type)((w) >> 56))
+#define LEPT_TAPE_FLAGS(w) ((unsigned char)((w) >> 48))
+#define LEPT_TAPE_PAYLOAD(w) ((w) & (((uint64_t)1 << 48) - 1))
+
+static lept_value* lept_append_object_member(lept_value* v, const char* key, size_t klen); // 向前申明
+
+/* 构建 tape 时的状态: 还没有结束的容器的位置 */
+typedef struct {
+    lept_tape* t;
+    size_t capacity, strings_capacity;
+    size_t* open;
+    size_t depth, open_capacity;
+} lept_tape_builder;
+
+static uint64_t* lept_tape_push (lept_tape_builder* b, size_t n) {
+    lept_tape* t = b->t;
+    if (t->size + n > b->capacity) {
+        if (b->capacity == 0)
+            b->capacity = LEPT_PARSE_STACK_INIT_SIZE / sizeof(uint64_t);
+        while (t->size + n > b->capacity)
+            b->capacity += b->capacity >> 1;
+        t->words = (uint64_t*)realloc(t->words, b->capacity * sizeof(uint64_t));
+    }
+    t->size += n;
+    return t->words + t->size - n;
+}
+
+static void lept_tape_push_string (lept_tape_builder* b, const char* s, size_t len) {
+    lept_tape* t = b->t;
+    uint64_t* w = lept_tape_push(b, 2);
+    if (t->strings_size + len + 1 > b->strings_capacity) {
+        if (b->strings_capacity == 0)
+            b->strings_capacity = LEPT_PARSE_STACK_INIT_SIZE;
+        while (t->strings_size + len + 1 > b->strings_capacity)
+            b->strings_capacity += b->strings_capacity >> 1;
+        t->strings = (char*)realloc(t->strings, b->strings_capacity);
+    }
+    w[0] = LEPT_TAPE_WORD(LEPT_STRING, 0, t->strings_size);
+    w[1] = len;
+    memcpy(t->strings + t->strings_size, s, len);
+    t->strings[t->strings_size + len] = '\0';
+    t->strings_size += len + 1;
+}
+
+static void lept_tape_push_number (lept_tape_builder* b, const lept_value* v) {
+    uint64_t* w = lept_tape_push(b, 2);
+    unsigned char flags = v->flags & (LEPT_FLAG_INT64 | LEPT_FLAG_UINT64);
+    w[0] = LEPT_TAPE_WORD(LEPT_NUMBER, flags, 0);
+    if (flags & LEPT_FLAG_INT64)
+        w[1] = (uint64_t)v->i;
+    else if (flags & LEPT_FLAG_UINT64)
+        w[1] = v->u;
+    else
+        memcpy(&w[1], &v->n, sizeof(double));
+}
+
+static void lept_tape_open (lept_tape_builder* b, lept_type type) {
+    if (b->depth == b->open_capacity) {
+        b->open_capacity = b->open_capacity == 0 ? 16 : b->open_capacity * 2;
+        b->open = (size_t*)realloc(b->open, b->open_capacity * sizeof(size_t));
+    }
+    b->open[b->depth++] = b->t->size;
+    lept_tape_push(b, 2)[0] = LEPT_TAPE_WORD(type, 0, 0);
+}
+
+static void lept_tape_close (lept_tape_builder* b, size_t size) {
+    uint64_t* w = b->t->words + b->open[--b->depth];
+    w[0] |= b->t->size;
+    w[1] = size;
+}
+
+static int lept_tape_on_null (void* userdata) {
+    lept_tape_push((lept_tape_builder*)userdata, 1)[0] = LEPT_TAPE_WORD(LEPT_NULL, 0, 0);
+    return 1;
+}
+
+static int lept_tape_on_boolean (void* userdata, int b) {
+    lept_tape_push((lept_tape_builder*)userdata, 1)[0] = LEPT_TAPE_WORD(b ? LEPT_TRUE : LEPT_FALSE, 0, 0);
+    return 1;
+}
+
+static int lept_tape_on_number (void* userdata, const lept_value* n) {
+    lept_tape_push_number((lept_tape_builder*)userdata, n);
+    return 1;
+}
+
+static int lept_tape_on_string (void* userdata, const char* s, size_t len) {
+    lept_tape_push_string((lept_tape_builder*)userdata, s, len);
+    return 1;
+}
+
+static int lept_tape_on_start_object (void* userdata) {
+    lept_tape_open((lept_tape_builder*)userdata, LEPT_OBJECT);
+    return 1;
+}
+
+static int lept_tape_on_start_array (void* userdata) {
+    lept_tape_open((lept_tape_builder*)userdata, LEPT_ARRAY);
+    return 1;
+}
+
+static int lept_tape_on_end (void* userdata, size_t size) {
+    lept_tape_close((lept_tape_builder*)userdata, size);
+    return 1;
+}
+
+static const lept_handler lept_tape_handler = {
+    lept_tape_on_null, lept_tape_on_boolean, lept_tape_on_number, lept_tape_on_string, lept_tape_on_string,
+    lept_tape_on_start_object, lept_tape_on_end, lept_tape_on_start_array, lept_tape_on_end
+};
+
+static void lept_tape_builder_init (lept_tape_builder* b, lept_tape* t) {
+    t->words = NULL;
+    t->size = 0;
+    t->strings = NULL;
+    t->strings_size = 0;
+    b->t = t;
+    b->capacity = b->strings_capacity = 0;
+    b->open = NULL;
+    b->depth = b->open_capacity = 0;
+}
+
+/* 构建完成后释放多余的容量 */
+static void lept_tape_builder_finish (lept_tape_builder* b) {
+    lept_tape* t = b->t;
+    if (t->size < b->capacity)
+        t->words = (uint64_t*)realloc(t->words, t->size * sizeof(uint64_t));
+    if (t->strings_size < b->strings_capacity)
+        t->strings = (char*)realloc(t->strings, t->strings_size > 0 ? t->strings_size : 1);
+    free(b->open);
+}
+
+int lept_tape_parse (lept_tape* t, const char* json) {
+    lept_tape_builder b;
+    int ret;
+    assert(t != NULL && json != NULL);
+    lept_tape_builder_init(&b, t);
+    if ((ret = lept_parse_sax(json, &lept_tape_handler, &b)) != LEPT_PARSE_OK) {
+        free(b.open);
+        lept_tape_free(t);
+        return ret;
+    }
+    lept_tape_builder_finish(&b);
+    return LEPT_PARSE_OK;
+}
+
+static void lept_tape_push_value (lept_tape_builder* b, const lept_value* v) {
+    size_t i;
+    switch (v->type) {
+        case LEPT_NUMBER: lept_tape_push_number(b, v); break;
+        case LEPT_STRING: lept_tape_push_string(b, LEPT_STRING(v), LEPT_STRING_LEN(v)); break;
+        case LEPT_ARRAY:
+            lept_tape_open(b, LEPT_ARRAY);
+            for (i = 0; i < v->size; i++)
+                lept_tape_push_value(b, &v->e[i]);
+            lept_tape_close(b, v->size);
+            break;
+        case LEPT_OBJECT:
+            lept_tape_open(b, LEPT_OBJECT);
+            for (i = 0; i < v->o.size; i++) {
+                lept_tape_push_string(b, LEPT_KEY(&v->o.m[i]), LEPT_KEY_LEN(&v->o.m[i]));
+                lept_tape_push_value(b, &v->o.m[i].v);
+            }
+            lept_tape_close(b, v->o.size);
+            break;
+        default: lept_tape_push(b, 1)[0] = LEPT_TAPE_WORD(v->type, 0, 0); break;
+    }
+}
+
+void lept_tape_from_value (lept_tape* t, const lept_value* v) {
+    lept_tape_builder b;
+    assert(t != NULL && v != NULL);
+    lept_tape_builder_init(&b, t);
+    lept_tape_push_value(&b, v);
+    lept_tape_builder_finish(&b);
+}
+
+void lept_tape_to_value (const lept_tape* t, size_t node, lept_value* v) {
+    size_t i, size, k;
+    assert(t != NULL && node < t->size && v != NULL);
+    switch (lept_tape_get_type(t, node)) {
+        case LEPT_NUMBER:
+            lept_init(v);
+            v->type = LEPT_NUMBER;
+            v->flags = LEPT_TAPE_FLAGS(t->words[node]);
+            memcpy(&v->n, &t->words[node + 1], sizeof(double)); // 和 i / u 共用同一个位置
+            break;
+        case LEPT_STRING:
+            lept_init(v);
+            lept_set_string(v, lept_tape_get_string(t, node), lept_tape_get_string_length(t, node));
+            break;
+        case LEPT_ARRAY:
+            size = lept_tape_get_size(t, node);
+            lept_init(v);
+            lept_set_array(v, size);
+            for (i = 0, k = lept_tape_child(t, node); i < size; i++, k = lept_tape_next(t, k))
+                lept_tape_to_value(t, k, lept_pushback_array_element(v));
+            break;
+        case LEPT_OBJECT:
+            size = lept_tape_get_size(t, node);
+            lept_init(v);
+            lept_set_object(v, size);
+            /* 和 lept_parse 一样保留重复的 key */
+            for (i = 0, k = lept_tape_child(t, node); i < size; i++, k = lept_tape_next(t, k + 2))
+                lept_tape_to_value(t, k + 2, lept_append_object_member(v, lept_tape_get_string(t, k), lept_tape_get_string_length(t, k)));
+            break;
+        default:
+            lept_init(v);
+            v->type = lept_tape_get_type(t, node);
+            break;
+    }
+}
+
+void lept_tape_free (lept_tape* t) {
+    assert(t != NULL);
+    free(t->words);
+    free(t->strings);
+    t->words = NULL;
+    t->strings = NULL;
+    t->size = t->strings_size = 0;
+}
+
+lept_type lept_tape_get_type (const lept_tape* t, size_t node) {
+    assert(t != NULL && node < t->size);
+    return LEPT_TAPE_TYPE(t->words[node]);
+}
+
+size_t lept_tape_next (const lept_tape* t, size_t node) {
+    assert(t != NULL && node < t->size);
+    switch (LEPT_TAPE_TYPE(t->words[node])) {
+        case LEPT_NUMBER:
+        case LEPT_STRING: return node + 2;
+        case LEPT_ARRAY:
+        case LEPT_OBJECT: return (size_t)LEPT_TAPE_PAYLOAD(t->words[node]);
+        default: return node + 1;
+    }
+}
+
+size_t lept_tape_child (const lept_tape* t, size_t node) {
+    assert(t != NULL && node < t->size);
+    assert(LEPT_TAPE_TYPE(t->words[node]) == LEPT_ARRAY || LEPT_TAPE_TYPE(t->words[node]) == LEPT_OBJECT);
+    return node + 2;
+}
+
+size_t lept_tape_get_size (const lept_tape* t, size_t node) {
+    assert(t != NULL && node < t->size);
+    assert(LEPT_TAPE_TYPE(t->words[node]) == LEPT_ARRAY || LEPT_TAPE_TYPE(t->words[node]) == LEPT_OBJECT);
+    return (size_t)t->words[node + 1];
+}
+
+size_t lept_tape_find (const lept_tape* t, size_t node, const char* key, size_t klen) {
+    size_t i, size, k;
+    assert(t != NULL && node < t->size && LEPT_TAPE_TYPE(t->words[node]) == LEPT_OBJECT);
+    size = (size_t)t->words[node + 1];
+    for (i = 0, k = node + 2; i < size; i++, k = lept_tape_next(t, k + 2))
+        if (t->words[k + 1] == klen && memcmp(t->strings + LEPT_TAPE_PAYLOAD(t->words[k]), key, klen) == 0)
+            return k + 2;
+    return LEPT_KEY_NOT_EXIST;
+}
+
+int lept_tape_get_boolean (const lept_tape* t, size_t node) {
+    assert(t != NULL && node < t->size);
+    assert(LEPT_TAPE_TYPE(t->words[node]) == LEPT_TRUE || LEPT_TAPE_TYPE(t->words[node]) == LEPT_FALSE);
+    return LEPT_TAPE_TYPE(t->words[node]) == LEPT_TRUE;
+}
+
+double lept_tape_get_number (const lept_tape* t, size_t node) {
+    lept_value v;
+    assert(t != NULL && node < t->size && LEPT_TAPE_TYPE(t->words[node]) == LEPT_NUMBER);
+    lept_tape_to_value(t, node, &v);
+    return lept_get_number(&v);
+}
+
+const char* lept_tape_get_string (const lept_tape* t, size_t node) {
+    assert(t != NULL && node < t->size && LEPT_TAPE_TYPE(t->words[node]) == LEPT_STRING);
+    return t->strings + LEPT_TAPE_PAYLOAD(t->words[node]);
+}
+
+size_t lept_tape_get_string_length (const lept_tape* t, size_t node) {
+    assert(t != NULL && node < t->size && LEPT_TAPE_TYPE(t->words[node]) == LEPT_STRING);
+    return (size_t)t->words[node + 1];
+}
+
+/*
+ * 快照: 文件头 3 个字 (magic, words 的个数, strings 的长度), 接着是 words 和 strings.
+ * 节点的编码和 tape 相同, 数组/对象在前 2 个字后面多了一个表, 每个元素/成员一个字:
+ *   array   第 i 个元素的位置
+ *   object  key 节点的位置, 按 (key 长度, key 的字节, 位置) 排序; 成员本身仍然按原来的顺序跟在表后面
+ * 位置都是相对于 words 和 strings 的, 映射到任何地址都可以直接使用.
+ */
+#define LEPT_SNAPSHOT_MAGIC 0x31504E535450454CULL // 小端的 "LEPTSNP1", 字节序不同时不匹配
+#define LEPT_SNAPSHOT_HEAD 3
+
+typedef struct {
+    const char* key;
+    size_t klen;
+    uint64_t node;
+} lept_snapshot_key;
+
+static int lept_snapshot_key_cmp (const void* a, const void* b) {
+    const lept_snapshot_key* x = (const lept_snapshot_key*)a;
+    const lept_snapshot_key* y = (const lept_snapshot_key*)b;
+    int c;
+    if (x->klen != y->klen)
+        return x->klen < y->klen ? -1 : 1;
+    if ((c = memcmp(x->key, y->key, x->klen)) != 0)
+        return c;
+    return x->node < y->node ? -1 : x->node > y->node; // 重复的 key 保持原来的顺序
+}
+
+static void lept_snapshot_push_value (lept_tape_builder* b, const lept_value* v) {
+    size_t node = b->t->size, i;
+    uint64_t* w;
+    lept_snapshot_key* keys;
+    switch (v->type) {
+        case LEPT_ARRAY:
+            w = lept_tape_push(b, 2 + v->size);
+            w[0] = LEPT_TAPE_WORD(LEPT_ARRAY, 0, 0);
+            w[1] = v->size;
+            for (i = 0; i < v->size; i++) {
+                b->t->words[node + 2 + i] = b->t->size; // push 之后 words 可能移动
+                lept_snapshot_push_value(b, &v->e[i]);
+            }
+            b->t->words[node] |= b->t->size;
+            break;
+        case LEPT_OBJECT:
+            w = lept_tape_push(b, 2 + v->o.size);
+            w[0] = LEPT_TAPE_WORD(LEPT_OBJECT, 0, 0);
+            w[1] = v->o.size;
+            keys = (lept_snapshot_key*)malloc((v->o.size > 0 ? v->o.size : 1) * sizeof(lept_snapshot_key));
+            for (i = 0; i < v->o.size; i++) {
+                keys[i].key = LEPT_KEY(&v->o.m[i]);
+                keys[i].klen = LEPT_KEY_LEN(&v->o.m[i]);
+                keys[i].node = b->t->size;
+                lept_tape_push_string(b, keys[i].key, keys[i].klen);
+                lept_snapshot_push_value(b, &v->o.m[i].v);
+            }
+            qsort(keys, v->o.size, sizeof(lept_snapshot_key), lept_snapshot_key_cmp);
+            for (i = 0; i < v->o.size; i++)
+                b->t->words[node + 2 + i] = keys[i].node;
+            free(keys);
+            b->t->words[node] |= b->t->size;
+            break;
+        default:
+            lept_tape_push_value(b, v); // 标量和 tape 相同
+            break;
+    }
+}
+
+int lept_snapshot_write (const lept_value* v, const char* path) {
+    lept_tape t;
+    lept_tape_builder b;
+    uint64_t head[LEPT_SNAPSHOT_HEAD];
+    FILE* fp;
+    int ret = 0, e = 0;
+    assert(v != NULL && path != NULL);
+    lept_tape_builder_init(&b, &t);
+    lept_snapshot_push_value(&b, v);
+    free(b.open);
+    head[0] = LEPT_SNAPSHOT_MAGIC;
+    head[1] = t.size;
+    head[2] = t.strings_size;
+    if ((fp = fopen(path, "wb")) == NULL)
+        ret = LEPT_FILE_IO_ERROR;
+    else {
+        if (fwrite(head, sizeof(uint64_t), LEPT_SNAPSHOT_HEAD, fp) != LEPT_SNAPSHOT_HEAD
+            || fwrite(t.words, sizeof(uint64_t), t.size, fp) != t.size
+            || fwrite(t.strings, 1, t.strings_size, fp) != t.strings_size) {
+            e = errno;
+            ret = LEPT_FILE_IO_ERROR;
+        }
+        if (fclose(fp) != 0 && ret == 0) {
+            e = errno;
+            ret = LEPT_FILE_IO_ERROR;
+        }
+        if (ret != 0)
+            errno = e;
+    }
+    lept_tape_free(&t);
+    return ret;
+}
+
+int lept_snapshot_view (lept_snapshot* s, const void* data, size_t size) {
+    const uint64_t* head = (const uint64_t*)data;
+    size_t rest;
+    assert(s != NULL && (data != NULL || size == 0) && ((uintptr_t)data & 7) == 0);
+    s->words = NULL;
+    s->size = 0;
+    s->strings = NULL;
+    s->strings_size = 0;
+    s->map.data = NULL;
+    s->map.size = 0;
+    /* 只检查文件头和长度, 不遍历节点 */
+    if (size < LEPT_SNAPSHOT_HEAD * sizeof(uint64_t) || head[0] != LEPT_SNAPSHOT_MAGIC)
+        return LEPT_SNAPSHOT_INVALID;
+    rest = size - LEPT_SNAPSHOT_HEAD * sizeof(uint64_t);
+    if (head[1] == 0 || head[1] > rest / sizeof(uint64_t) || head[2] != rest - head[1] * sizeof(uint64_t))
+        return LEPT_SNAPSHOT_INVALID;
+    if (head[2] > 0 && ((const char*)data)[size - 1] != '\0') // 每个字符串后面都有 '\0'
+        return LEPT_SNAPSHOT_INVALID;
+    s->words = head + LEPT_SNAPSHOT_HEAD;
+    s->size = (size_t)head[1];
+    s->strings = (const char*)(s->words + s->size);
+    s->strings_size = (size_t)head[2];
+    return LEPT_PARSE_OK;
+}
+
+int lept_snapshot_open (lept_snapshot* s, const char* path, int flags) {
+    lept_file_map map;
+    int ret;
+    assert(s != NULL && path != NULL);
+    if (lept_map_file(path, flags, 0, &map) != LEPT_PARSE_OK) {
+        lept_snapshot_view(s, NULL, 0); // 清空 s
+        return LEPT_FILE_IO_ERROR;
+    }
+#if defined(LEPT_POSIX)
+    if (map.data != NULL)
+        madvise(map.data, map.size, MADV_RANDOM); // 按下标和 key 跳着访问, 不需要预读
+#endif
+    if ((ret = lept_snapshot_view(s, map.data, map.size)) != LEPT_PARSE_OK)
+        lept_file_unmap(&map);
+    else
+        s->map = map;
+    return ret;
+}
+
+void lept_snapshot_close (lept_snapshot* s) {
+    assert(s != NULL);
+    lept_file_unmap(&s->map);
+    s->words = NULL;
+    s->strings = NULL;
+    s->size = s->strings_size = 0;
+}
+
+#define LEPT_SNAPSHOT_IS(s, node, t) (LEPT_TAPE_TYPE((s)->words[node]) == (t))
+
+void lept_snapshot_to_value (const lept_snapshot* s, size_t node, lept_value* v) {
+    size_t i, size, k;
+    assert(s != NULL && node < s->size && v != NULL);
+    lept_init(v);
+    switch (lept_snapshot_get_type(s, node)) {
+        case LEPT_NUMBER:
+            v->type = LEPT_NUMBER;
+            v->flags = LEPT_TAPE_FLAGS(s->words[node]);
+            memcpy(&v->n, &s->words[node + 1], sizeof(double));
+            break;
+        case LEPT_STRING:
+            lept_set_string(v, lept_snapshot_get_string(s, node), lept_snapshot_get_string_length(s, node));
+            break;
+        case LEPT_ARRAY:
+            size = lept_snapshot_get_size(s, node);
+            lept_set_array(v, size);
+            for (i = 0; i < size; i++)
+                lept_snapshot_to_value(s, lept_snapshot_get_element(s, node, i), lept_pushback_array_element(v));
+            break;
+        case LEPT_OBJECT:
+            size = lept_snapshot_get_size(s, node);
+            lept_set_object(v, size);
+            for (i = 0, k = lept_snapshot_child(s, node); i < size; i++, k = lept_snapshot_next(s, k + 2))
+                lept_snapshot_to_value(s, k + 2, lept_append_object_member(v, lept_snapshot_get_string(s, k), lept_snapshot_get_string_length(s, k)));
+            break;
+        default:
+            v->type = lept_snapshot_get_type(s, node);
+            break;
+    }
+}
+
+lept_type lept_snapshot_get_type (const lept_snapshot* s, size_t node) {
+    assert(s != NULL && node < s->size);
+    return LEPT_TAPE_TYPE(s->words[node]);
+}
+
+size_t lept_snapshot_next (const lept_snapshot* s, size_t node) {
+    assert(s != NULL && node < s->size);
+    switch (LEPT_TAPE_TYPE(s->words[node])) {
+        case LEPT_NUMBER:
+        case LEPT_STRING: return node + 2;
+        case LEPT_ARRAY:
+        case LEPT_OBJECT: return (size_t)LEPT_TAPE_PAYLOAD(s->words[node]);
+        default: return node + 1;
+    }
+}
+
+size_t lept_snapshot_child (const lept_snapshot* s, size_t node) {
+    assert(s != NULL && node < s->size && (LEPT_SNAPSHOT_IS(s, node, LEPT_ARRAY) || LEPT_SNAPSHOT_IS(s, node, LEPT_OBJECT)));
+    return node + 2 + (size_t)s->words[node + 1]; // 跳过表
+}
+
+size_t lept_snapshot_get_size (const lept_snapshot* s, size_t node) {
+    assert(s != NULL && node < s->size && (LEPT_SNAPSHOT_IS(s, node, LEPT_ARRAY) || LEPT_SNAPSHOT_IS(s, node, LEPT_OBJECT)));
+    return (size_t)s->words[node + 1];
+}
+
+size_t lept_snapshot_get_element (const lept_snapshot* s, size_t node, size_t index) {
+    assert(s != NULL && node < s->size && LEPT_SNAPSHOT_IS(s, node, LEPT_ARRAY) && index < s->words[node + 1]);
+    return (size_t)s->words[node + 2 + index];
+}
+
+size_t lept_snapshot_find (const lept_snapshot* s, size_t node, const char* key, size_t klen) {
+    const uint64_t* table;
+    size_t lo = 0, hi, mid, k;
+    int c;
+    assert(s != NULL && node < s->size && LEPT_SNAPSHOT_IS(s, node, LEPT_OBJECT) && (key != NULL || klen == 0));
+    table = s->words + node + 2;
+    hi = (size_t)s->words[node + 1];
+    /* 第一个不小于 key 的位置, 重复的 key 返回第一个 */
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        k = (size_t)table[mid];
+        if (s->words[k + 1] != klen)
+            c = s->words[k + 1] < klen ? -1 : 1;
+        else
+            c = memcmp(s->strings + LEPT_TAPE_PAYLOAD(s->words[k]), key, klen);
+        if (c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < (size_t)s->words[node + 1]) {
+        k = (size_t)table[lo];
+        if (s->words[k + 1] == klen && memcmp(s->strings + LEPT_TAPE_PAYLOAD(s->words[k]), key, klen) == 0)
+            return k + 2;
+    }
+    return LEPT_KEY_NOT_EXIST;
+}
+
+int lept_snapshot_get_boolean (const lept_snapshot* s, size_t node) {
+    assert(s != NULL && node < s->size && (LEPT_SNAPSHOT_IS(s, node, LEPT_TRUE) || LEPT_SNAPSHOT_IS(s, node, LEPT_FALSE)));
+    return LEPT_SNAPSHOT_IS(s, node, LEPT_TRUE);
+}
+
+double lept_snapshot_get_number (const lept_snapshot* s, size_t node) {
+    lept_value v;
+    assert(s != NULL && node < s->size && LEPT_SNAPSHOT_IS(s, node, LEPT_NUMBER));
+    lept_snapshot_to_value(s, node, &v);
+    return lept_get_number(&v);
+}
+
+const char* lept_snapshot_get_string (const lept_snapshot* s, size_t node) {
+    assert(s != NULL && node < s->size && LEPT_SNAPSHOT_IS(s, node, LEPT_STRING));
+    return s->strings + LEPT_TAPE_PAYLOAD(s->words[node]);
+}
+
+size_t lept_snapshot_get_string_length (const lept_snapshot* s, size_t node) {
+    assert(s != NULL && node < s->size && LEPT_SNAPSHOT_IS(s, node, LEPT_STRING));
+    return (size_t)s->words[node + 1];
+}
+
+/*
+ * n (不超过 32) 个字节中 '"', '\\', '[', ']', '{' 和 '}' 的位置, 第 i 位对应 p[i]
+ * '[' / ']' 和 '{' / '}' 只差 0x20 这一位
+ */
+static unsigned lept_bracket_mask (const char* p, size_t n) {
+    unsigned mask = 0;
+    size_t i;
+#if defined(LEPT_AVX2)
+    if (n == 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)p);
+        __m256i t = _mm256_or_si256(s, _mm256_set1_epi8(0x20));
+        return (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('\"')), _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(t, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(t, _mm256_set1_epi8('}')))));
+    }
+#elif defined(LEPT_SSE2)
+    if (n == 32) {
+        for (i = 0; i < 32; i += 16) {
+            __m128i s = _mm_loadu_si128((const __m128i*)(p + i));
+            __m128i t = _mm_or_si128(s, _mm_set1_epi8(0x20));
+            mask |= (unsigned)_mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\\'))),
+                    _mm_or_si128(_mm_cmpeq_epi8(t, _mm_set1_epi8('{')), _mm_cmpeq_epi8(t, _mm_set1_epi8('}'))))) << i;
+        }
+        return mask;
+    }
+#endif
+    for (i = 0; i < n; i++)
+        if (p[i] == '\"' || p[i] == '\\' || (p[i] | 0x20) == '{' || (p[i] | 0x20) == '}')
+            mask |= 1u << i;
+    return mask;
+}
+
+/* p 指向 '"', 返回字符串之后的位置, 没有结束时返回 NULL */
+static const char* lept_skip_string (const char* p, const char* end) {
+    for (p++;;) {
+        p = lept_scan_string(p, end);
+        if (p == end)
+            return NULL;
+        if (*p == '\"')
+            return p + 1;
+        if (*p == '\\' && ++p == end) // 转义的字符不会结束字符串
+            return NULL;
+        p++; // 控制字符不检查
+    }
+}
+
+/*
+ * 跳过 p 开始的一个值, 只匹配引号和括号, 不检查内容; 没有结束时返回 NULL
+ * 数组和对象每次取 32 个字节的掩码, 逐位处理其中所有的引号和括号, 字符串内的括号不计数
+ */
+static const char* lept_skip_value (const char* p, const char* end) {
+    size_t depth = 0, n;
+    int in_string = 0;
+    if (*p == '\"')
+        return lept_skip_string(p, end);
+    if (*p != '[' && *p != '{') {
+        while (p < end && !ISWHITESPACE(*p) && *p != ',' && *p != ']' && *p != '}')
+            p++;
+        return p;
+    }
+    for (; p < end; p += n) {
+        unsigned mask;
+        n = end - p < 32 ? (size_t)(end - p) : 32;
+        mask = lept_bracket_mask(p, n);
+        while (mask != 0) {
+            int i = lept_ctz64(mask);
+            char ch = p[i];
+            mask &= mask - 1;
+            if (in_string) {
+                if (ch == '\"')
+                    in_string = 0;
+                else if (ch == '\\') { // 跳过转义的字符, 它在下一块时 n 多加 1
+                    if ((size_t)i + 1 < n)
+                        mask &= ~(1u << (i + 1));
+                    else
+                        n++;
+                }
+            }
+            else if (ch == '\"')
+                in_string = 1;
+            else if ((ch | 0x20) == '{')
+                depth++;
+            else if ((ch | 0x20) == '}' && --depth == 0)
+                return p + i + 1;
+        }
+    }
+    return NULL;
+}
+
+static const char* lept_skip_whitespace (const char* p, const char* end) {
+    lept_context c;
+    c.json = p;
+    c.end = end;
+    lept_parse_whitespace(&c);
+    return c.json;
+}
+
+/* 用 doc 的缓冲区作为词法分析的栈 */
+static void lept_doc_context (lept_context* c, lept_doc* d, const char* json) {
+    c->json = json;
+    c->end = d->end;
+    c->stack = d->stack;
+    c->size = d->size;
+    c->top = 0;
+    c->arena = NULL;
+    c->keys = NULL;
+    c->insitu = 0;
+}
+
+static void lept_doc_release (lept_context* c, lept_doc* d) {
+    d->stack = c->stack;
+    d->size = c->size;
+}
+
+void lept_doc_init (lept_doc* d, const char* json, size_t len) {
+    assert(d != NULL && (json != NULL || len == 0));
+    d->json = json;
+    d->end = json + len;
+    d->stack = NULL;
+    d->size = 0;
+}
+
+void lept_doc_free (lept_doc* d) {
+    assert(d != NULL);
+    free(d->stack);
+    d->stack = NULL;
+    d->size = 0;
+}
+
+int lept_doc_root (lept_doc* d, lept_cursor* c) {
+    assert(d != NULL && c != NULL);
+    c->doc = d;
+    c->json = lept_skip_whitespace(d->json, d->end);
+    c->key = NULL;
+    c->key_len = 0;
+    return c->json != d->end ? LEPT_PARSE_OK : LEPT_PARSE_EXPECT_VALUE;
+}
+
+lept_type lept_cursor_get_type (const lept_cursor* c) {
+    assert(c != NULL);
+    switch (*c->json) {
+        case 'n': return LEPT_NULL;
+        case 't': return LEPT_TRUE;
+        case 'f': return LEPT_FALSE;
+        case '\"': return LEPT_STRING;
+        case '[': return LEPT_ARRAY;
+        case '{': return LEPT_OBJECT;
+        default: return LEPT_NUMBER;
+    }
+}
+
+/* p 指向对象成员的 key, 把 c 移到这个成员的值 */
+static int lept_cursor_member (lept_cursor* c, const char* p) {
+    const char* end = c->doc->end;
+    const char* q;
+    if (p == end || *p != '\"')
+        return LEPT_PARSE_MISS_KEY;
+    if ((q = lept_skip_string(p, end)) == NULL)
+        return LEPT_PARSE_MISS_QUOTATION_MARK;
+    c->key = p;
+    c->key_len = q - p - 2;
+    q = lept_skip_whitespace(q, end);
+    if (q == end || *q != ':')
+        return LEPT_PARSE_MISS_COLON;
+    if ((q = lept_skip_whitespace(q + 1, end)) == end)
+        return LEPT_PARSE_EXPECT_VALUE;
+    c->json = q;
+    return LEPT_PARSE_OK;
+}
+
+int lept_cursor_child (const lept_cursor* c, lept_cursor* out) {
+    const char* end;
+    const char* p;
+    char close;
+    assert(c != NULL && out != NULL && (*c->json == '[' || *c->json == '{'));
+    end = c->doc->end;
+    close = *c->json == '[' ? ']' : '}';
+    p = lept_skip_whitespace(c->json + 1, end);
+    out->doc = c->doc;
+    out->key = NULL;
+    out->key_len = 0;
+    if (p != end && *p == close)
+        return LEPT_CURSOR_END;
+    if (close == '}')
+        return lept_cursor_member(out, p);
+    if (p == end)
+        return LEPT_PARSE_EXPECT_VALUE;
+    out->json = p;
+    return LEPT_PARSE_OK;
+}
+
+int lept_cursor_next (lept_cursor* c) {
+    const char* end;
+    const char* p;
+    assert(c != NULL);
+    end = c->doc->end;
+    if ((p = lept_skip_value(c->json, end)) == NULL)
+        return *c->json == '\"' ? LEPT_PARSE_MISS_QUOTATION_MARK :
+            *c->json == '[' ? LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    p = lept_skip_whitespace(p, end);
+    if (p != end && *p == ',') {
+        p = lept_skip_whitespace(p + 1, end);
+        if (c->key != NULL)
+            return lept_cursor_member(c, p);
+        if (p == end)
+            return LEPT_PARSE_EXPECT_VALUE;
+        c->json = p;
+        return LEPT_PARSE_OK;
+    }
+    if (p != end && *p == (c->key != NULL ? '}' : ']'))
+        return LEPT_CURSOR_END;
+    return c->key != NULL ? LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET : LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+}
+
+/* 解码 p 开始的字符串 */
+static int lept_doc_string (lept_doc* d, const char* p, const char** s, size_t* len) {
+    lept_context c;
+    char* str;
+    int ret;
+    lept_doc_context(&c, d, p);
+    if ((ret = lept_parse_string_raw(&c, &str, len)) == LEPT_PARSE_OK)
+        *s = str;
+    lept_doc_release(&c, d);
+    return ret;
+}
+
+int lept_cursor_get_key (const lept_cursor* c, const char** key, size_t* len) {
+    assert(c != NULL && c->key != NULL && key != NULL && len != NULL);
+    return lept_doc_string(c->doc, c->key, key, len);
+}
+
+int lept_cursor_get_string (const lept_cursor* c, const char** s, size_t* len) {
+    assert(c != NULL && *c->json == '\"' && s != NULL && len != NULL);
+    return lept_doc_string(c->doc, c->json, s, len);
+}
+
+int lept_cursor_find (const lept_cursor* c, const char* key, size_t klen, lept_cursor* out) {
+    int ret;
+    assert(c != NULL && *c->json == '{' && (key != NULL || klen == 0) && out != NULL);
+    for (ret = lept_cursor_child(c, out); ret == LEPT_PARSE_OK; ret = lept_cursor_next(out)) {
+        const char* k;
+        size_t len;
+        if (out->key_len < klen) // 转义只会让 JSON 中的 key 更长
+            continue;
+        if (memchr(out->key + 1, '\\', out->key_len) == NULL) { // 没有转义, 直接比较原始内容
+            if (out->key_len == klen && memcmp(out->key + 1, key, klen) == 0)
+                return LEPT_PARSE_OK;
+        } else if ((ret = lept_cursor_get_key(out, &k, &len)) != LEPT_PARSE_OK)
+            return ret;
+        else if (len == klen && memcmp(k, key, klen) == 0)
+            return LEPT_PARSE_OK;
+    }
+    return ret;
+}
+
+/* 标量之后只能是空白、',' 或结束括号, 否则 123abc 和 truex 也会被当作合法的值 */
+static int lept_cursor_scalar_end (const lept_context* c) {
+    char ch = PEEK(c);
+    return c->json == c->end || ISWHITESPACE(ch) || ch == ',' || ch == ']' || ch == '}';
+}
+
+int lept_cursor_get_boolean (const lept_cursor* c, int* b) {
+    lept_context ctx;
+    lept_value v;
+    int ret;
+    assert(c != NULL && b != NULL);
+    lept_doc_context(&ctx, c->doc, c->json);
+    lept_init(&v);
+    if (*c->json == 't')
+        ret = lept_parse_literal(&ctx, &v, "true", LEPT_TRUE);
+    else if (*c->json == 'f')
+        ret = lept_parse_literal(&ctx, &v, "false", LEPT_FALSE);
+    else
+        return LEPT_PARSE_INVALID_VALUE;
+    if (ret != LEPT_PARSE_OK)
+        return ret;
+    if (!lept_cursor_scalar_end(&ctx))
+        return LEPT_PARSE_INVALID_VALUE;
+    *b = v.type == LEPT_TRUE;
+    return LEPT_PARSE_OK;
+}
+
+int lept_cursor_get_number (const lept_cursor* c, double* n) {
+    lept_context ctx;
+    lept_value v;
+    int ret;
+    assert(c != NULL && n != NULL);
+    lept_doc_context(&ctx, c->doc, c->json);
+    lept_init(&v);
+    if ((ret = lept_parse_number(&ctx, &v)) != LEPT_PARSE_OK)
+        return ret;
+    if (!lept_cursor_scalar_end(&ctx))
+        return LEPT_PARSE_INVALID_VALUE;
+    *n = lept_get_number(&v);
+    return LEPT_PARSE_OK;
+}
+
+int lept_cursor_get_value (const lept_cursor* c, lept_value* v) {
+    lept_context ctx;
+    int ret;
+    assert(c != NULL && v != NULL);
+    lept_doc_context(&ctx, c->doc, c->json);
+    lept_init(v);
+    ret = lept_parse_value(&ctx, v);
+    assert(ctx.top == 0);
+    lept_doc_release(&ctx, c->doc);
+    return ret;
+}
+
+/*
+ * 增量解析: 输入按任意长度分块提供.
+ * 用状态机代替递归, 未完成的数组/对象的元素和成员和 lept_parse 一样暂存在 c.stack 中.
+ * 分块中完整的 token (字符串、数字、字面量) 直接交给 lept_parse_* 解析;
+ * 被分块截断的 token 复制到 token 缓冲区, 等后面的分块补全后再解析, 所以内存只和单个 token 有关.
+ */
+enum {
+    LEPT_STREAM_VALUE,        // 期望一个值
+    LEPT_STREAM_ARRAY_FIRST,  // '[' 之后, 期望值或 ']'
+    LEPT_STREAM_OBJECT_FIRST, // '{' 之后, 期望 key 或 '}'
+    LEPT_STREAM_KEY,          // 对象中 ',' 之后
+    LEPT_STREAM_COLON,        // key 之后
+    LEPT_STREAM_AFTER_VALUE,  // 容器中的值之后, 期望 ',' 或结束括号
+    LEPT_STREAM_DONE,         // 根值已经完成, 只允许空白
+    LEPT_STREAM_FINISHED
+};
+
+enum { LEPT_TOKEN_NONE, LEPT_TOKEN_VALUE, LEPT_TOKEN_KEY };
+
+typedef struct {
+    lept_type type; // LEPT_ARRAY 或 LEPT_OBJECT
+    size_t size; // 已经在 c.stack 中的元素/成员个数, 包括还没有值的成员
+} lept_stream_frame;
+
+struct lept_stream_parser {
+    lept_context c;
+    lept_value* v;
+    lept_stream_frame* frames;
+    size_t depth, frame_capacity;
+    int state, ret;
+    int token; // 被截断的 token, LEPT_TOKEN_NONE 表示没有
+    int escaped; // 被截断的字符串以没有配对的 '\\' 结尾
+    char* buf; // 被截断的 token 的字节
+    size_t len, size;
+};
+
+#define ISNUMBERCHAR(ch) (ISDIGIT(ch) || (ch) == '-' || (ch) == '+' || (ch) == '.' || (ch) == 'e' || (ch) == 'E')
+
+static void lept_stream_init(lept_stream_parser* p, lept_value* v) {
+    memset(p, 0, sizeof(lept_stream_parser));
+    lept_init(v);
+    p->v = v;
+    p->state = LEPT_STREAM_VALUE;
+    p->ret = LEPT_PARSE_OK;
+    p->token = LEPT_TOKEN_NONE;
+}
+
+lept_stream_parser* lept_stream_create(lept_value* v) {
+    lept_stream_parser* p = (lept_stream_parser*)malloc(sizeof(lept_stream_parser));
+    assert(v != NULL);
+    lept_stream_init(p, v);
+    return p;
+}
+
+/* 释放 c.stack 中还没有组装起来的元素和成员 */
+static void lept_stream_release(lept_stream_parser* p) {
+    size_t i;
+    while (p->depth > 0) {
+        lept_stream_frame* f = &p->frames[--p->depth];
+        for (i = 0; i < f->size; i++) {
+            if (f->type == LEPT_ARRAY)
+                lept_free((lept_value*)lept_context_pop(&p->c, sizeof(lept_value)));
+            else {
+                lept_member* m = (lept_member*)lept_context_pop(&p->c, sizeof(lept_member));
+                if (!LEPT_KEY_IS_SHORT(m))
+                    free(m->k);
+                lept_free(&m->v);
+            }
+        }
+    }
+    assert(p->c.top == 0);
+}
+
+static void lept_stream_cleanup(lept_stream_parser* p) {
+    lept_stream_release(p);
+    free(p->c.stack);
+    free(p->frames);
+    free(p->buf);
+}
+
+void lept_stream_destroy(lept_stream_parser* p) {
+    if (p == NULL)
+        return;
+    lept_stream_cleanup(p);
+    free(p);
+}
+
+/* 一个值完成后放到父容器中 */
+static void lept_stream_emit(lept_stream_parser* p, lept_value* e) {
+    lept_stream_frame* f;
+    if (p->depth == 0) {
+        memcpy(p->v, e, sizeof(lept_value));
+        p->state = LEPT_STREAM_DONE;
+        return;
+    }
+    f = &p->frames[p->depth - 1];
+    if (f->type == LEPT_ARRAY) {
+        memcpy(lept_context_push(&p->c, sizeof(lept_value)), e, sizeof(lept_value));
+        f->size++;
+    } else /* key 解析时成员已经入栈 */
+        memcpy(&((lept_member*)(p->c.stack + p->c.top - sizeof(lept_member)))->v, e, sizeof(lept_value));
+    p->state = LEPT_STREAM_AFTER_VALUE;
+}
+
+static void lept_stream_open(lept_stream_parser* p, lept_type type) {
+    if (p->depth == p->frame_capacity) {
+        p->frame_capacity = p->frame_capacity == 0 ? 16 : p->frame_capacity * 2;
+        p->frames = (lept_stream_frame*)realloc(p->frames, p->frame_capacity * sizeof(lept_stream_frame));
+    }
+    p->frames[p->depth].type = type;
+    p->frames[p->depth].size = 0;
+    p->depth++;
+    p->state = type == LEPT_ARRAY ? LEPT_STREAM_ARRAY_FIRST : LEPT_STREAM_OBJECT_FIRST;
+}
+
+static void lept_stream_close(lept_stream_parser* p) {
+    lept_stream_frame* f = &p->frames[--p->depth];
+    lept_value e;
+    lept_init(&e);
+    if (f->type == LEPT_ARRAY)
+        lept_context_pop_array(&p->c, &e, f->size);
+    else
+        lept_context_pop_object(&p->c, &e, f->size);
+    lept_stream_emit(p, &e);
+}
+
+/* 从 c.json 开始解析一个完整的 token */
+static int lept_stream_token(lept_stream_parser* p, int token) {
+    lept_context* c = &p->c;
+    lept_value e;
+    int ret;
+    lept_init(&e);
+    if (token == LEPT_TOKEN_KEY) {
+        lept_member m;
+        char* str;
+        size_t len;
+        if ((ret = lept_parse_string_raw(c, &str, &len)) != LEPT_PARSE_OK)
+            return ret;
+        /* str 还在 c.stack 中, 先复制出来再压栈 */
+        if (len <= LEPT_SHORT_KEY_MAX)
+            lept_set_short_key(&m, str, len);
+        else {
+            m.k = lept_context_strdup(c, str, len);
+            m.klen = len;
+        }
+        lept_init(&m.v);
+        memcpy(lept_context_push(c, sizeof(lept_member)), &m, sizeof(lept_member));
+        p->frames[p->depth - 1].size++;
+        p->state = LEPT_STREAM_COLON;
+        return LEPT_PARSE_OK;
+    }
+    switch (PEEK(c)) {
+        case 'n': ret = lept_parse_literal(c, &e, "null", LEPT_NULL); break;
+        case 't': ret = lept_parse_literal(c, &e, "true", LEPT_TRUE); break;
+        case 'f': ret = lept_parse_literal(c, &e, "false", LEPT_FALSE); break;
+        case '"': ret = lept_parse_string(c, &e); break;
+        default:  ret = lept_parse_number(c, &e); break;
+    }
+    if (ret == LEPT_PARSE_OK)
+        lept_stream_emit(p, &e);
+    return ret;
+}
+
+/* token 以 first 开头, 已经有 have 个字节; 在 [q, end) 中找 token 的结尾, 找不到时返回 NULL */
+static const char* lept_stream_token_end(lept_stream_parser* p, char first, size_t have, const char* q, const char* end) {
+    switch (first) {
+        case 'n': case 't': case 'f':
+            have = (first == 'f' ? 5 : 4) - have; // 字面量还差的字节数
+            return (size_t)(end - q) >= have ? q + have : NULL;
+        case '"': {
+            const char* r;
+            if (p->escaped && q < end) {
+                q++;
+                p->escaped = 0;
+            }
+            /* 用 memchr 找引号, 前面连续的 '\\' 为偶数个时就是结尾 */
+            for (r = q; ; r++) {
+                const char* b;
+                if ((r = (const char*)memchr(r, '"', end - r)) == NULL)
+                    r = end;
+                for (b = r; b > q && b[-1] == '\\'; b--)
+                    ;
+                if (r == end) {
+                    p->escaped = (r - b) & 1;
+                    return NULL;
+                }
+                if (((r - b) & 1) == 0)
+                    return r + 1;
+            }
+        }
+        default:
+            for (; q < end; q++)
+                if (!ISNUMBERCHAR(*q))
+                    return q;
+            return NULL;
+    }
+}
+
+static int lept_stream_run(lept_stream_parser* p, const char* s, const char* end);
+
+/* 在 token 缓冲区中解析 token; 数字可能没有用完缓冲区 (例如 "0123"), 剩下的部分接着处理 */
+static int lept_stream_flush(lept_stream_parser* p) {
+    int ret, token = p->token;
+    const char* end = p->buf + p->len;
+    p->token = LEPT_TOKEN_NONE;
+    p->escaped = 0;
+    p->len = 0;
+    p->c.json = p->buf;
+    p->c.end = end;
+    if ((ret = lept_stream_token(p, token)) != LEPT_PARSE_OK)
+        return ret;
+    return lept_stream_run(p, p->c.json, end);
+}
+
+static void lept_stream_save(lept_stream_parser* p, const char* s, size_t len) {
+    if (p->len + len + 1 > p->size) {
+        while (p->len + len + 1 > p->size)
+            p->size = p->size == 0 ? 64 : p->size * 2;
+        p->buf = (char*)realloc(p->buf, p->size);
+    }
+    memcpy(p->buf + p->len, s, len);
+    p->len += len;
+    p->buf[p->len] = '\0';
+}
+
+/* 从 s 开始一个 token, 返回 token 之后的位置; token 被截断时保存起来并返回 end */
+static const char* lept_stream_start_token(lept_stream_parser* p, int token, const char* s, const char* end, int* ret) {
+    const char* q = lept_stream_token_end(p, *s, 1, s + 1, end);
+    if (q == NULL) {
+        p->token = token;
+        lept_stream_save(p, s, end - s);
+        *ret = LEPT_PARSE_OK;
+        return end;
+    }
+    p->c.json = s;
+    p->c.end = end;
+    *ret = lept_stream_token(p, token);
+    return p->c.json;
+}
+
+static int lept_stream_run(lept_stream_parser* p, const char* s, const char* end) {
+    int ret;
+    while (s < end) {
+        char ch = *s;
+        if (ISWHITESPACE(ch)) {
+            s++;
+            continue;
+        }
+        switch (p->state) {
+            case LEPT_STREAM_ARRAY_FIRST:
+                if (ch == ']') {
+                    s++;
+                    lept_stream_close(p);
+                    break;
+                }
+                /* fall through */
+            case LEPT_STREAM_VALUE:
+                if (ch == '[' || ch == '{') {
+                    s++;
+                    lept_stream_open(p, ch == '[' ? LEPT_ARRAY : LEPT_OBJECT);
+                } else if (ch == 'n' || ch == 't' || ch == 'f' || ch == '"' || ch == '-' || ISDIGIT(ch)) {
+                    s = lept_stream_start_token(p, LEPT_TOKEN_VALUE, s, end, &ret);
+                    if (ret != LEPT_PARSE_OK)
+                        return ret;
+                } else
+                    return LEPT_PARSE_INVALID_VALUE; // s < end, '\0' 也是输入中的字节
+                break;
+            case LEPT_STREAM_OBJECT_FIRST:
+                if (ch == '}') {
+                    s++;
+                    lept_stream_close(p);
+                    break;
+                }
+                /* fall through */
+            case LEPT_STREAM_KEY:
+                if (ch != '\"')
+                    return LEPT_PARSE_MISS_KEY;
+                s = lept_stream_start_token(p, LEPT_TOKEN_KEY, s, end, &ret);
+                if (ret != LEPT_PARSE_OK)
+                    return ret;
+                break;
+            case LEPT_STREAM_COLON:
+                if (ch != ':')
+                    return LEPT_PARSE_MISS_COLON;
+                s++;
+                p->state = LEPT_STREAM_VALUE;
+                break;
+            case LEPT_STREAM_AFTER_VALUE:
+                if (ch == ',' && p->frames[p->depth - 1].size == LEPT_MAX_CAPACITY)
+                    return LEPT_PARSE_TOO_LARGE;
+                if (p->frames[p->depth - 1].type == LEPT_ARRAY) {
+                    if (ch == ',')
+                        p->state = LEPT_STREAM_VALUE;
+                    else if (ch == ']')
+                        lept_stream_close(p);
+                    else
+                        return LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+                } else {
+                    if (ch == ',')
+                        p->state = LEPT_STREAM_KEY;
+                    else if (ch == '}')
+                        lept_stream_close(p);
+                    else
+                        return LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+                }
+                s++;
+                break;
+            default:
+                assert(p->state == LEPT_STREAM_DONE);
+                return LEPT_PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    return LEPT_PARSE_OK;
+}
+
+/* 出错后释放已经解析的部分, 以后的调用都返回同一个错误码 */
+static int lept_stream_fail(lept_stream_parser* p, int ret) {
+    lept_stream_release(p);
+    lept_free(p->v);
+    p->token = LEPT_TOKEN_NONE;
+    p->state = LEPT_STREAM_FINISHED;
+    return p->ret = ret;
+}
+
+int lept_stream_feed(lept_stream_parser* p, const char* buf, size_t len) {
+    const char* end = buf + len;
+    int ret;
+    assert(p != NULL && (buf != NULL || len == 0));
+    if (p->ret != LEPT_PARSE_OK)
+        return p->ret;
+    assert(p->state != LEPT_STREAM_FINISHED);
+    if (p->token != LEPT_TOKEN_NONE) {
+        /* 先补全上一块末尾被截断的 token */
+        const char* q = lept_stream_token_end(p, p->buf[0], p->len, buf, end);
+        if (q == NULL) {
+            lept_stream_save(p, buf, len);
+            return LEPT_PARSE_OK;
+        }
+        lept_stream_save(p, buf, q - buf);
+        if ((ret = lept_stream_flush(p)) != LEPT_PARSE_OK)
+            return lept_stream_fail(p, ret);
+        buf = q;
+    }
+    if ((ret = lept_stream_run(p, buf, end)) != LEPT_PARSE_OK)
+        return lept_stream_fail(p, ret);
+    return LEPT_PARSE_OK;
+}
+
+int lept_stream_finish(lept_stream_parser* p) {
+    int ret;
+    assert(p != NULL);
+    if (p->ret != LEPT_PARSE_OK)
+        return p->ret;
+    assert(p->state != LEPT_STREAM_FINISHED);
+    /* 输入结束, 相当于 lept_parse 遇到了 '\0' */
+    if (p->token != LEPT_TOKEN_NONE && (ret = lept_stream_flush(p)) != LEPT_PARSE_OK)
+        return lept_stream_fail(p, ret);
+    switch (p->state) {
+        case LEPT_STREAM_DONE:
+            p->state = LEPT_STREAM_FINISHED;
+            return LEPT_PARSE_OK;
+        case LEPT_STREAM_VALUE:
+        case LEPT_STREAM_ARRAY_FIRST: return lept_stream_fail(p, LEPT_PARSE_EXPECT_VALUE);
+        case LEPT_STREAM_OBJECT_FIRST:
+        case LEPT_STREAM_KEY: return lept_stream_fail(p, LEPT_PARSE_MISS_KEY);
+        case LEPT_STREAM_COLON: return lept_stream_fail(p, LEPT_PARSE_MISS_COLON);
+        default:
+            assert(p->state == LEPT_STREAM_AFTER_VALUE);
+            return lept_stream_fail(p, p->frames[p->depth - 1].type == LEPT_ARRAY ?
+                LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET);
+    }
+}
+
+void lept_free (lept_value* v) {
+    assert(v != NULL);
+    size_t i;
+    switch (v->type) {
+        case LEPT_STRING:
+            if (!(v->flags & (LEPT_FLAG_BORROWED | LEPT_FLAG_INLINE)))
+                free(v->s);
+            break;
+        case LEPT_ARRAY:
+            for (i = 0; i < v->size; i++) {
+                lept_free(&v->e[i]);
+            }
+            if (!(v->flags & LEPT_FLAG_BORROWED))
+                free(v->e);
+            break;
+        case LEPT_OBJECT:
+            for (i = 0; i < v->o.size; ++i) {
+                if (!(v->flags & LEPT_FLAG_KEYS_BORROWED) && !LEPT_KEY_IS_SHORT(&v->o.m[i]))
+                    free(v->o.m[i].k);
+                lept_free(&v->o.m[i].v);
+            }
+            if (!(v->flags & LEPT_FLAG_BORROWED))
+                free(v->o.m);
+        default:break;
+    }
+    v->type = LEPT_NULL;
+    v->flags = 0;
+}
+
+/* 修改借用的数组/对象之前, 先把元素复制到自己的堆内存中 */
+static void lept_own_elements(lept_value* v, size_t capacity) {
+    void* p;
+    if (v->type == LEPT_ARRAY) {
+        p = malloc(capacity * sizeof(lept_value));
+        if (v->size > 0)
+            memcpy(p, v->e, v->size * sizeof(lept_value));
+        v->e = (lept_value*)p;
+    } else {
+        assert(v->type == LEPT_OBJECT);
+        p = malloc(lept_object_bytes(capacity));
+        if (v->o.size > 0)
+            memcpy(p, v->o.m, v->o.size * sizeof(lept_member));
+        v->o.m = (lept_member*)p;
+    }
+    v->capacity = capacity;
+    v->flags &= ~(LEPT_FLAG_BORROWED | LEPT_FLAG_INDEXED);
+}
+
+static void lept_own_keys(lept_value* v) {
+    size_t i;
+    assert(v->type == LEPT_OBJECT);
+    for (i = 0; i < v->o.size; i++) {
+        char* k;
+        if (LEPT_KEY_IS_SHORT(&v->o.m[i]))
+            continue;
+        k = (char*)malloc(v->o.m[i].klen + 1);
+        memcpy(k, v->o.m[i].k, v->o.m[i].klen + 1);
+        v->o.m[i].k = k;
+    }
+    v->flags &= ~LEPT_FLAG_KEYS_BORROWED;
+}
+
+void lept_move(lept_value* dst, lept_value* src) {
+    assert(dst != NULL && src != NULL && src != dst);
+    lept_free(dst);
+    memcpy(dst, src, sizeof(lept_value));
+    lept_init(src);
+}
+
+
+void lept_swap(lept_value* lhs, lept_value* rhs) {
+    assert(lhs != NULL && rhs != NULL);
+    if (lhs != rhs) {
+        lept_value temp;
+        memcpy(&temp, lhs, sizeof(lept_value));
+        memcpy(lhs,   rhs, sizeof(lept_value));
+        memcpy(rhs, &temp, sizeof(lept_value));
+    }
 }
 
 
@@ -491,9 +3991,56 @@ void lept_set_boolean(lept_value* v, int b) {
 
 double lept_get_number(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_NUMBER);
+    if (v->flags & LEPT_FLAG_INT64)
+        return (double)v->i;
+    if (v->flags & LEPT_FLAG_UINT64)
+        return (double)v->u;
     return v->n;
 }
 
+int lept_is_integer(const lept_value* v) {
+    assert(v != NULL && v->type == LEPT_NUMBER);
+    return (v->flags & (LEPT_FLAG_INT64 | LEPT_FLAG_UINT64)) != 0;
+}
+
+int64_t lept_get_int64(const lept_value* v) {
+    assert(v != NULL && v->type == LEPT_NUMBER);
+    if (v->flags & LEPT_FLAG_INT64)
+        return v->i;
+    if (v->flags & LEPT_FLAG_UINT64) {
+        assert(v->u <= INT64_MAX);
+        return (int64_t)v->u;
+    }
+    assert(v->n >= -9223372036854775808.0 && v->n < 9223372036854775808.0);
+    return (int64_t)v->n;
+}
+
+void lept_set_int64(lept_value* v, int64_t i) {
+    lept_free(v);
+    v->i = i;
+    v->type = LEPT_NUMBER;
+    v->flags = LEPT_FLAG_INT64;
+}
+
+uint64_t lept_get_uint64(const lept_value* v) {
+    assert(v != NULL && v->type == LEPT_NUMBER);
+    if (v->flags & LEPT_FLAG_UINT64)
+        return v->u;
+    if (v->flags & LEPT_FLAG_INT64) {
+        assert(v->i >= 0);
+        return (uint64_t)v->i;
+    }
+    assert(v->n >= 0.0 && v->n < 18446744073709551616.0);
+    return (uint64_t)v->n;
+}
+
+void lept_set_uint64(lept_value* v, uint64_t u) {
+    lept_free(v);
+    v->u = u;
+    v->type = LEPT_NUMBER;
+    v->flags = LEPT_FLAG_UINT64;
+}
+
 void lept_set_number(lept_value* v, double n) {
     lept_free(v);
     v->n = n;
@@ -502,15 +4049,24 @@ void lept_set_number(lept_value* v, double n) {
 
 const char* lept_get_string(const lept_value *v) {
     assert(v != NULL && v->type == LEPT_STRING);
-    return v->s;
+    return LEPT_STRING(v);
 }
 size_t lept_get_string_length(const lept_value* v) {
     assert(v != NULL && v->type == LEPT_STRING);
-    return v->len;
+    return LEPT_STRING_LEN(v);
 }
 void lept_set_string(lept_value* v, const char* s, size_t len){
-    assert(v != NULL && (s != NULL || len == 0));
+    assert(v != NULL && (s != NULL || len == 0) && len <= LEPT_MAX_STRING_LENGTH);
     lept_free(v);
+    if (len <= LEPT_SHORT_STRING_MAX) {
+        if (len) // s 可能为 NULL, memcpy 不允许空指针
+            memcpy(v->ss, s, len);
+        v->ss[len] = '\0';
+        v->ss[LEPT_SHORT_STRING_MAX] = (char)(LEPT_SHORT_STRING_MAX - len);
+        v->type = LEPT_STRING;
+        v->flags = LEPT_FLAG_INLINE;
+        return;
+    }
     v->s = (char*)malloc(len + 1); // + 1 是为了在结尾添加一个结束字符\0
     memcpy(v->s, s, len);
     v->s[len] = '\0';
@@ -519,7 +4075,7 @@ void lept_set_string(lept_value* v, const char* s, size_t len){
 }
 
 void lept_set_array (lept_value* v, size_t capacity) {
-    assert(v != NULL);
+    assert(v != NULL && capacity <= LEPT_MAX_CAPACITY);
     lept_free(v);
     v->capacity = capacity;
     v->size = 0;
@@ -534,8 +4090,12 @@ size_t lept_get_array_capacity(const lept_value* v) {
 
 // 扩容
 void lept_reserve_array (lept_value* v, size_t capacity) {
-    assert(v != NULL && v->type == LEPT_ARRAY);
+    assert(v != NULL && v->type == LEPT_ARRAY && capacity <= LEPT_MAX_CAPACITY);
     if (v->capacity < capacity) {
+        if (v->flags & LEPT_FLAG_BORROWED) {
+            lept_own_elements(v, capacity);
+            return;
+        }
         v->capacity = capacity;
         v->e = (lept_value*)realloc(v->e, capacity * sizeof(lept_value));
     }
@@ -545,6 +4105,10 @@ void lept_reserve_array (lept_value* v, size_t capacity) {
 void lept_shrink_array (lept_value* v) {
     assert(v != NULL && v->type == LEPT_ARRAY);
     if (v->capacity > v->size) {
+        if (v->flags & LEPT_FLAG_BORROWED) {
+            lept_own_elements(v, v->size);
+            return;
+        }
         v->capacity = v->size;
         v->e = (lept_value*)realloc(v->e, v->capacity * sizeof(lept_value));
     }
@@ -554,7 +4118,7 @@ void lept_shrink_array (lept_value* v) {
 lept_value*  lept_pushback_array_element (lept_value* v) {
     assert(v != NULL && v->type == LEPT_ARRAY);
     if (v->size == v->capacity) {
-        lept_reserve_array(v, v->capacity == 0 ? 1 : v->capacity * 2);
+        lept_reserve_array(v, LEPT_GROW_CAPACITY(v->capacity));
     }
     lept_init(&v->e[v->size]); // 指向结尾元素
     return &v->e[v->size++];
@@ -631,17 +4195,300 @@ size_t lept_get_object_size(const lept_value* v) {
 const char* lept_get_object_key(const lept_value* v, size_t index) {
     assert(v != NULL && v->type == LEPT_OBJECT);
     assert(index < v->o.size);
-    return v->o.m[index].k;
+    return LEPT_KEY(&v->o.m[index]);
 }
 size_t lept_get_object_key_length(const lept_value* v, size_t index) {
     assert(v != NULL && v->type == LEPT_OBJECT);
     assert(index < v->o.size);
-    return v->o.m[index].klen;
+    return LEPT_KEY_LEN(&v->o.m[index]);
+}
+lept_value* lept_get_object_value(const lept_value* v, size_t index){
+    assert(v != NULL && v->type == LEPT_OBJECT);
+    assert(index < v->o.size);
+    return &(v->o.m[index].v);
+}
+
+/*
+ * double 转字符串: 用 Grisu2 生成能精确还原的数字, 格式和 "%.17g" 相同 (指数 < -4 或 >= 17 时用科学计数法)
+ * 0.1 输出 "0.1" 而不是 "0.10000000000000001"; 极少数情况下 (约万分之四) Grisu2 会比最短的表示多一位, 但仍能精确还原
+ */
+typedef struct {
+    uint64_t f;
+    int e;
+} lept_diyfp; // f * 2^e
+
+#define LEPT_DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define LEPT_DP_HIDDEN_BIT       0x0010000000000000ULL
+
+/* 10^k 的 64 位近似值, k 从 -348 到 340, 步长为 8 */
+static const uint64_t lept_cached_powers_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+static const short lept_cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const unsigned lept_pow10_32[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+static const uint64_t lept_pow10_64[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+    10000000000000000000ULL
+};
+
+static lept_diyfp lept_diyfp_make (uint64_t f, int e) {
+    lept_diyfp r;
+    r.f = f;
+    r.e = e;
+    return r;
+}
+
+static lept_diyfp lept_diyfp_mul (lept_diyfp x, lept_diyfp y) {
+    uint64_t hi, lo = lept_mul128(x.f, y.f, &hi);
+    if (lo & 0x8000000000000000ULL) // 舍入
+        hi++;
+    return lept_diyfp_make(hi, x.e + y.e + 64);
+}
+
+static lept_diyfp lept_diyfp_normalize (lept_diyfp x) {
+    int s = lept_clz64(x.f);
+    return lept_diyfp_make(x.f << s, x.e - s);
+}
+
+/* 求出 v 和相邻 double 的中点 m- 和 m+, 并规格化到相同的指数 */
+static void lept_grisu_boundaries (lept_diyfp v, lept_diyfp* minus, lept_diyfp* plus) {
+    lept_diyfp pl = lept_diyfp_normalize(lept_diyfp_make((v.f << 1) + 1, v.e - 1));
+    lept_diyfp mi = (v.f == LEPT_DP_HIDDEN_BIT) ? lept_diyfp_make((v.f << 2) - 1, v.e - 2) : lept_diyfp_make((v.f << 1) - 1, v.e - 1);
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    *plus = pl;
+    *minus = mi;
+}
+
+/* 选一个 10^-K, 使 e + 10^-K 的二进制指数落在 [-60, -32] */
+static lept_diyfp lept_grisu_cached_power (int e, int* K) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk, index;
+    if (dk - k > 0.0)
+        k++;
+    index = (k >> 3) + 1;
+    *K = -(-348 + index * 8);
+    return lept_diyfp_make(lept_cached_powers_f[index], lept_cached_powers_e[index]);
+}
+
+static void lept_grisu_round (char* buffer, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int lept_count_digits32 (unsigned n) {
+    int i;
+    for (i = 1; i < 10; i++)
+        if (n < lept_pow10_32[i])
+            return i;
+    return 10;
+}
+
+static void lept_grisu_digits (lept_diyfp w, lept_diyfp mp, uint64_t delta, char* buffer, int* len, int* K) {
+    lept_diyfp one = lept_diyfp_make(1ULL << -mp.e, mp.e);
+    uint64_t wp_w = mp.f - w.f;
+    unsigned p1 = (unsigned)(mp.f >> -one.e);
+    uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = lept_count_digits32(p1);
+    *len = 0;
+    while (kappa > 0) {
+        unsigned d = p1 / lept_pow10_32[kappa - 1];
+        uint64_t tmp;
+        p1 %= lept_pow10_32[kappa - 1];
+        if (d || *len)
+            buffer[(*len)++] = (char)('0' + d);
+        kappa--;
+        tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            lept_grisu_round(buffer, *len, delta, tmp, (uint64_t)lept_pow10_32[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+    for (;;) {
+        char d;
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> -one.e);
+        if (d || *len)
+            buffer[(*len)++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            lept_grisu_round(buffer, *len, delta, p2, one.f, -kappa < 20 ? wp_w * lept_pow10_64[-kappa] : 0);
+            return;
+        }
+    }
+}
+
+/* d > 0, 有效数字写入 buffer, 值为 buffer * 10^K */
+static void lept_grisu2 (double d, char* buffer, int* len, int* K) {
+    uint64_t bits;
+    lept_diyfp v, w_m, w_p, c_mk, W, Wp, Wm;
+    int biased_e;
+    memcpy(&bits, &d, sizeof(d));
+    biased_e = (int)((bits >> 52) & 0x7FF);
+    if (biased_e != 0)
+        v = lept_diyfp_make((bits & LEPT_DP_SIGNIFICAND_MASK) + LEPT_DP_HIDDEN_BIT, biased_e - 1075);
+    else
+        v = lept_diyfp_make(bits & LEPT_DP_SIGNIFICAND_MASK, -1074);
+    lept_grisu_boundaries(v, &w_m, &w_p);
+    c_mk = lept_grisu_cached_power(w_p.e, K);
+    W = lept_diyfp_mul(lept_diyfp_normalize(v), c_mk);
+    Wp = lept_diyfp_mul(w_p, c_mk);
+    Wm = lept_diyfp_mul(w_m, c_mk);
+    Wm.f++;
+    Wp.f--;
+    lept_grisu_digits(W, Wp, Wp.f - Wm.f, buffer, len, K);
+}
+
+static const char lept_digits_lut[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* 无符号整数转十进制, 返回写入后的位置 */
+static char* lept_u64toa (uint64_t u, char* p) {
+    char buf[20], *q = buf + sizeof(buf);
+    size_t n;
+    while (u >= 100) {
+        unsigned i = (unsigned)(u % 100) * 2;
+        u /= 100;
+        *--q = lept_digits_lut[i + 1];
+        *--q = lept_digits_lut[i];
+    }
+    if (u >= 10) {
+        *--q = lept_digits_lut[u * 2 + 1];
+        *--q = lept_digits_lut[u * 2];
+    } else {
+        *--q = (char)('0' + u);
+    }
+    n = buf + sizeof(buf) - q;
+    memcpy(p, q, n);
+    return p + n;
+}
+
+/* 写入 buffer (至少 25 字节), 返回长度, 不写入 '\0' */
+static int lept_dtoa (double d, char* buffer) {
+    char digits[20], *p = buffer;
+    int len, K, kk, i;
+    uint64_t bits;
+    if (!(d - d == 0.0)) // inf, nan
+        return sprintf(buffer, "%.17g", d);
+    memcpy(&bits, &d, sizeof(d));
+    if (bits >> 63) {
+        *p++ = '-';
+        d = -d;
+    }
+    /* 小于 2^53 的整数直接按整数输出 */
+    if (d < 9007199254740992.0 && d == (double)(uint64_t)d)
+        return (int)(lept_u64toa((uint64_t)d, p) - buffer);
+
+    lept_grisu2(d, digits, &len, &K);
+    while (len > 1 && digits[len - 1] == '0') {
+        len--;
+        K++;
+    }
+    kk = len + K - 1; // 第一位数字的十进制指数
+    if (kk >= -4 && kk < 17) {
+        if (K >= 0) { // 整数
+            memcpy(p, digits, len);
+            p += len;
+            for (i = 0; i < K; i++)
+                *p++ = '0';
+        } else if (kk >= 0) { // 1234.5
+            memcpy(p, digits, kk + 1);
+            p += kk + 1;
+            *p++ = '.';
+            memcpy(p, digits + kk + 1, len - kk - 1);
+            p += len - kk - 1;
+        } else { // 0.00123
+            *p++ = '0';
+            *p++ = '.';
+            for (i = -1; i > kk; i--)
+                *p++ = '0';
+            memcpy(p, digits, len);
+            p += len;
+        }
+    } else { // 1.2345e+20, 和 printf 一样指数至少两位
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, len - 1);
+            p += len - 1;
+        }
+        *p++ = 'e';
+        if (kk < 0) {
+            *p++ = '-';
+            kk = -kk;
+        } else {
+            *p++ = '+';
+        }
+        if (kk < 10)
+            *p++ = '0';
+        p = lept_u64toa((uint64_t)kk, p);
+    }
+    return (int)(p - buffer);
 }
-lept_value* lept_get_object_value(const lept_value* v, size_t index){
-    assert(v != NULL && v->type == LEPT_OBJECT);
-    assert(index < v->o.size);
-    return &(v->o.m[index].v);
+
+static int lept_number_to_string (const lept_value* v, char* buffer) {
+    char* p = buffer;
+    if (v->flags & LEPT_FLAG_INT64) {
+        uint64_t u = (uint64_t)v->i;
+        if (v->i < 0) {
+            *p++ = '-';
+            u = ~u + 1; // 对 INT64_MIN 也成立
+        }
+        return (int)(lept_u64toa(u, p) - buffer);
+    }
+    if (v->flags & LEPT_FLAG_UINT64)
+        return (int)(lept_u64toa(v->u, p) - buffer);
+    return lept_dtoa(v->n, buffer);
 }
 
 #if 0
@@ -673,51 +4520,66 @@ static void stringify_string (lept_context* c, const char* s, size_t len) {
     PUTC(c, '"');
 }
 #else
+/* 缓冲区中的内容交给 write, 出错之后的输出都丢弃 */
+static void lept_stringify_flush (lept_context* c) {
+    if (c->write_ret == 0 && c->top > 0)
+        c->write_ret = c->write(c->write_ctx, c->stack, c->top);
+    c->top = 0;
+}
+
+/* 每次写入之前检查, 两次检查之间最多写入 6 * LEPT_STRINGIFY_STRING_CHUNK 字节, 缓冲区大小是固定的 */
+#define LEPT_STRINGIFY_CHECK(c) do { if ((c)->write != NULL && (c)->top >= LEPT_WRITE_BUFFER_SIZE) lept_stringify_flush(c); } while(0)
+#define LEPT_STRINGIFY_STRING_CHUNK (LEPT_WRITE_BUFFER_SIZE / 8)
+
 static void lept_stringify_string (lept_context* c, const char* s, size_t len) {
     static const char hex_digits[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
-    size_t i, size;
+    size_t i, n, size;
     char* head, *p;
     assert(s != NULL);
 
-    p = head = lept_context_push(c, size = len * 6 + 2);
-    *p++ = '"';
-    for (i = 0; i < len; i++) {
-        unsigned char ch = (unsigned char)s[i];
-        switch (ch) { // 将字符转义
-            case '\"': *p++ = '\\'; *p++ = '\"'; break;
-            case '\\': *p++ = '\\'; *p++ = '\\'; break;
-            case '\b': *p++ = '\\'; *p++ = 'b';  break;
-            case '\f': *p++ = '\\'; *p++ = 'f';  break;
-            case '\n': *p++ = '\\'; *p++ = 'n';  break;
-            case '\r': *p++ = '\\'; *p++ = 'r';  break;
-            case '\t': *p++ = '\\'; *p++ = 't';  break;
-            default:
-                if (ch < 0x20 ) {
-                    *p++ = '\\'; *p++ = 'u'; *p++ = '0'; *p++ = '0';
-                    *p++ = hex_digits[ch >> 4];
-                    *p++ = hex_digits[ch & 15];
-                } else {
-                    *p++ = s[i];
-                }
+    PUTC(c, '"');
+    for (; len > 0; s += n, len -= n) { // 长字符串分段转义
+        n = len < LEPT_STRINGIFY_STRING_CHUNK ? len : LEPT_STRINGIFY_STRING_CHUNK;
+        LEPT_STRINGIFY_CHECK(c);
+        p = head = lept_context_push(c, size = n * 6);
+        for (i = 0; i < n; i++) {
+            unsigned char ch = (unsigned char)s[i];
+            switch (ch) { // 将字符转义
+                case '\"': *p++ = '\\'; *p++ = '\"'; break;
+                case '\\': *p++ = '\\'; *p++ = '\\'; break;
+                case '\b': *p++ = '\\'; *p++ = 'b';  break;
+                case '\f': *p++ = '\\'; *p++ = 'f';  break;
+                case '\n': *p++ = '\\'; *p++ = 'n';  break;
+                case '\r': *p++ = '\\'; *p++ = 'r';  break;
+                case '\t': *p++ = '\\'; *p++ = 't';  break;
+                default:
+                    if (ch < 0x20 ) {
+                        *p++ = '\\'; *p++ = 'u'; *p++ = '0'; *p++ = '0';
+                        *p++ = hex_digits[ch >> 4];
+                        *p++ = hex_digits[ch & 15];
+                    } else {
+                        *p++ = s[i];
+                    }
+            }
         }
+        c->top -= size - (p - head);
     }
-
-    *p++ = '"';
-    c->top -= size - (p - head);
+    PUTC(c, '"');
 }
 #endif
 
 static void lept_stringify_value (lept_context* c, lept_value* v) {
     size_t i;
+    LEPT_STRINGIFY_CHECK(c);
     switch (v->type) {
         case LEPT_NULL: PUTS(c, "null", 4); break;
         case LEPT_FALSE: PUTS(c, "false", 5); break;
         case LEPT_TRUE: PUTS(c, "true", 4); break;
-        case LEPT_NUMBER: c->top -= 32 - sprintf(lept_context_push(c, 32), "%.17g",v->n); break;
-        case LEPT_STRING : lept_stringify_string(c, v->s, v->len); break;
+        case LEPT_NUMBER: c->top -= 32 - lept_number_to_string(v, lept_context_push(c, 32)); break;
+        case LEPT_STRING : lept_stringify_string(c, LEPT_STRING(v), LEPT_STRING_LEN(v)); break;
         case LEPT_ARRAY:
             PUTC(c, '[');
-            for (i = 0; i < v->size; i++) {
+            for (i = 0; i < v->size && c->write_ret == 0; i++) {
                 if (i > 0) PUTC(c, ',');
                 lept_stringify_value(c, &v->e[i]);
             }
@@ -725,9 +4587,9 @@ static void lept_stringify_value (lept_context* c, lept_value* v) {
             break;
         case LEPT_OBJECT:
             PUTC(c, '{');
-            for (i = 0; i < v->o.size; i++) {
+            for (i = 0; i < v->o.size && c->write_ret == 0; i++) {
                 if (i > 0) PUTC(c, ',');
-                lept_stringify_string(c, v->o.m[i].k, v->o.m[i].klen);
+                lept_stringify_string(c, LEPT_KEY(&v->o.m[i]), LEPT_KEY_LEN(&v->o.m[i]));
                 PUTC(c, ':');
                 lept_stringify_value(c, &v->o.m[i].v);
             }
@@ -742,33 +4604,388 @@ char* lept_stringify (lept_value* v, size_t* len) {
     assert(v != NULL);
     c.stack = (char*)malloc(c.size = LEPT_PARSE_STACK_INIT_SIZE);
     c.top = 0;
+    c.write = NULL;
+    c.write_ret = 0;
     lept_stringify_value(&c, v);
     if (len) *len = c.top;
     PUTC(&c, '\0');
     return c.stack;
 }
 
+int lept_stringify_to (lept_value* v, lept_write_fn write, void* ctx) {
+    lept_context c;
+    assert(v != NULL && write != NULL);
+    /* 检查时不超过 LEPT_WRITE_BUFFER_SIZE, 之后最多再写入 6 * LEPT_STRINGIFY_STRING_CHUNK, 不需要扩容 */
+    c.stack = (char*)malloc(c.size = 2 * LEPT_WRITE_BUFFER_SIZE);
+    c.top = 0;
+    c.write = write;
+    c.write_ctx = ctx;
+    c.write_ret = 0;
+    lept_stringify_value(&c, v);
+    lept_stringify_flush(&c);
+    free(c.stack);
+    return c.write_ret;
+}
+
+static int lept_write_file (void* ctx, const char* data, size_t len) {
+    return fwrite(data, 1, len, (FILE*)ctx) == len ? 0 : LEPT_FILE_IO_ERROR;
+}
 
-size_t lept_find_object_index (lept_value* v, const char* key, size_t klen) {
+int lept_stringify_file (lept_value* v, FILE* fp) {
+    assert(fp != NULL);
+    return lept_stringify_to(v, lept_write_file, fp);
+}
+
+static int lept_write_fd (void* ctx, const char* data, size_t len) {
+#if defined(LEPT_POSIX)
+    int fd = *(int*)ctx;
+    while (len > 0) { // write 可能只写入一部分
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return LEPT_FILE_IO_ERROR;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+#else
+    (void)ctx;
+    (void)data;
+    (void)len;
+    errno = ENOSYS;
+    return LEPT_FILE_IO_ERROR;
+#endif
+}
+
+int lept_stringify_fd (lept_value* v, int fd) {
+    return lept_stringify_to(v, lept_write_fd, &fd);
+}
+
+/*
+ * CBOR (RFC 8949): 每个数据项第一个字节的高 3 位是主类型, 低 5 位小于 24 时就是参数,
+ * 24~27 表示参数在后面的 1/2/4/8 个字节中 (大端). 整数用主类型 0/1, 其它数字是 8 字节的 double,
+ * 字符串和 key 是长度加内容, 数组/对象记录元素/成员的个数.
+ */
+#define LEPT_CBOR_UINT   0x00
+#define LEPT_CBOR_NEGINT 0x20
+#define LEPT_CBOR_BYTES  0x40
+#define LEPT_CBOR_TEXT   0x60
+#define LEPT_CBOR_ARRAY  0x80
+#define LEPT_CBOR_MAP    0xA0
+#define LEPT_CBOR_TAG    0xC0
+#define LEPT_CBOR_SIMPLE 0xE0
+
+/* 参数用最短的编码 */
+static void lept_cbor_head(lept_context* c, unsigned major, uint64_t n) {
+    unsigned char* p = (unsigned char*)lept_context_push(c, 9);
+    size_t len, i;
+    if (n < 24) {
+        p[0] = (unsigned char)(major | n);
+        c->top -= 8;
+        return;
+    }
+    if (n <= 0xFF)             { p[0] = (unsigned char)(major | 24); len = 1; }
+    else if (n <= 0xFFFF)      { p[0] = (unsigned char)(major | 25); len = 2; }
+    else if (n <= 0xFFFFFFFF)  { p[0] = (unsigned char)(major | 26); len = 4; }
+    else                       { p[0] = (unsigned char)(major | 27); len = 8; }
+    for (i = len; i > 0; i--, n >>= 8)
+        p[i] = (unsigned char)n;
+    c->top -= 8 - len;
+}
+
+static void lept_cbor_string(lept_context* c, const char* s, size_t len) {
+    lept_cbor_head(c, LEPT_CBOR_TEXT, len);
+    if (len > 0)
+        PUTS(c, s, len);
+}
+
+static void lept_encode_cbor_value(lept_context* c, const lept_value* v) {
     size_t i;
-    assert(v != NULL && v->type == LEPT_OBJECT && key != NULL);
-//    for  (i = 0;  i< v->o.size; i++) {
-//        printf("%d -- %s\n",i, v->o.m[i].k);
-//    }
+    switch (v->type) {
+        case LEPT_NULL:  PUTC(c, (char)0xF6); break;
+        case LEPT_FALSE: PUTC(c, (char)0xF4); break;
+        case LEPT_TRUE:  PUTC(c, (char)0xF5); break;
+        case LEPT_NUMBER:
+            if (v->flags & LEPT_FLAG_INT64) {
+                if (v->i >= 0)
+                    lept_cbor_head(c, LEPT_CBOR_UINT, (uint64_t)v->i);
+                else
+                    lept_cbor_head(c, LEPT_CBOR_NEGINT, (uint64_t)(-1 - v->i));
+            } else if (v->flags & LEPT_FLAG_UINT64)
+                lept_cbor_head(c, LEPT_CBOR_UINT, v->u);
+            else {
+                /* 双精度浮点数 0xFB, 后面是 8 字节的大端 IEEE 754 */
+                unsigned char* p = (unsigned char*)lept_context_push(c, 9);
+                uint64_t bits;
+                memcpy(&bits, &v->n, sizeof(bits));
+                p[0] = 0xFB;
+                for (i = 8; i > 0; i--, bits >>= 8)
+                    p[i] = (unsigned char)bits;
+            }
+            break;
+        case LEPT_STRING:
+            lept_cbor_string(c, LEPT_STRING(v), LEPT_STRING_LEN(v));
+            break;
+        case LEPT_ARRAY:
+            lept_cbor_head(c, LEPT_CBOR_ARRAY, v->size);
+            for (i = 0; i < v->size; i++)
+                lept_encode_cbor_value(c, &v->e[i]);
+            break;
+        case LEPT_OBJECT:
+            lept_cbor_head(c, LEPT_CBOR_MAP, v->o.size);
+            for (i = 0; i < v->o.size; i++) {
+                lept_cbor_string(c, LEPT_KEY(&v->o.m[i]), LEPT_KEY_LEN(&v->o.m[i]));
+                lept_encode_cbor_value(c, &v->o.m[i].v);
+            }
+            break;
+        default: assert(0 && "invalid type");
+    }
+}
+
+char* lept_encode_cbor(lept_value* v, size_t* length) {
+    lept_context c;
+    assert(v != NULL && length != NULL);
+    c.stack = (char*)malloc(c.size = LEPT_PARSE_STACK_INIT_SIZE);
+    c.top = 0;
+    lept_encode_cbor_value(&c, v);
+    *length = c.top;
+    return c.stack;
+}
+
+/* 读取数据项的头, 返回第一个字节, 参数写入 *n; 数据不完整或者是不定长 (31) 和保留的参数时返回 -1 */
+static int lept_cbor_read_head(lept_context* c, uint64_t* n) {
+    const unsigned char* p = (const unsigned char*)c->json;
+    size_t len, i;
+    if (c->json == c->end)
+        return -1;
+    if ((p[0] & 0x1F) < 24) {
+        *n = p[0] & 0x1F;
+        c->json++;
+        return p[0];
+    }
+    if ((p[0] & 0x1F) > 27)
+        return -1;
+    len = (size_t)1 << ((p[0] & 0x1F) - 24);
+    if ((size_t)(c->end - c->json) <= len)
+        return -1;
+    for (*n = 0, i = 1; i <= len; i++)
+        *n = *n << 8 | p[i];
+    c->json += len + 1;
+    return p[0];
+}
+
+/* 半精度浮点数 */
+static double lept_cbor_half(unsigned h) {
+    unsigned e = (h >> 10) & 0x1F, m = h & 0x3FF;
+    double d;
+    if (e == 0)
+        d = ldexp(m, -24);
+    else if (e != 31)
+        d = ldexp(m + 1024, (int)e - 25);
+    else
+        d = m == 0 ? HUGE_VAL : HUGE_VAL - HUGE_VAL;
+    return h & 0x8000 ? -d : d;
+}
+
+static int lept_decode_cbor_value(lept_context* c, lept_value* v);
+
+static int lept_decode_cbor_array(lept_context* c, lept_value* v, uint64_t n) {
+    size_t i;
+    int ret;
+    /* 每个元素至少 1 个字节, 先检查个数再分配 */
+    if (n > (uint64_t)(c->end - c->json) || n > LEPT_MAX_CAPACITY)
+        return LEPT_PARSE_INVALID_VALUE;
+    v->type = LEPT_ARRAY;
+    v->size = 0;
+    v->capacity = (size_t)n;
+    v->e = n > 0 ? (lept_value*)malloc((size_t)n * sizeof(lept_value)) : NULL;
+    for (i = 0; i < (size_t)n; i++) {
+        lept_init(&v->e[i]);
+        v->size = i + 1;
+        if ((ret = lept_decode_cbor_value(c, &v->e[i])) != LEPT_PARSE_OK) {
+            lept_free(v);
+            return ret;
+        }
+    }
+    return LEPT_PARSE_OK;
+}
+
+static int lept_decode_cbor_object(lept_context* c, lept_value* v, uint64_t n) {
+    size_t i;
+    uint64_t klen;
+    int ret;
+    /* 每个成员至少 2 个字节 */
+    if (n > (uint64_t)(c->end - c->json) / 2 || n > LEPT_MAX_CAPACITY)
+        return LEPT_PARSE_INVALID_VALUE;
+    v->type = LEPT_OBJECT;
+    v->o.size = (size_t)n;
+    v->o.capacity = (size_t)n;
+    /* 个数已知, 大对象一次分配成员数组和索引 */
+    v->o.m = n > 0 ? (lept_member*)malloc(lept_object_bytes((size_t)n)) : NULL;
+    v->o.size = 0;
+    for (i = 0; i < (size_t)n; i++) {
+        lept_member* m = &v->o.m[i];
+        if ((ret = lept_cbor_read_head(c, &klen)) < 0 || (ret & 0xE0) != LEPT_CBOR_TEXT) {
+            ret = ret < 0 ? LEPT_PARSE_INVALID_VALUE : LEPT_PARSE_MISS_KEY;
+            lept_free(v);
+            return ret;
+        }
+        if (klen > (uint64_t)(c->end - c->json) || klen > LEPT_MAX_STRING_LENGTH) {
+            lept_free(v);
+            return LEPT_PARSE_INVALID_VALUE;
+        }
+        if (klen <= LEPT_SHORT_KEY_MAX)
+            lept_set_short_key(m, c->json, (size_t)klen);
+        else {
+            m->klen = (size_t)klen;
+            m->k = (char*)malloc(m->klen + 1);
+            memcpy(m->k, c->json, m->klen);
+            m->k[m->klen] = '\0';
+        }
+        c->json += klen;
+        lept_init(&m->v);
+        v->o.size = i + 1;
+        if ((ret = lept_decode_cbor_value(c, &m->v)) != LEPT_PARSE_OK) {
+            lept_free(v);
+            return ret;
+        }
+    }
+    if (LEPT_OBJECT_INDEXABLE(v))
+        lept_object_index_fill(v);
+    return LEPT_PARSE_OK;
+}
+
+static int lept_decode_cbor_value(lept_context* c, lept_value* v) {
+    uint64_t n;
+    float f;
+    uint32_t bits;
+    int head = lept_cbor_read_head(c, &n);
+    if (head < 0)
+        return LEPT_PARSE_INVALID_VALUE;
+    switch (head & 0xE0) {
+        case LEPT_CBOR_UINT:
+            if (n <= INT64_MAX) {
+                v->i = (int64_t)n;
+                v->flags = LEPT_FLAG_INT64;
+            } else {
+                v->u = n;
+                v->flags = LEPT_FLAG_UINT64;
+            }
+            v->type = LEPT_NUMBER;
+            return LEPT_PARSE_OK;
+        case LEPT_CBOR_NEGINT:
+            if (n <= INT64_MAX) {
+                v->i = -1 - (int64_t)n;
+                v->flags = LEPT_FLAG_INT64;
+            } else
+                v->n = -1.0 - (double)n;
+            v->type = LEPT_NUMBER;
+            return LEPT_PARSE_OK;
+        case LEPT_CBOR_TEXT:
+            if (n > (uint64_t)(c->end - c->json) || n > LEPT_MAX_STRING_LENGTH)
+                return LEPT_PARSE_INVALID_VALUE;
+            lept_set_string(v, c->json, (size_t)n);
+            c->json += n;
+            return LEPT_PARSE_OK;
+        case LEPT_CBOR_ARRAY:
+            return lept_decode_cbor_array(c, v, n);
+        case LEPT_CBOR_MAP:
+            return lept_decode_cbor_object(c, v, n);
+        case LEPT_CBOR_SIMPLE:
+            switch (head) {
+                case 0xF4: v->type = LEPT_FALSE; return LEPT_PARSE_OK;
+                case 0xF5: v->type = LEPT_TRUE; return LEPT_PARSE_OK;
+                case 0xF6: v->type = LEPT_NULL; return LEPT_PARSE_OK;
+                case 0xF9: v->n = lept_cbor_half((unsigned)n); break;
+                case 0xFA:
+                    bits = (uint32_t)n;
+                    memcpy(&f, &bits, sizeof(f));
+                    v->n = f;
+                    break;
+                case 0xFB: memcpy(&v->n, &n, sizeof(v->n)); break;
+                default: return LEPT_PARSE_INVALID_VALUE; // undefined 和其它简单值
+            }
+            /* JSON 中没有 Infinity 和 NaN */
+            if (v->n != v->n)
+                return LEPT_PARSE_INVALID_VALUE;
+            if (v->n == HUGE_VAL || v->n == -HUGE_VAL)
+                return LEPT_PARSE_NUMBER_TOO_BIG;
+            v->type = LEPT_NUMBER;
+            return LEPT_PARSE_OK;
+        default: // 字节串和 tag
+            return LEPT_PARSE_INVALID_VALUE;
+    }
+}
+
+int lept_decode_cbor(lept_value* v, const char* data, size_t len) {
+    lept_context c;
+    int ret;
+    assert(v != NULL && (data != NULL || len == 0));
+    lept_init(v);
+    if (len == 0)
+        return LEPT_PARSE_EXPECT_VALUE;
+    c.json = data;
+    c.end = data + len;
+    if ((ret = lept_decode_cbor_value(&c, v)) == LEPT_PARSE_OK && c.json != c.end) {
+        lept_free(v);
+        ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    return ret;
+}
+
+
+/* 不建立索引, 已有索引时使用 */
+static size_t lept_find_object_index_const (const lept_value* v, const char* key, size_t klen) {
+    size_t i;
+    if (v->flags & LEPT_FLAG_INDEXED) {
+        uint32_t* slot = lept_object_index_probe(v, key, klen);
+        return *slot != 0 ? *slot - 1 : LEPT_KEY_NOT_EXIST;
+    }
     for (i = 0;  i< v->o.size; i++) {
-        lept_member m = v->o.m[i];
-        if ((v->o.m[i].klen == klen) && (memcmp(v->o.m[i].k, key, klen) == 0)) {
+        if (LEPT_KEY_EQUAL(&v->o.m[i], key, klen)) {
             return i;
         }
     }
     return LEPT_KEY_NOT_EXIST;
 }
 
+size_t lept_find_object_index (lept_value* v, const char* key, size_t klen) {
+    assert(v != NULL && v->type == LEPT_OBJECT && key != NULL);
+    if (!(v->flags & LEPT_FLAG_INDEXED) && LEPT_OBJECT_INDEXABLE(v))
+        lept_object_index_fill(v); // 槽已经分配好了, 不会移动成员数组
+    return lept_find_object_index_const(v, key, klen);
+}
+
 lept_value* lept_find_object_value (lept_value* v, const char* key, size_t klen) {
     size_t index = lept_find_object_index(v, key, klen);
     return index != LEPT_KEY_NOT_EXIST ? &v->o.m[index].v : NULL;
 }
 
+/* 比较整数和 double 时不能把整数转换成 double, 否则 2^53 + 1 会和 2^53 相等 */
+static int lept_integer_equal_double (const lept_value* iv, double d) {
+    if (iv->flags & LEPT_FLAG_INT64)
+        return d >= -9223372036854775808.0 && d < 9223372036854775808.0 && (int64_t)d == iv->i && (double)(int64_t)d == d;
+    return d >= 0.0 && d < 18446744073709551616.0 && (uint64_t)d == iv->u && (double)(uint64_t)d == d;
+}
+
+static int lept_number_equal (const lept_value* lhs, const lept_value* rhs) {
+    int li = lept_is_integer(lhs), ri = lept_is_integer(rhs);
+    if (!li && !ri)
+        return lhs->n == rhs->n;
+    if (li && ri) {
+        if ((lhs->flags & LEPT_FLAG_INT64) && (rhs->flags & LEPT_FLAG_INT64))
+            return lhs->i == rhs->i;
+        if ((lhs->flags & LEPT_FLAG_UINT64) && (rhs->flags & LEPT_FLAG_UINT64))
+            return lhs->u == rhs->u;
+        if (lhs->flags & LEPT_FLAG_INT64)
+            return lhs->i >= 0 && (uint64_t)lhs->i == rhs->u;
+        return rhs->i >= 0 && (uint64_t)rhs->i == lhs->u;
+    }
+    return li ? lept_integer_equal_double(lhs, rhs->n) : lept_integer_equal_double(rhs, lhs->n);
+}
+
 int lept_is_equal (const lept_value* lhs, const lept_value* rhs) {
     size_t i;
     assert(lhs != NULL && rhs != NULL);
@@ -780,9 +4997,9 @@ int lept_is_equal (const lept_value* lhs, const lept_value* rhs) {
         case LEPT_TRUE:
             return lhs->type == rhs->type;
         case LEPT_NUMBER:
-            return lhs->n == rhs->n;
+            return lept_number_equal(lhs, rhs);
         case LEPT_STRING:
-            return memcmp(lhs->s, rhs->s, lhs->len) == 0 && lhs->len == rhs->len;
+            return LEPT_STRING_LEN(lhs) == LEPT_STRING_LEN(rhs) && memcmp(LEPT_STRING(lhs), LEPT_STRING(rhs), LEPT_STRING_LEN(lhs)) == 0;
         case LEPT_ARRAY:
             if (lhs->size != rhs->size) return 0;
             for (i = 0; i < lhs->size; ++i) {
@@ -792,9 +5009,8 @@ int lept_is_equal (const lept_value* lhs, const lept_value* rhs) {
         case LEPT_OBJECT:
             if (lhs->o.size != rhs->o.size) return 0;
             for (i = 0; i < lhs->o.size; ++i) {
-                size_t rindex = lept_find_object_index(rhs,  lhs->o.m[i].k, lhs->o.m[i].klen);
-                // compare key
-                if (lhs->o.m[i].k != rhs->o.m[rindex].k && lhs->o.m[i].klen != rhs->o.m[rindex].klen) return 0;
+                size_t rindex = lept_find_object_index_const(rhs, LEPT_KEY(&lhs->o.m[i]), LEPT_KEY_LEN(&lhs->o.m[i]));
+                if (rindex == LEPT_KEY_NOT_EXIST) return 0;
                 // compare value
                 if (!lept_is_equal(&lhs->o.m[i].v, &rhs->o.m[rindex].v)) return 0;
             }
@@ -809,7 +5025,7 @@ void lept_copy (lept_value* dst, const lept_value* src) {
     assert(dst != NULL && src != NULL && dst != src);
     switch (src->type) {
         case LEPT_STRING:
-            lept_set_string(dst, src->s, src->len);
+            lept_set_string(dst, LEPT_STRING(src), LEPT_STRING_LEN(src));
             break;
         case LEPT_ARRAY:
             lept_set_array(dst, src->capacity); // 初始化dst
@@ -820,9 +5036,11 @@ void lept_copy (lept_value* dst, const lept_value* src) {
         case LEPT_OBJECT:
             lept_set_object(dst, src->o.capacity); // init
             for (i = 0; i < src->o.size; ++i) {
-                // lept_set_object_value(dst, src->o.m[i].k, src->o.m[i].klen); 返回key 对应的value 地址
-                lept_copy(lept_set_object_value(dst, src->o.m[i].k, src->o.m[i].klen), &src->o.m[i].v);
+                // 原样复制所有成员 (包括重复的 key), 返回key 对应的value 地址
+                lept_copy(lept_append_object_member(dst, LEPT_KEY(&src->o.m[i]), LEPT_KEY_LEN(&src->o.m[i])), &src->o.m[i].v);
             }
+            if (src->flags & LEPT_FLAG_INDEXED)
+                lept_object_index_fill(dst);
             break;
         default:
             lept_free(dst);
@@ -832,12 +5050,12 @@ void lept_copy (lept_value* dst, const lept_value* src) {
 }
 
 void lept_set_object(lept_value* v, size_t capacity) {
-    assert(v != NULL);
+    assert(v != NULL && capacity <= LEPT_MAX_CAPACITY);
     lept_free(v);
     v->type = LEPT_OBJECT;
     v->o.size = 0;
     v->o.capacity = capacity;
-    v->o.m = capacity > 0 ? (lept_member*)malloc(capacity * sizeof(lept_member)) : NULL;
+    v->o.m = capacity > 0 ? (lept_member*)malloc(lept_object_bytes(capacity)) : NULL;
 }
 
 size_t lept_get_object_capacity(const lept_value* v) {
@@ -847,10 +5065,15 @@ size_t lept_get_object_capacity(const lept_value* v) {
 
 // 扩容
 void lept_reserve_object(lept_value* v, size_t capacity) {
-    assert(v != NULL && v->type == LEPT_OBJECT);
+    assert(v != NULL && v->type == LEPT_OBJECT && capacity <= LEPT_MAX_CAPACITY);
     if (v->o.capacity < capacity) {
+        if (v->flags & LEPT_FLAG_BORROWED) {
+            lept_own_elements(v, capacity);
+            return;
+        }
+        v->flags &= ~LEPT_FLAG_INDEXED; // 索引的位置和大小都依赖 capacity
         v->o.capacity = capacity;
-        v->o.m = (lept_member*)realloc(v->o.m, v->o.capacity * sizeof(lept_member));
+        v->o.m = (lept_member*)realloc(v->o.m, lept_object_bytes(v->o.capacity));
     }
 }
 
@@ -858,8 +5081,13 @@ void lept_reserve_object(lept_value* v, size_t capacity) {
 void lept_shrink_object(lept_value* v) {
     assert(v != NULL && v->type == LEPT_OBJECT);
     if (v->o.capacity > v->o.size ) {
+        if (v->flags & LEPT_FLAG_BORROWED) {
+            lept_own_elements(v, v->o.size);
+            return;
+        }
+        v->flags &= ~LEPT_FLAG_INDEXED;
         v->o.capacity = v->o.size ;
-        v->o.m = (lept_member*)realloc(v->o.m, v->o.size * sizeof(lept_member));
+        v->o.m = (lept_member*)realloc(v->o.m, lept_object_bytes(v->o.size));
     }
 }
 
@@ -867,42 +5095,405 @@ void lept_clear_object(lept_value* v) {
     assert(v != NULL && v->type == LEPT_OBJECT);
     size_t i;
     for (i = 0; i < v->o.size; ++i) {
-        free(v->o.m[i].k);
+        if (!(v->flags & LEPT_FLAG_KEYS_BORROWED) && !LEPT_KEY_IS_SHORT(&v->o.m[i]))
+            free(v->o.m[i].k);
         lept_free(&v->o.m[i].v);
     }
     v->o.size = 0;
+    v->flags &= ~(LEPT_FLAG_KEYS_BORROWED | LEPT_FLAG_INDEXED); // 已经没有借用的 key 了
 }
 
 
 
-lept_value* lept_set_object_value(lept_value* v, const char* key, size_t klen) {
-    assert(v != NULL && v->type == LEPT_OBJECT && key != NULL);
+/* 追加一个成员, 不检查 key 是否已经存在 */
+static lept_value* lept_append_object_member(lept_value* v, const char* key, size_t klen) {
+    if (v->flags & LEPT_FLAG_KEYS_BORROWED)
+        lept_own_keys(v); // 新 key 在堆上分配, 所有 key 的所有权要一致
     if (v->o.size == v->o.capacity) {
-        lept_reserve_object(v,  v->o.capacity == 0 ? 1 : v->o.capacity * 2);
+        lept_reserve_object(v, LEPT_GROW_CAPACITY(v->o.capacity));
+    }
+    if (klen <= LEPT_SHORT_KEY_MAX)
+        lept_set_short_key(&v->o.m[v->o.size], key, klen);
+    else {
+        v->o.m[v->o.size].klen = klen;
+        v->o.m[v->o.size].k = (char*)malloc(v->o.m[v->o.size].klen + 1);
+        memcpy(v->o.m[v->o.size].k, key, v->o.m[v->o.size].klen);
+        v->o.m[v->o.size].k[klen] = '\0';
     }
-    v->o.m[v->o.size].klen = klen;
-    v->o.m[v->o.size].k = (char*)malloc(v->o.m[v->o.size].klen + 1);
-    memcpy(v->o.m[v->o.size].k, key, v->o.m[v->o.size].klen);
-    v->o.m[v->o.size].k[klen] = '\0';
 
     lept_init(&v->o.m[v->o.size].v);
+    if (v->flags & LEPT_FLAG_INDEXED)
+        lept_object_index_insert(v, v->o.size);
     return  &v->o.m[v->o.size++].v;
 }
 
+/* key 已经存在时返回原来的值 */
+lept_value* lept_set_object_value(lept_value* v, const char* key, size_t klen) {
+    size_t index;
+    assert(v != NULL && v->type == LEPT_OBJECT && key != NULL);
+    /* 先查找, 只有追加时才扩容, 更新已有的 key 不会移动成员数组 */
+    if ((index = lept_find_object_index(v, key, klen)) != LEPT_KEY_NOT_EXIST)
+        return &v->o.m[index].v;
+    return lept_append_object_member(v, key, klen);
+}
+
 
 void lept_remove_object_value(lept_value* v, size_t index) {
     assert(v != NULL && v->type == LEPT_OBJECT && index < v->o.size);
-    size_t  i, j;
-    for (i = index; i < v->o.size; i++) {
-        if (i == index) {
-            free(v->o.m[i].k);
-            lept_free(&v->o.m[i].v);
+    if (!(v->flags & LEPT_FLAG_KEYS_BORROWED) && !LEPT_KEY_IS_SHORT(&v->o.m[index]))
+        free(v->o.m[index].k);
+    lept_free(&v->o.m[index].v);
+    /* 保持插入顺序; 后面成员的下标都变了, 索引在下次查找时重建 */
+    memmove(&v->o.m[index], &v->o.m[index + 1], (v->o.size - index - 1) * sizeof(lept_member));
+    v->o.size--;
+    v->flags &= ~LEPT_FLAG_INDEXED;
+}
+
+
+/* RFC 6901: "0" 或者没有前导 0 的十进制数 */
+static size_t lept_pointer_index(const char* s, size_t len) {
+    size_t i, n = 0;
+    if (len == 1 && s[0] == '-')
+        return LEPT_POINTER_END;
+    if (len == 0 || (s[0] == '0' && len > 1))
+        return LEPT_POINTER_NO_INDEX;
+    for (i = 0; i < len; i++) {
+        if (!ISDIGIT(s[i]) || n > (LEPT_POINTER_END - 1 - (s[i] - '0')) / 10)
+            return LEPT_POINTER_NO_INDEX;
+        n = n * 10 + (s[i] - '0');
+    }
+    return n;
+}
+
+int lept_pointer_compile(lept_pointer* p, const char* path) {
+    size_t n = 0, len;
+    const char* s;
+    char* k;
+    assert(p != NULL && path != NULL);
+    p->tokens = NULL;
+    p->size = 0;
+    if (*path == '\0')
+        return 0; // 整个文档
+    if (*path != '/')
+        return LEPT_POINTER_INVALID;
+    len = strlen(path);
+    for (s = path; *s; s++)
+        if (*s == '/')
+            n++;
+    /* 反转义只会变短, 每个 token 去掉的 '/' 正好留给结尾的 '\0' */
+    p->tokens = (lept_pointer_token*)malloc(n * sizeof(lept_pointer_token) + len);
+    k = (char*)(p->tokens + n);
+    for (s = path; *s == '/'; p->size++) {
+        lept_pointer_token* t = &p->tokens[p->size];
+        t->key = k;
+        for (s++; *s != '/' && *s != '\0'; s++) {
+            if (*s != '~')
+                *k++ = *s;
+            else if (s[1] == '0' || s[1] == '1') {
+                *k++ = s[1] == '0' ? '~' : '/';
+                s++;
+            } else {
+                lept_pointer_free(p);
+                return LEPT_POINTER_INVALID;
+            }
+        }
+        t->len = k - t->key;
+        t->index = lept_pointer_index(t->key, t->len);
+        *k++ = '\0';
+    }
+    assert(p->size == n);
+    return 0;
+}
+
+void lept_pointer_free(lept_pointer* p) {
+    assert(p != NULL);
+    free(p->tokens);
+    p->tokens = NULL;
+    p->size = 0;
+}
+
+/* 按 t 找到 v 中的下一层, 不存在时返回 NULL */
+static lept_value* lept_pointer_step(lept_value* v, const lept_pointer_token* t) {
+    if (v->type == LEPT_OBJECT)
+        return lept_find_object_value(v, t->key, t->len);
+    if (v->type == LEPT_ARRAY && t->index < v->size)
+        return &v->e[t->index];
+    return NULL;
+}
+
+lept_value* lept_pointer_get(lept_value* v, const lept_pointer* p) {
+    size_t i;
+    assert(v != NULL && p != NULL);
+    for (i = 0; i < p->size && v != NULL; i++)
+        v = lept_pointer_step(v, &p->tokens[i]);
+    return v;
+}
+
+lept_value* lept_pointer_set(lept_value* v, const lept_pointer* p) {
+    const lept_pointer_token* t;
+    size_t i;
+    assert(v != NULL && p != NULL);
+    if (p->size == 0)
+        return v;
+    for (i = 0; i + 1 < p->size && v != NULL; i++)
+        v = lept_pointer_step(v, &p->tokens[i]);
+    if (v == NULL)
+        return NULL;
+    t = &p->tokens[p->size - 1];
+    if (v->type == LEPT_OBJECT)
+        return lept_set_object_value(v, t->key, t->len);
+    if (v->type == LEPT_ARRAY) {
+        if (t->index < v->size)
+            return &v->e[t->index];
+        if (t->index == v->size || t->index == LEPT_POINTER_END)
+            return lept_pushback_array_element(v);
+    }
+    return NULL;
+}
+
+/*
+ * 投影解析: 只物化 paths 经过的成员和元素, 其它的值用 lept_validate_value 检查后跳过, 不分配内存.
+ * 当前容器中仍然可能匹配的 path 的下标保存在 c->stack 中, set 是它们的偏移, n 是个数, depth 是这一层 token 的下标.
+ * 数组中没有选中的元素用 null 占位, 最后一个选中的元素之后的直接丢弃, 所以结果中 lept_pointer_get 得到的值和完整解析相同.
+ */
+#define LEPT_PROJECTION_SET(c, set) ((size_t*)((c)->stack + (set)))
+
+/* set 中在 depth 层和 key (数组中为 index) 匹配的 path 的个数, 有 path 在这一层结束时 *full 为 1; push 为 1 时把它们压栈 */
+static size_t lept_projection_match (lept_context* c, const lept_pointer* paths, size_t set, size_t n, size_t depth,
+        const char* key, size_t klen, size_t index, int* full, int push) {
+    size_t i, k = 0;
+    for (i = 0; i < n; i++) {
+        size_t j = LEPT_PROJECTION_SET(c, set)[i];
+        const lept_pointer_token* t = &paths[j].tokens[depth];
+        if (key != NULL ? t->len != klen || memcmp(t->key, key, klen) != 0 : t->index != index)
+            continue;
+        k++;
+        *full |= paths[j].size == depth + 1;
+        if (push)
+            *(size_t*)lept_context_push(c, sizeof(size_t)) = j;
+    }
+    return k;
+}
+
+static int lept_parse_projected_value (lept_context* c, lept_value* v, const lept_pointer* paths, size_t set, size_t n, size_t depth);
+
+/*
+ * 解析选中的成员或元素: full 时完整解析; 否则 v 是容器时在下一层继续投影,
+ * 不是容器时经过它的 path 都不存在, 和没有选中一样跳过. 返回时 *keep 表示是否保留
+ */
+static int lept_parse_projected_child (lept_context* c, lept_value* v, const lept_pointer* paths, size_t set, size_t n, size_t depth,
+        const char* key, size_t klen, size_t index, int* keep) {
+    size_t sub = c->top, k;
+    int full = 0, ret;
+    k = lept_projection_match(c, paths, set, n, depth, key, klen, index, &full, 0);
+    *keep = k > 0 && (full || PEEK(c) == '[' || PEEK(c) == '{');
+    if (!*keep)
+        return lept_validate_value(c);
+    if (full)
+        return lept_parse_value(c, v);
+    lept_projection_match(c, paths, set, n, depth, key, klen, index, &full, 1);
+    ret = lept_parse_projected_value(c, v, paths, sub, k, depth + 1);
+    c->top = sub;
+    return ret;
+}
+
+static int lept_parse_array_projected (lept_context* c, lept_value* v, const lept_pointer* paths, size_t set, size_t n, size_t depth) {
+    size_t i, size = 0, last = 0;
+    int any = 0, ret;
+    /* 最后一个选中的下标 */
+    for (i = 0; i < n; i++) {
+        size_t index = paths[LEPT_PROJECTION_SET(c, set)[i]].tokens[depth].index;
+        if (index < LEPT_POINTER_END && (!any || index > last)) {
+            last = index;
+            any = 1;
+        }
+    }
+    EXPECT(c, '[');
+    lept_parse_whitespace(c);
+    if (PEEK(c) == ']') {
+        c->json++;
+        lept_context_pop_array(c, v, 0);
+        return LEPT_PARSE_OK;
+    }
+    for (i = 0;; i++) {
+        lept_value e;
+        int keep = 0;
+        lept_init(&e);
+        lept_parse_whitespace(c);
+        if (any && i <= last)
+            ret = lept_parse_projected_child(c, &e, paths, set, n, depth, NULL, 0, i, &keep);
+        else
+            ret = lept_validate_value(c);
+        if (ret != LEPT_PARSE_OK)
+            break;
+        if (any && i <= last) { // 没有保留的元素用 null 占位
+            if (size == LEPT_MAX_CAPACITY) {
+                lept_free(&e);
+                ret = LEPT_PARSE_TOO_LARGE;
+                break;
+            }
+            memcpy(lept_context_push(c, sizeof(lept_value)), &e, sizeof(lept_value));
+            size++;
+        }
+        lept_parse_whitespace(c);
+        if (PEEK(c) == ',')
+            c->json++;
+        else if (PEEK(c) == ']') {
+            c->json++;
+            lept_context_pop_array(c, v, size);
+            return LEPT_PARSE_OK;
+        } else {
+            ret = LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
             break;
         }
     }
-    for (j = index + 1; j < v->o.size; ++j) {
-        v->o.m[j-1] = v->o.m[j];
+    for (i = 0; i < size; i++)
+        lept_free((lept_value*)lept_context_pop(c, sizeof(lept_value)));
+    return ret;
+}
+
+static int lept_parse_object_projected (lept_context* c, lept_value* v, const lept_pointer* paths, size_t set, size_t n, size_t depth) {
+    size_t i, size = 0;
+    lept_member m;
+    int ret;
+    EXPECT(c, '{');
+    lept_parse_whitespace(c);
+    if (PEEK(c) == '}') {
+        c->json++;
+        lept_context_pop_object(c, v, 0);
+        return LEPT_PARSE_OK;
     }
-    v->o.size--;
+    m.k = NULL;
+    m.klen = 0;
+    lept_init(&m.v);
+    for (;;) {
+        const char* key = c->json;
+        char* str;
+        size_t klen;
+        int full = 0, selected = 0, keep = 0;
+        if (PEEK(c) != '\"') {
+            ret = LEPT_PARSE_MISS_KEY;
+            break;
+        }
+        /* 没有转义的 key 直接和输入比较, 不解码 */
+        if ((ret = lept_validate_string(c)) != LEPT_PARSE_OK)
+            break;
+        klen = c->json - key - 2;
+        if (memchr(key + 1, '\\', klen) == NULL)
+            str = (char*)key + 1;
+        else {
+            c->json = key;
+            lept_parse_string_raw(c, &str, &klen);
+        }
+        /* 只复制可能保留的成员的 key; 之后压栈会覆盖 str */
+        if (lept_projection_match(c, paths, set, n, depth, str, klen, 0, &full, 0) > 0) {
+            selected = 1;
+            if (klen <= LEPT_SHORT_KEY_MAX)
+                lept_set_short_key(&m, str, klen);
+            else {
+                m.k = lept_context_strdup(c, str, klen);
+                m.klen = klen;
+            }
+        }
+        lept_parse_whitespace(c);
+        if (PEEK(c) != ':') {
+            ret = LEPT_PARSE_MISS_COLON;
+            break;
+        }
+        c->json++;
+        lept_parse_whitespace(c);
+        if (!selected)
+            ret = lept_validate_value(c);
+        else
+            ret = lept_parse_projected_child(c, &m.v, paths, set, n, depth, LEPT_KEY(&m), LEPT_KEY_LEN(&m), 0, &keep);
+        if (ret != LEPT_PARSE_OK)
+            break;
+        if (keep) {
+            if (size == LEPT_MAX_CAPACITY) {
+                ret = LEPT_PARSE_TOO_LARGE; // m 在后面释放
+                break;
+            }
+            memcpy(lept_context_push(c, sizeof(lept_member)), &m, sizeof(lept_member));
+            size++;
+        } else if (!LEPT_KEY_IS_SHORT(&m))
+            free(m.k);
+        m.k = NULL; // 已经压栈或者释放
+        m.klen = 0;
+        lept_init(&m.v);
+        lept_parse_whitespace(c);
+        if (PEEK(c) == ',') {
+            c->json++;
+            lept_parse_whitespace(c);
+        } else if (PEEK(c) == '}') {
+            c->json++;
+            lept_context_pop_object(c, v, size);
+            return LEPT_PARSE_OK;
+        } else {
+            ret = LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        }
+    }
+    if (!LEPT_KEY_IS_SHORT(&m))
+        free(m.k);
+    lept_free(&m.v);
+    for (i = 0; i < size; i++) {
+        lept_member* e = (lept_member*)lept_context_pop(c, sizeof(lept_member));
+        if (!LEPT_KEY_IS_SHORT(e))
+            free(e->k);
+        lept_free(&e->v);
+    }
+    return ret;
+}
+
+static int lept_parse_projected_value (lept_context* c, lept_value* v, const lept_pointer* paths, size_t set, size_t n, size_t depth) {
+    return PEEK(c) == '[' ? lept_parse_array_projected(c, v, paths, set, n, depth) : lept_parse_object_projected(c, v, paths, set, n, depth);
 }
 
+int lept_parse_projected (lept_value* v, const char* json, const char* const* paths, size_t npaths) {
+    lept_context c;
+    lept_pointer* p;
+    size_t i;
+    int ret, full = 0;
+    assert(v != NULL && json != NULL && (paths != NULL || npaths == 0));
+    lept_init(v);
+    p = (lept_pointer*)malloc((npaths > 0 ? npaths : 1) * sizeof(lept_pointer));
+    for (i = 0; i < npaths; i++)
+        if (lept_pointer_compile(&p[i], paths[i]) != 0) {
+            while (i-- > 0)
+                lept_pointer_free(&p[i]);
+            free(p);
+            return LEPT_POINTER_INVALID;
+        }
+    c.json = json;
+    c.end = json + strlen(json);
+    c.stack = NULL;
+    c.size = c.top = 0;
+    c.arena = NULL;
+    c.keys = NULL;
+    c.insitu = 0;
+    for (i = 0; i < npaths; i++) {
+        *(size_t*)lept_context_push(&c, sizeof(size_t)) = i;
+        full |= p[i].size == 0;
+    }
+    lept_parse_whitespace(&c);
+    /* 根节点总是保留, 没有选中时为 null */
+    if (full)
+        ret = lept_parse_value(&c, v);
+    else if (PEEK(&c) == '[' || PEEK(&c) == '{')
+        ret = lept_parse_projected_value(&c, v, p, 0, npaths, 0);
+    else
+        ret = lept_validate_value(&c);
+    if (ret == LEPT_PARSE_OK) {
+        lept_parse_whitespace(&c);
+        if (c.json != c.end) {
+            lept_free(v);
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    assert(c.top == npaths * sizeof(size_t));
+    free(c.stack);
+    for (i = 0; i < npaths; i++)
+        lept_pointer_free(&p[i]);
+    free(p);
+    return ret;
+}
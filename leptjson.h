@@ -6,18 +6,57 @@
 #define LEPTJSON_H__
 
 #include <stddef.h> // size_t
+#include <stdint.h> // int64_t uint64_t
+#include <stdio.h> // FILE
 
 typedef enum {LEPT_NULL, LEPT_FALSE, LEPT_TRUE, LEPT_NUMBER, LEPT_STRING, LEPT_ARRAY, LEPT_OBJECT} lept_type;
 
 typedef struct lept_value lept_value; //前置申明
 typedef struct lept_member lept_member; //前置申明
 
+#if defined(LEPT_COMPACT)
+/*
+ * 紧凑布局: 每个节点 16 字节. 长度和元素个数为 32 位, 容量为 23 位, type 和 flags 与容量共用 32 位,
+ * 字段名和默认布局相同. 数组和对象最多 LEPT_COMPACT_MAX_CAPACITY 个元素, 字符串最长 4GB.
+ */
+#define LEPT_COMPACT_MAX_CAPACITY 0x7FFFFF
+struct lept_value {
+    union {
+        struct { // string
+            char* s;
+            uint32_t len;
+        };
+        char ss[sizeof(char*) + sizeof(uint32_t)]; // LEPT_FLAG_INLINE 的短字符串
+        struct { // array
+            lept_value* e;
+            uint32_t size;
+            uint32_t capacity : 23;
+        };
+        struct { // object
+            lept_member* m;
+            uint32_t size;
+            uint32_t capacity : 23;
+        } o;
+        double n;
+        int64_t i; // LEPT_FLAG_INT64
+        uint64_t u; // LEPT_FLAG_UINT64
+        struct { // 和容量在同一个 32 位中
+            void* unused_pointer_;
+            uint32_t unused_size_;
+            uint32_t : 23;
+            uint32_t type : 3; // lept_type
+            uint32_t flags : 6; // LEPT_FLAG_*
+        };
+    };
+};
+#else
 struct lept_value{
     union { // 使用联合体可以节省内存
         struct { // string
             char* s; // 8 字节
             size_t  len; // 4字节
         }; // 占用12 个字节
+        char ss[sizeof(char*) + 2 * sizeof(size_t)]; // LEPT_FLAG_INLINE 的短字符串
         struct { // array
             lept_value *e; // 使用了自身类型指针, 需要前置申明
             size_t  size, capacity;
@@ -29,17 +68,61 @@ struct lept_value{
         } o;
 
         double n; // 8 字节
+        int64_t i; // LEPT_FLAG_INT64
+        uint64_t u; // LEPT_FLAG_UINT64
     };
     lept_type   type; // 4
+    unsigned char flags; // LEPT_FLAG_*, 占用 type 后面的填充字节
 };
+#endif
 
+/* s / e / o.m 指向的内存不归该值所有 (来自 arena 或 insitu 输入), lept_free 不释放 */
+#define LEPT_FLAG_BORROWED      0x01
+/* 对象的 key 不归该值所有 */
+#define LEPT_FLAG_KEYS_BORROWED 0x02
+/* LEPT_NUMBER 的精确整数表示, 分别保存在 i / u 中, 否则保存在 n 中 */
+#define LEPT_FLAG_INT64         0x04
+#define LEPT_FLAG_UINT64        0x08
+/* 对象的成员数组后面带有 key 的哈希索引 */
+#define LEPT_FLAG_INDEXED       0x10
+/* 短字符串直接保存在 ss 中, 没有单独分配 */
+#define LEPT_FLAG_INLINE        0x20
 
+
+/* 短 key 直接保存在 ks 中, ks 中和 klen 最高字节重合的那个字节作为标记 */
 struct lept_member {
-    char* k; // key
-    size_t klen; // key length
+    union {
+        struct {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            size_t klen; // key length
+            char* k; // key
+#else
+            char* k; // key
+            size_t klen; // key length
+#endif
+        };
+        char ks[sizeof(char*) + sizeof(size_t)];
+    };
     lept_value v; // val
 };
 
+typedef struct lept_arena_chunk lept_arena_chunk; //前置申明
+
+/* 块分配器: 从大块内存中顺序分配, 整体释放 */
+typedef struct {
+    lept_arena_chunk* head; // 当前分配的块
+    size_t chunk_size; // 每块的默认大小
+} lept_arena;
+
+typedef struct lept_key_pool_slot lept_key_pool_slot; //前置申明
+
+/* key 池: 相同的 key 只保存一份, 可以在多次解析之间共用; 不是线程安全的 */
+typedef struct {
+    lept_arena arena; // key 的内容
+    lept_key_pool_slot* slots; // 开放寻址的哈希表
+    size_t size, capacity; // key 的个数, 槽数 (0 或 2 的幂)
+} lept_key_pool;
+
 enum {
     LEPT_PARSE_OK = 0,
     LEPT_PARSE_EXPECT_VALUE, // 1
@@ -54,14 +137,232 @@ enum {
     LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, // 10
     LEPT_PARSE_MISS_KEY, // 11
     LEPT_PARSE_MISS_COLON, // 12
-    LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET // 13
-
+    LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, // 13
+    LEPT_PARSE_STOPPED, // 14, SAX 回调要求停止解析
+    LEPT_PARSE_INVALID_UTF8, // 15, 字符串不是合法的 UTF-8, 只有 lept_validate 和定义了 LEPT_CHECK_UTF8 时检查
+    LEPT_PARSE_TOO_LARGE // 16, 元素个数或字符串长度超过紧凑布局的上限, lept_validate 不检查
 };
 
-#define lept_init(v) do {(v)->type = LEPT_NULL; (v)->capacity = 0;} while(0)
+#define lept_init(v) do {(v)->type = LEPT_NULL; (v)->flags = 0; (v)->capacity = 0;} while(0)
 #define LEPT_KEY_NOT_EXIST ((size_t) -1)
 
 int lept_parse(lept_value* v, const char* json);
+/* 字符串、key、数组和对象的内存都从 arena 中分配, 由 lept_arena_reset/lept_arena_destroy 统一释放 */
+int lept_parse_arena(lept_arena* a, lept_value* v, const char* json);
+/* 不能保存在成员中的长 key 从 p 中取得, 相同的 key 共用同一个指针; p 要在 v 释放之后才能销毁 */
+int lept_parse_pooled(lept_key_pool* p, lept_value* v, const char* json);
+/* 字符串和 key 原地解码到 json 中并直接指向它, json 在 v 释放之前必须有效 (解析会修改 json) */
+int lept_parse_insitu(lept_value* v, char* json);
+
+/* 映射到内存中的文件 */
+typedef struct {
+    char* data;
+    size_t size;
+} lept_file_map;
+
+/* lept_parse_file 的 flags */
+#define LEPT_FILE_POPULATE 0x01 // 映射时一次读入整个文件 (MAP_POPULATE)
+/* 打开、读取或映射文件失败, errno 表示原因; 其它返回值和 lept_parse 相同 */
+#define LEPT_FILE_IO_ERROR (-1)
+
+/* 用 mmap 读取文件并解析, 字符串都复制到堆上, 返回前解除映射 */
+int lept_parse_file(lept_value* v, const char* path, int flags);
+/* 字符串和 key 直接指向文件的私有映射 (文件本身不会被修改), 解析成功时 map 保持映射,
+ * 在 lept_free(v) 之后用 lept_file_unmap 释放 */
+int lept_parse_file_insitu(lept_value* v, const char* path, int flags, lept_file_map* map);
+void lept_file_unmap(lept_file_map* map);
+
+/* 解析 [json, json + len), 不需要以 '\0' 结尾, 不会读取 json + len 及之后的字节 */
+int lept_parse_n(lept_value* v, const char* json, size_t len);
+/* 只检查 [json, json + len) 是否为合法的 JSON, 不分配内存; 错误码和 lept_parse_n 相同, 另外检查 UTF-8 */
+int lept_validate(const char* json, size_t len);
+/*
+ * 先用 SIMD 为结构字符和引号建立索引, 再沿着索引解析, 没有转义的字符串直接复制;
+ * 结果和错误码都和 lept_parse 相同 (出错时用 lept_parse 重新解析)
+ */
+int lept_parse_fast(lept_value* v, const char* json);
+/*
+ * SAX 解析的事件回调, 不需要的事件设为 NULL; 回调返回 0 时停止解析, lept_parse_sax 返回 LEPT_PARSE_STOPPED.
+ * 出错之前的事件已经发出. string/key 不以 '\0' 结尾, 只在回调期间有效.
+ */
+typedef struct {
+    int (*null)(void* userdata);
+    int (*boolean)(void* userdata, int b);
+    int (*number)(void* userdata, const lept_value* n); // 用 lept_get_number / lept_get_int64 等读取
+    int (*string)(void* userdata, const char* s, size_t len);
+    int (*key)(void* userdata, const char* k, size_t klen);
+    int (*start_object)(void* userdata);
+    int (*end_object)(void* userdata, size_t size); // size 为成员个数
+    int (*start_array)(void* userdata);
+    int (*end_array)(void* userdata, size_t size); // size 为元素个数
+} lept_handler;
+
+/* 不构建 lept_value, 按顺序调用 handler 中的回调, 错误码和 lept_parse 相同 */
+int lept_parse_sax(const char* json, const lept_handler* handler, void* userdata);
+
+/*
+ * 增量解析: 输入可以按任意长度分块提供, 分块边界可以在 token 中间.
+ * 任何一步出错后 v 为 LEPT_NULL, 之后的调用都返回同一个错误码; lept_stream_finish 的结果和 lept_parse 相同.
+ */
+typedef struct lept_stream_parser lept_stream_parser;
+lept_stream_parser* lept_stream_create(lept_value* v); // 结果写入 v
+int lept_stream_feed(lept_stream_parser* p, const char* buf, size_t len);
+int lept_stream_finish(lept_stream_parser* p); // 输入结束
+void lept_stream_destroy(lept_stream_parser* p);
+
+/*
+ * NDJSON 的回调: offset 为该行在输入中的字节位置, ret 为该行的解析结果 (出错时 v 为 LEPT_NULL).
+ * v 的内存在解析线程的 arena 中, 只在回调期间有效, 不能修改; 需要保留时用 lept_copy. 返回 0 时停止解析.
+ */
+typedef int (*lept_ndjson_fn)(void* userdata, size_t offset, lept_value* v, int ret);
+/*
+ * 按行切分成块, 用 nthreads 个线程 (包括调用者, 不大于 0 时为 CPU 个数) 并行解析每一行, 跳过空行.
+ * ordered 时按输入顺序在各线程中依次回调; 否则在解析的线程中立即回调, callback 需要是线程安全的,
+ * 并且停止之后其它线程当前块中的行还可能回调.
+ * 返回 LEPT_PARSE_OK 或 LEPT_PARSE_STOPPED (回调要求停止), 单行的错误只通过回调报告.
+ */
+int lept_ndjson_parse_parallel(const char* json, size_t len, int nthreads, int ordered, lept_ndjson_fn callback, void* userdata);
+/* 映射整个文件之后调用 lept_ndjson_parse_parallel, 读取失败时返回 LEPT_FILE_IO_ERROR */
+int lept_ndjson_parse_file(const char* path, int nthreads, int ordered, lept_ndjson_fn callback, void* userdata);
+
+void lept_arena_init(lept_arena* a, size_t chunk_size); // chunk_size 为 0 时使用默认大小
+void* lept_arena_alloc(lept_arena* a, size_t size);
+void lept_arena_reset(lept_arena* a); // 保留一块内存以便重用
+void lept_arena_destroy(lept_arena* a);
+
+void lept_key_pool_init(lept_key_pool* p);
+/* 返回池中和 key 相同的字符串 (以 '\0' 结尾), 没有时复制一份; 在 lept_key_pool_destroy 之前有效 */
+const char* lept_key_pool_intern(lept_key_pool* p, const char* key, size_t klen);
+void lept_key_pool_destroy(lept_key_pool* p);
+
+char* lept_stringify(lept_value* v, size_t* length);
+/* 输出目标, 返回 0 表示成功, 返回非 0 时停止输出 */
+typedef int (*lept_write_fn)(void* ctx, const char* data, size_t len);
+/* 使用固定大小的缓冲区, 缓冲区满了就交给 write, 返回 write 的第一个非 0 返回值或 0 */
+int lept_stringify_to(lept_value* v, lept_write_fn write, void* ctx);
+/* 写入失败时返回 LEPT_FILE_IO_ERROR, errno 表示原因 */
+int lept_stringify_file(lept_value* v, FILE* fp);
+int lept_stringify_fd(lept_value* v, int fd);
+
+/*
+ * CBOR (RFC 8949) 二进制编码: 整数和 double 按二进制保存, 字符串带长度, 数组/对象带元素个数,
+ * 解码时不需要转换数字和处理转义, 数组/对象的内存只分配一次. 返回的缓冲区由调用者 free
+ */
+char* lept_encode_cbor(lept_value* v, size_t* length);
+/*
+ * 数据不完整或者不支持 (不定长、字节串、tag、NaN 等) 时返回 LEPT_PARSE_INVALID_VALUE,
+ * key 不是字符串时返回 LEPT_PARSE_MISS_KEY, 后面还有数据时返回 LEPT_PARSE_ROOT_NOT_SINGULAR
+ */
+int lept_decode_cbor(lept_value* v, const char* data, size_t len);
+
+/*
+ * 只读的扁平表示: 整个文档在一个 64 位字的数组中, 字符串都在一个缓冲区中, 容器记录下一个兄弟节点的位置.
+ * 节点用在 words 中的位置表示, 根节点为 0. 比 lept_value 树少很多次内存分配和指针.
+ */
+typedef struct {
+    uint64_t* words;
+    size_t size; // words 的个数
+    char* strings;
+    size_t strings_size;
+} lept_tape;
+
+/* 直接从 JSON 构建 (不经过 lept_value), 错误码和 lept_parse 相同, 出错时 t 为空 */
+int lept_tape_parse(lept_tape* t, const char* json);
+void lept_tape_from_value(lept_tape* t, const lept_value* v);
+void lept_tape_to_value(const lept_tape* t, size_t node, lept_value* v); // 复制为 lept_value, v 不需要初始化
+void lept_tape_free(lept_tape* t);
+
+lept_type lept_tape_get_type(const lept_tape* t, size_t node);
+size_t lept_tape_next(const lept_tape* t, size_t node); // 下一个兄弟节点 (跳过整个子树)
+size_t lept_tape_child(const lept_tape* t, size_t node); // 第一个元素; 对象为第一个 key, 值为 lept_tape_next(key)
+size_t lept_tape_get_size(const lept_tape* t, size_t node); // 元素/成员个数
+size_t lept_tape_find(const lept_tape* t, size_t node, const char* key, size_t klen); // 返回值节点, 没有时为 LEPT_KEY_NOT_EXIST
+int lept_tape_get_boolean(const lept_tape* t, size_t node);
+double lept_tape_get_number(const lept_tape* t, size_t node);
+const char* lept_tape_get_string(const lept_tape* t, size_t node);
+size_t lept_tape_get_string_length(const lept_tape* t, size_t node);
+
+/*
+ * 快照: 可以直接 mmap 使用的只读格式. 节点和 tape 相同, 另外数组带有元素位置表 (按下标 O(1) 访问),
+ * 对象带有按 key 排序的成员表 (二分查找). 只保存相对位置, 映射到任何地址都可以使用.
+ * 打开时只检查文件头, 不解析也不复制, 多个进程映射同一个文件时共享页缓存.
+ * 快照按本机字节序保存; 节点的内容不做检查, 只打开 lept_snapshot_write 写出的文件.
+ * 替换正在被映射的快照时先写到临时文件再 rename, 直接覆盖会让已有的映射读到截断的文件.
+ */
+typedef struct {
+    const uint64_t* words;
+    size_t size; // words 的个数
+    const char* strings;
+    size_t strings_size;
+    lept_file_map map; // lept_snapshot_open 的映射, lept_snapshot_view 时为空
+} lept_snapshot;
+
+/* 不是快照, 或者长度和文件头不一致 */
+#define LEPT_SNAPSHOT_INVALID (-2)
+
+/* 写入失败时返回 LEPT_FILE_IO_ERROR, errno 表示原因 */
+int lept_snapshot_write(const lept_value* v, const char* path);
+/* 映射文件, 返回 LEPT_PARSE_OK, LEPT_FILE_IO_ERROR 或 LEPT_SNAPSHOT_INVALID; flags 和 lept_parse_file 相同 */
+int lept_snapshot_open(lept_snapshot* s, const char* path, int flags);
+/* 使用内存中的快照 (例如共享内存), data 按 8 字节对齐, 在使用 s 期间必须有效 */
+int lept_snapshot_view(lept_snapshot* s, const void* data, size_t size);
+void lept_snapshot_close(lept_snapshot* s);
+void lept_snapshot_to_value(const lept_snapshot* s, size_t node, lept_value* v); // 复制为 lept_value, v 不需要初始化
+
+/* 和 lept_tape_* 相同, 根节点为 0 */
+lept_type lept_snapshot_get_type(const lept_snapshot* s, size_t node);
+size_t lept_snapshot_next(const lept_snapshot* s, size_t node);
+size_t lept_snapshot_child(const lept_snapshot* s, size_t node);
+size_t lept_snapshot_get_size(const lept_snapshot* s, size_t node);
+size_t lept_snapshot_get_element(const lept_snapshot* s, size_t node, size_t index); // 第 index 个元素, O(1)
+size_t lept_snapshot_find(const lept_snapshot* s, size_t node, const char* key, size_t klen); // O(log n), 重复的 key 返回第一个
+int lept_snapshot_get_boolean(const lept_snapshot* s, size_t node);
+double lept_snapshot_get_number(const lept_snapshot* s, size_t node);
+const char* lept_snapshot_get_string(const lept_snapshot* s, size_t node);
+size_t lept_snapshot_get_string_length(const lept_snapshot* s, size_t node);
+
+/*
+ * 按需解析: 只在访问时扫描原始 JSON. 没有访问的值只匹配引号和括号跳过, 不解码也不检查,
+ * 访问到的值用和 lept_parse 相同的词法分析. json 在 lept_doc_free 之前必须有效.
+ */
+typedef struct {
+    const char* json;
+    const char* end;
+    char* stack; // 解码字符串的缓冲区
+    size_t size;
+} lept_doc;
+
+/* 指向文档中的一个值 */
+typedef struct {
+    lept_doc* doc;
+    const char* json; // 值的第一个字符
+    const char* key; // 对象成员的 key 的 '"', 数组元素为 NULL
+    size_t key_len; // key 在 JSON 中的长度 (不含引号)
+} lept_cursor;
+
+/* 数组/对象中没有更多的元素, 或者对象中没有这个 key */
+#define LEPT_CURSOR_END (-2)
+
+void lept_doc_init(lept_doc* d, const char* json, size_t len);
+void lept_doc_free(lept_doc* d);
+/* 根节点之后的内容不检查 */
+int lept_doc_root(lept_doc* d, lept_cursor* c);
+
+/* 只看值的第一个字符, 值是否合法由下面的 get 函数检查 */
+lept_type lept_cursor_get_type(const lept_cursor* c);
+/* 对象中第一个 key 相同的成员, 没有时返回 LEPT_CURSOR_END */
+int lept_cursor_find(const lept_cursor* c, const char* key, size_t klen, lept_cursor* out);
+/* 数组的第一个元素或者对象的第一个成员, 为空时返回 LEPT_CURSOR_END */
+int lept_cursor_child(const lept_cursor* c, lept_cursor* out);
+/* 跳过当前值, 移到下一个兄弟节点, 没有时返回 LEPT_CURSOR_END */
+int lept_cursor_next(lept_cursor* c);
+/* 解码后的 key/字符串在 doc 的缓冲区中, 下一次解码之前有效 */
+int lept_cursor_get_key(const lept_cursor* c, const char** key, size_t* len);
+int lept_cursor_get_string(const lept_cursor* c, const char** s, size_t* len);
+int lept_cursor_get_boolean(const lept_cursor* c, int* b);
+int lept_cursor_get_number(const lept_cursor* c, double* n);
+/* 完整解析这个值 */
+int lept_cursor_get_value(const lept_cursor* c, lept_value* v);
 
 void lept_free(lept_value* v);
 
@@ -74,6 +375,12 @@ void lept_set_boolean(lept_value* v, int b);
 
 double lept_get_number(const lept_value* v);
 void lept_set_number(lept_value* v, double n);
+/* 没有小数和指数部分的数字解析为 64 位整数 (能表示的话), lept_get_number 仍然可以使用 */
+int lept_is_integer(const lept_value* v);
+int64_t lept_get_int64(const lept_value* v);
+void lept_set_int64(lept_value* v, int64_t i);
+uint64_t lept_get_uint64(const lept_value* v);
+void lept_set_uint64(lept_value* v, uint64_t u);
 
 const char* lept_get_string(const lept_value* v);
 size_t lept_get_string_length(const  lept_value* v);
@@ -111,8 +418,42 @@ size_t lept_get_object_capacity(const lept_value* v);
 void lept_reserve_object(lept_value* v, size_t capacity);
 void lept_shrink_object(lept_value* v);
 void lept_clear_object(lept_value* v);
+/* key 已经存在时返回原来的值, 否则追加一个新成员 */
 lept_value* lept_set_object_value(lept_value* v, const char* key, size_t klen);
 void lept_remove_object_value(lept_value* v, size_t index);
 size_t lept_find_object_index (lept_value* v, const char* key, size_t klen);
 lept_value* lept_find_object_value (lept_value* v, const char* key, size_t klen);
+
+/* 编译好的 JSON Pointer (RFC 6901) 中的一段 */
+typedef struct {
+    const char* key; // 反转义后的内容, 以 '\0' 结尾
+    size_t len;
+    size_t index; // 作为数组下标的值, 不是合法的下标时为 LEPT_POINTER_NO_INDEX, "-" 为 LEPT_POINTER_END
+} lept_pointer_token;
+
+typedef struct {
+    lept_pointer_token* tokens; // token 和它们的内容在同一块内存中
+    size_t size;
+} lept_pointer;
+
+#define LEPT_POINTER_NO_INDEX ((size_t)-1)
+#define LEPT_POINTER_END ((size_t)-2) // 数组最后一个元素之后
+/* path 不是合法的 JSON Pointer */
+#define LEPT_POINTER_INVALID (-1)
+
+/* 成功返回 0; 编译一次之后可以反复使用, 查找时不再分配内存和解析字符串 */
+int lept_pointer_compile(lept_pointer* p, const char* path);
+void lept_pointer_free(lept_pointer* p);
+/* 不存在时返回 NULL */
+lept_value* lept_pointer_get(lept_value* v, const lept_pointer* p);
+/* 返回要设置的值: 对象中不存在的 key 追加一个新成员, 数组的 "-" 或者 size 在末尾追加新元素; 上一层不存在时返回 NULL */
+lept_value* lept_pointer_set(lept_value* v, const lept_pointer* p);
+
+/*
+ * 投影解析: 只保留 paths (JSON Pointer) 经过的值, 其它的值只检查语法 (和 lept_validate 相同) 不分配内存.
+ * 经过的对象只保留匹配的成员; 经过的数组中没有选中的元素为 null, 最后一个选中的元素之后的元素被丢弃,
+ * 所以对每个 path 用 lept_pointer_get 得到的值和 lept_parse 相同. 根节点没有被选中时为 null.
+ * 有 path 不合法时返回 LEPT_POINTER_INVALID
+ */
+int lept_parse_projected(lept_value* v, const char* json, const char* const* paths, size_t npaths);
 #endif
\ No newline at end of file
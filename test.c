@@ -3,6 +3,11 @@
 #include <string.h>
 #include "leptjson.h"
 
+/*
+ * 除了普通的构建, 也要在 sanitizer 下运行, UB 直接终止:
+ * cc -g -fsanitize=address,undefined -fno-sanitize-recover=undefined leptjson.c test.c
+ */
+
 static int main_ret = 0;
 static int test_count = 0;
 static int test_pass = 0;
@@ -33,6 +38,14 @@ static int test_pass = 0;
         size_t length;\
         lept_init(&v);\
         EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate(json, strlen(json)));\
+        json2 = lept_stringify(&v, &length);\
+        EXPECT_EQ_STRING(json, json2, length);\
+        free(json2);\
+        json2 = lept_encode_cbor(&v, &length);\
+        lept_free(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_decode_cbor(&v, json2, length));\
+        free(json2);\
         json2 = lept_stringify(&v, &length);\
         EXPECT_EQ_STRING(json, json2, length);\
         lept_free(&v);\
@@ -77,6 +90,7 @@ static void test_parse_false() {
     } while(0)
 
 static void test_parse_number() {
+    char json[1000];
     TEST_NUMBER(0.0, "0");
     TEST_NUMBER(0.0, "-0");
     TEST_NUMBER(0.0, "-0.0");
@@ -106,6 +120,62 @@ static void test_parse_number() {
     TEST_NUMBER(-2.2250738585072014e-308, "-2.2250738585072014e-308");
     TEST_NUMBER( 1.7976931348623157e+308, "1.7976931348623157e+308");  /* Max double */
     TEST_NUMBER(-1.7976931348623157e+308, "-1.7976931348623157e+308");
+
+    TEST_NUMBER(0.1, "0.1");
+    TEST_NUMBER(0.3, "0.3");
+    TEST_NUMBER(9007199254740992.0, "9007199254740993"); /* 2^53 + 1, ties to even */
+    TEST_NUMBER(1.2345678901234568e+29, "123456789012345678901234567890"); /* more than 19 digits */
+    TEST_NUMBER(1.0, "1.00000000000000011102230246251565404236316680908203125"); /* exactly halfway, ties to even */
+    TEST_NUMBER(1.0000000000000002, "1.00000000000000011102230246251565404236316680908203126");
+    TEST_NUMBER(1.0, "1.00000000000000011102230246251565404236316680908203124");
+    TEST_NUMBER(2.2250738585072014e-308, "2.2250738585072012e-308"); /* rounds up to the min normal */
+    TEST_NUMBER(0.0, "0e999999");
+
+    /* 800 位之后的有效数字只影响是否为 0 */
+    memcpy(json, "1.00000000000000011102230246251565404236316680908203125", 55);
+    memset(json + 55, '0', 900);
+    json[955] = '\0';
+    TEST_NUMBER(1.0, json);
+    json[954] = '1';
+    TEST_NUMBER(1.0000000000000002, json);
+}
+
+#define TEST_INT64(expect, json)\
+    do {\
+        lept_value v;\
+        lept_init(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+        EXPECT_EQ_INT(LEPT_NUMBER, lept_get_type(&v));\
+        EXPECT_TRUE(lept_is_integer(&v));\
+        EXPECT_TRUE((expect) == lept_get_int64(&v));\
+        lept_free(&v);\
+    } while(0)
+
+static void test_parse_integer() {
+    lept_value v;
+    TEST_INT64(0, "0");
+    TEST_INT64(-1, "-1");
+    TEST_INT64(9007199254740993LL, "9007199254740993"); /* 2^53 + 1 */
+    TEST_INT64(INT64_MAX, "9223372036854775807");
+    TEST_INT64(INT64_MIN, "-9223372036854775808");
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "18446744073709551615"));
+    EXPECT_TRUE(lept_is_integer(&v));
+    EXPECT_TRUE(UINT64_MAX == lept_get_uint64(&v));
+    EXPECT_EQ_DOUBLE(18446744073709551615.0, lept_get_number(&v));
+
+    /* 超出 64 位整数范围, 或者有小数和指数部分时仍然是 double */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "18446744073709551616"));
+    EXPECT_FALSE(lept_is_integer(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "-9223372036854775809"));
+    EXPECT_FALSE(lept_is_integer(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "-0"));
+    EXPECT_FALSE(lept_is_integer(&v));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "1.0"));
+    EXPECT_FALSE(lept_is_integer(&v));
+    EXPECT_TRUE(1 == lept_get_int64(&v));
+    lept_free(&v);
 }
 
 #define TEST_STRING(expect, json)\
@@ -115,6 +185,7 @@ static void test_parse_number() {
         EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
         EXPECT_EQ_INT(LEPT_STRING, lept_get_type(&v));\
         EXPECT_EQ_STRING(expect, lept_get_string(&v), lept_get_string_length(&v));\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_validate(json, strlen(json)));\
         lept_free(&v);\
     } while(0)
 
@@ -131,6 +202,13 @@ static void test_parse_string() {
     TEST_STRING("\xF0\x9D\x84\x9E", "\"\\uD834\\uDD1E\"");  /* G clef sign U+1D11E */
     TEST_STRING("\xF0\x9D\x84\x9E", "\"\\ud834\\udd1e\"");  /* G clef sign U+1D11E */
 #endif
+    /* 比 SIMD 一次检查的长度更长的字符串 */
+    TEST_STRING("0123456789abcdefghijklmnopqrstuvwxyz0123456789", "\"0123456789abcdefghijklmnopqrstuvwxyz0123456789\"");
+    TEST_STRING("0123456789abcdefghijklmnopqrstuvwxyz\"0123456789\\", "\"0123456789abcdefghijklmnopqrstuvwxyz\\\"0123456789\\\\\"");
+    /* 没有转义的 UTF-8 */
+    TEST_STRING("\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\xED\x9F\xBF\xF4\x8F\xBF\xBF", "\"\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\xED\x9F\xBF\xF4\x8F\xBF\xBF\"");
+    TEST_STRING("0123456789abcdefghijklmnopqrstuvwxyz\xE2\x82\xAC" "0123456789abcdefghijklmnopqrstuvwxyz\xF0\x9D\x84\x9E",
+        "\"0123456789abcdefghijklmnopqrstuvwxyz\xE2\x82\xAC" "0123456789abcdefghijklmnopqrstuvwxyz\xF0\x9D\x84\x9E\"");
 }
 
 
@@ -250,6 +328,50 @@ static void test_parse_object() {
 }
 
 
+/* 没有回调的 handler, SAX 解析只检查语法 */
+static const lept_handler test_sax_null_handler;
+
+/* 复制到恰好 len 字节的缓冲区中, 后面没有 '\0', 越界读取会被 AddressSanitizer 发现 */
+static int test_parse_n(lept_value* v, const char* json, size_t len) {
+    char* buf = (char*)malloc(len > 0 ? len : 1);
+    int ret;
+    memcpy(buf, json, len);
+    ret = lept_parse_n(v, buf, len);
+    free(buf);
+    return ret;
+}
+
+/* 增量解析, 每次输入 chunk 个字节 */
+static int test_stream_parse(lept_value* v, const char* json, size_t chunk) {
+    lept_stream_parser* p = lept_stream_create(v);
+    size_t len = strlen(json), i;
+    int ret = LEPT_PARSE_OK;
+    for (i = 0; i < len && ret == LEPT_PARSE_OK; i += chunk)
+        ret = lept_stream_feed(p, json + i, len - i < chunk ? len - i : chunk);
+    if (ret == LEPT_PARSE_OK)
+        ret = lept_stream_finish(p);
+    lept_stream_destroy(p);
+    return ret;
+}
+
+static int test_tape_error(const char* json) {
+    lept_tape t;
+    int ret = lept_tape_parse(&t, json);
+    EXPECT_TRUE(t.words == NULL && t.size == 0);
+    return ret;
+}
+
+/* 投影解析跳过的值也要检查, 错误码和 lept_parse 相同 */
+static int test_projected_error(const char* json) {
+    static const char* const paths[] = { "/0/1", "/a/a", "/1" };
+    lept_value v;
+    int ret = lept_parse_projected(&v, json, paths, 3);
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_INT(ret, lept_parse_projected(&v, json, NULL, 0));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    return ret;
+}
+
 #define TEST_ERROR(error, json)\
     do {\
         lept_value v;\
@@ -257,9 +379,37 @@ static void test_parse_object() {
         v.type = LEPT_FALSE;\
         EXPECT_EQ_INT(error, lept_parse(&v, json));\
         EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+        EXPECT_EQ_INT(error, lept_parse_sax(json, &test_sax_null_handler, NULL));\
+        EXPECT_EQ_INT(error, test_stream_parse(&v, json, 1));\
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+        EXPECT_EQ_INT(error, test_stream_parse(&v, json, 4096));\
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+        EXPECT_EQ_INT(error, test_parse_n(&v, json, strlen(json)));\
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+        EXPECT_EQ_INT(error, lept_parse_fast(&v, json));\
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+        EXPECT_EQ_INT(error, test_tape_error(json));\
+        EXPECT_EQ_INT(error, lept_validate(json, strlen(json)));\
+        EXPECT_EQ_INT(error, test_projected_error(json));\
         lept_free(&v);\
     } while(0)
 
+static void test_parse_whitespace() {
+    char json[300];
+    size_t i;
+    lept_value v;
+    /* 比 SIMD 一次检查的长度更长的空白 */
+    for (i = 0; i < 100; i++)
+        json[i] = " \t\n\r"[i % 4];
+    strcpy(json + 100, "[ 1 ,\n\n\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t 2 ]                                        ");
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_EQ_SIZE_T(2, lept_get_array_size(&v));
+    EXPECT_EQ_DOUBLE(2.0, lept_get_number(lept_get_array_element(&v, 1)));
+    lept_free(&v);
+    TEST_ERROR(LEPT_PARSE_EXPECT_VALUE, "                                                                \n");
+}
+
 static void test_parse_expect_value() {
     TEST_ERROR(LEPT_PARSE_EXPECT_VALUE, "");
     TEST_ERROR(LEPT_PARSE_EXPECT_VALUE, " ");
@@ -274,6 +424,9 @@ static void test_parse_invalid_value() {
     TEST_ERROR(LEPT_PARSE_INVALID_VALUE, "+1");
     TEST_ERROR(LEPT_PARSE_INVALID_VALUE, ".123"); /* at least one digit before '.' */
     TEST_ERROR(LEPT_PARSE_INVALID_VALUE, "1.");   /* at least one digit after '.' */
+    TEST_ERROR(LEPT_PARSE_INVALID_VALUE, "1e");   /* at least one digit in exponent */
+    TEST_ERROR(LEPT_PARSE_INVALID_VALUE, "1e+");
+    TEST_ERROR(LEPT_PARSE_INVALID_VALUE, "1E-x");
     TEST_ERROR(LEPT_PARSE_INVALID_VALUE, "INF");
     TEST_ERROR(LEPT_PARSE_INVALID_VALUE, "inf");
     TEST_ERROR(LEPT_PARSE_INVALID_VALUE, "NAN");
@@ -297,11 +450,14 @@ static void test_parse_root_not_singular() {
 static void test_parse_number_too_big() {
     TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "1e309");
     TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "-1e309");
+    TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "1.7976931348623159e308");
+    TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "1000000000000000000000000000000e300");
 }
 
 static void test_parse_missing_quotation_mark() {
     TEST_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK, "\"");
     TEST_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK, "\"abc");
+    TEST_ERROR(LEPT_PARSE_MISS_QUOTATION_MARK, "\"0123456789abcdefghijklmnopqrstuvwxyz0123456789");
 }
 
 static void test_parse_invalid_string_escape() {
@@ -317,6 +473,7 @@ static void test_parse_invalid_string_char() {
 #if 1
     TEST_ERROR(LEPT_PARSE_INVALID_STRING_CHAR, "\"\x01\"");
     TEST_ERROR(LEPT_PARSE_INVALID_STRING_CHAR, "\"\x1F\"");
+    TEST_ERROR(LEPT_PARSE_INVALID_STRING_CHAR, "\"0123456789abcdefghijklmnopqrstuvwxyz\x1F\"");
 #endif
 }
 
@@ -371,6 +528,11 @@ static void test_equal() {
     TEST_EQUAL("null", "0", 0);
     TEST_EQUAL("123", "123", 1);
     TEST_EQUAL("123", "456", 0);
+    TEST_EQUAL("123", "123.0", 1);
+    TEST_EQUAL("9007199254740993", "9007199254740992", 0);
+    TEST_EQUAL("9007199254740992", "9007199254740992.0", 1);
+    TEST_EQUAL("9007199254740993", "9007199254740993.0", 0); /* 9007199254740993.0 is 2^53 as a double */
+    TEST_EQUAL("-1", "18446744073709551615", 0);
     TEST_EQUAL("\"abc\"", "\"abc\"", 1);
     TEST_EQUAL("\"abc\"", "\"abcd\"", 0);
     TEST_EQUAL("[]", "[]", 1);
@@ -385,6 +547,7 @@ static void test_equal() {
     TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"b\":2,\"a\":1}", 1);
     TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":3}", 0);
     TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":2,\"c\":3}", 0);
+    TEST_EQUAL("{\"a\":1}", "{\"b\":1}", 0);
     TEST_EQUAL("{\"a\":{\"b\":{\"c\":{}}}}", "{\"a\":{\"b\":{\"c\":{}}}}", 1);
     TEST_EQUAL("{\"a\":{\"b\":{\"c\":{}}}}", "{\"a\":{\"b\":{\"c\":[]}}}", 0);
 }
@@ -458,6 +621,21 @@ static void test_access_number() {
     lept_free(&v);
 }
 
+static void test_access_integer() {
+    lept_value v;
+    lept_init(&v);
+    lept_set_string(&v, "a", 1);
+    lept_set_int64(&v, -1234567890123456789LL);
+    EXPECT_TRUE(lept_is_integer(&v));
+    EXPECT_TRUE(-1234567890123456789LL == lept_get_int64(&v));
+    lept_set_uint64(&v, 18446744073709551000ULL);
+    EXPECT_TRUE(18446744073709551000ULL == lept_get_uint64(&v));
+    lept_set_number(&v, 3.0);
+    EXPECT_FALSE(lept_is_integer(&v));
+    EXPECT_TRUE(3 == lept_get_int64(&v));
+    lept_free(&v);
+}
+
 static void test_access_string() {
     lept_value v;
     lept_init(&v);
@@ -465,6 +643,61 @@ static void test_access_string() {
     EXPECT_EQ_STRING("", lept_get_string(&v), lept_get_string_length(&v));
     lept_set_string(&v, "Hello", 5);
     EXPECT_EQ_STRING("Hello", lept_get_string(&v), lept_get_string_length(&v));
+    lept_set_string(&v, NULL, 0); /* 长度为 0 时允许 NULL */
+    EXPECT_EQ_STRING("", lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+}
+
+/* 长度在短字符串/短 key 上限附近的字符串, 包含 '\0' */
+static void test_access_short_string() {
+    static const char text[] = "0123456789\0abcdefghijklmnopqrstuvwxyz";
+    lept_value v, c, o;
+    char key[64], *json;
+    size_t i, length;
+    lept_init(&v);
+    lept_init(&c);
+    lept_init(&o);
+    lept_set_object(&o, 0);
+    for (i = 0; i < sizeof(text); i++) {
+        lept_set_string(&v, text, i);
+        EXPECT_TRUE(memcmp(text, lept_get_string(&v), i) == 0);
+        EXPECT_EQ_SIZE_T(i, lept_get_string_length(&v));
+        EXPECT_TRUE(lept_get_string(&v)[i] == '\0');
+        lept_copy(&c, &v);
+        EXPECT_TRUE(lept_is_equal(&c, &v));
+        lept_move(lept_set_object_value(&o, text + sizeof(text) - 1 - i, i), &c);
+        EXPECT_TRUE(memcmp(text, lept_get_string(lept_get_object_value(&o, i)), i) == 0);
+        EXPECT_TRUE(memcmp(text + sizeof(text) - 1 - i, lept_get_object_key(&o, i), i) == 0);
+        EXPECT_EQ_SIZE_T(i, lept_get_object_key_length(&o, i));
+        EXPECT_TRUE(lept_get_object_key(&o, i)[i] == '\0');
+    }
+    for (i = 0; i < sizeof(text); i++)
+        EXPECT_EQ_SIZE_T(i, lept_find_object_index(&o, text + sizeof(text) - 1 - i, i));
+
+    /* 解析出的短 key 和长 key 混在一起, 复制、删除、序列化后再解析 */
+    json = lept_stringify(&o, &length);
+    lept_copy(&c, &o);
+    lept_remove_object_value(&c, 3);
+    lept_remove_object_value(&c, 30);
+    EXPECT_EQ_SIZE_T(sizeof(text) - 2, lept_get_object_size(&c));
+    /* 短 key 在成员数组中, 删除后没有索引, 用自己的 key 查找不能使 key 失效 */
+    lept_shrink_object(&c);
+    EXPECT_TRUE(lept_is_equal(&c, &c));
+    lept_remove_object_value(&c, 0);
+    for (i = 0; i < lept_get_object_size(&c); i++)
+        EXPECT_EQ_SIZE_T(i, lept_find_object_index(&c, lept_get_object_key(&c, i), lept_get_object_key_length(&c, i)));
+    lept_free(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_TRUE(lept_is_equal(&v, &o));
+    free(json);
+    lept_free(&v);
+    for (i = 0; i < 20; i++) {
+        sprintf(key, "{\"%.*s\":\"%.*s\",\"k\":", (int)i, "abcdefghijklmnopqrst", (int)i, "0123456789abcdefghij");
+        EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_parse(&v, strcat(key, "1")));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    }
+    lept_free(&o);
+    lept_free(&c);
     lept_free(&v);
 }
 
@@ -617,6 +850,112 @@ static void test_access_object() {
 #endif
 }
 
+/* 成员较多的对象使用哈希索引, 结果要和线性查找一致 */
+static void test_access_object_index() {
+    lept_value o, v, c, *pv;
+    lept_arena a;
+    char key[16], json[1024];
+    size_t i, len, index;
+
+    lept_init(&o);
+    lept_set_object(&o, 0);
+    for (i = 0; i < 1000; i++) {
+        len = sprintf(key, "k%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&o, key, len), i);
+    }
+    EXPECT_EQ_SIZE_T(1000, lept_get_object_size(&o));
+    for (i = 0; i < 1000; i++) {
+        len = sprintf(key, "k%lu", (unsigned long)i);
+        EXPECT_EQ_SIZE_T(i, lept_find_object_index(&o, key, len)); /* 保持插入顺序 */
+    }
+    EXPECT_TRUE(lept_find_object_index(&o, "k1000", 5) == LEPT_KEY_NOT_EXIST);
+
+    /* key 已经存在时不会新增成员 */
+    lept_set_number(lept_set_object_value(&o, "k500", 4), -1.0);
+    EXPECT_EQ_SIZE_T(1000, lept_get_object_size(&o));
+    EXPECT_EQ_DOUBLE(-1.0, lept_get_number(lept_find_object_value(&o, "k500", 4)));
+
+    lept_remove_object_value(&o, 500);
+    EXPECT_EQ_SIZE_T(999, lept_get_object_size(&o));
+    EXPECT_TRUE(lept_find_object_index(&o, "k500", 4) == LEPT_KEY_NOT_EXIST);
+    EXPECT_EQ_SIZE_T(500, lept_find_object_index(&o, "k501", 4));
+    lept_set_number(lept_set_object_value(&o, "k500", 4), 500.0);
+    EXPECT_EQ_SIZE_T(999, lept_find_object_index(&o, "k500", 4));
+
+    lept_init(&c);
+    lept_copy(&c, &o);
+    EXPECT_TRUE(lept_is_equal(&c, &o));
+    EXPECT_EQ_SIZE_T(998, lept_find_object_index(&c, "k999", 4));
+    lept_free(&c);
+
+    lept_shrink_object(&o);
+    EXPECT_EQ_SIZE_T(10, lept_find_object_index(&o, "k10", 3));
+    lept_clear_object(&o);
+    EXPECT_TRUE(lept_find_object_index(&o, "k10", 3) == LEPT_KEY_NOT_EXIST);
+    lept_free(&o);
+
+    /* 查找时建立索引不移动成员数组, 之前取得的指针仍然有效 */
+    lept_set_object(&o, 0);
+    for (i = 0; i < 20; i++) {
+        len = sprintf(key, "k%lu", (unsigned long)i);
+        lept_set_number(lept_set_object_value(&o, key, len), i);
+    }
+    lept_shrink_object(&o);
+    pv = lept_get_object_value(&o, 0);
+    EXPECT_TRUE(lept_find_object_value(&o, "k1", 2) == lept_get_object_value(&o, 1));
+    EXPECT_TRUE(pv == lept_get_object_value(&o, 0));
+    lept_remove_object_value(&o, 0);
+    pv = lept_get_object_value(&o, 0);
+    EXPECT_EQ_SIZE_T(18, lept_find_object_index(&o, "k19", 3));
+    EXPECT_TRUE(pv == lept_get_object_value(&o, 0));
+    /* 满的对象更新已有的 key 不扩容 */
+    lept_shrink_object(&o);
+    pv = lept_get_object_value(&o, 0);
+    EXPECT_EQ_SIZE_T(19, lept_get_object_capacity(&o));
+    EXPECT_TRUE(lept_set_object_value(&o, "k5", 2) == lept_get_object_value(&o, 4));
+    EXPECT_EQ_SIZE_T(19, lept_get_object_capacity(&o));
+    EXPECT_TRUE(pv == lept_get_object_value(&o, 0));
+    lept_free(&o);
+
+    lept_init(&o);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&o, "{\"a\":1,\"b\":2}"));
+    EXPECT_EQ_SIZE_T(2, lept_get_object_capacity(&o));
+    pv = lept_get_object_value(&o, 0);
+    lept_set_number(lept_set_object_value(&o, "a", 1), 3.0);
+    EXPECT_EQ_SIZE_T(2, lept_get_object_capacity(&o));
+    EXPECT_TRUE(pv == lept_get_object_value(&o, 0));
+    EXPECT_EQ_DOUBLE(3.0, lept_get_number(pv));
+    lept_free(&o);
+
+    /* 解析得到的大对象, 重复的 key 返回第一个 */
+    len = sprintf(json, "{");
+    for (i = 0; i < 40; i++)
+        len += sprintf(json + len, "\"k%lu\":%lu,", (unsigned long)i, (unsigned long)i);
+    sprintf(json + len, "\"k7\":\"dup\"}");
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_EQ_SIZE_T(41, lept_get_object_size(&v));
+    EXPECT_EQ_SIZE_T(7, lept_find_object_index(&v, "k7", 2));
+    EXPECT_EQ_SIZE_T(39, lept_find_object_index(&v, "k39", 3));
+    lept_free(&v);
+
+    lept_arena_init(&a, 0);
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_arena(&a, &v, json));
+    EXPECT_EQ_SIZE_T(7, lept_find_object_index(&v, "k7", 2));
+    pv = lept_set_object_value(&v, "new", 3);
+    lept_set_boolean(pv, 1);
+    EXPECT_EQ_SIZE_T(41, lept_find_object_index(&v, "new", 3));
+    index = lept_find_object_index(&v, "k0", 2);
+    EXPECT_EQ_SIZE_T(0, index);
+    pv = lept_get_object_value(&v, 0);
+    lept_remove_object_value(&v, index);
+    EXPECT_EQ_SIZE_T(6, lept_find_object_index(&v, "k7", 2));
+    EXPECT_TRUE(pv == lept_get_object_value(&v, 0)); /* 借用的成员数组也不复制 */
+    lept_free(&v);
+    lept_arena_destroy(&a);
+}
+
 static void test_parse_miss_key() {
     TEST_ERROR(LEPT_PARSE_MISS_KEY, "{:1,");
     TEST_ERROR(LEPT_PARSE_MISS_KEY, "{1:1,");
@@ -640,14 +979,49 @@ static void test_parse_miss_comma_or_curly_bracket() {
     TEST_ERROR(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{}");
 }
 
+/* 没有定义 LEPT_CHECK_UTF8 时只有 lept_validate 检查 UTF-8 */
+#if defined(LEPT_CHECK_UTF8)
+#define TEST_UTF8_ERROR(json) TEST_ERROR(LEPT_PARSE_INVALID_UTF8, json)
+#else
+#define TEST_UTF8_ERROR(json) EXPECT_EQ_INT(LEPT_PARSE_INVALID_UTF8, lept_validate(json, strlen(json)))
+#endif
+
+static void test_parse_invalid_utf8() {
+    TEST_UTF8_ERROR("\"\x80\"");
+    TEST_UTF8_ERROR("\"\xBF\"");
+    TEST_UTF8_ERROR("\"\xC3\"");
+    TEST_UTF8_ERROR("\"\xC3\x28\"");
+    TEST_UTF8_ERROR("\"\xE2\x82\"");
+    TEST_UTF8_ERROR("\"\xE2\x82\\n\"");
+    TEST_UTF8_ERROR("\"\xF0\x9D\x84\"");
+    TEST_UTF8_ERROR("\"\xFF\"");
+    TEST_UTF8_ERROR("\"\xF5\x80\x80\x80\"");
+    /* 过长编码 */
+    TEST_UTF8_ERROR("\"\xC0\x80\"");
+    TEST_UTF8_ERROR("\"\xC1\xBF\"");
+    TEST_UTF8_ERROR("\"\xE0\x9F\xBF\"");
+    TEST_UTF8_ERROR("\"\xF0\x8F\xBF\xBF\"");
+    /* 代理项和超过 U+10FFFF */
+    TEST_UTF8_ERROR("\"\xED\xA0\x80\"");
+    TEST_UTF8_ERROR("\"\xED\xBF\xBF\"");
+    TEST_UTF8_ERROR("\"\xF4\x90\x80\x80\"");
+    /* key 中, 和比 SIMD 一次检查的长度更长的字符串中 */
+    TEST_UTF8_ERROR("{\"\xC3\":1}");
+    TEST_UTF8_ERROR("[\"0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz\xE2\x82\"]");
+    TEST_UTF8_ERROR("\"0123456789abcdefghijklmnopqrstuvwxyz\xED\xA0\x80" "0123456789abcdefghijklmnopqrstuvwxyz\"");
+    TEST_UTF8_ERROR("\"0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz\x80\"");
+}
+
 static void test_parse() {
     test_parse_null();
     test_parse_true();
     test_parse_false();
     test_parse_number();
+    test_parse_integer();
     test_parse_string();
     test_parse_array();
     test_parse_object();
+    test_parse_whitespace();
 
     test_parse_expect_value();
     test_parse_invalid_value();
@@ -664,6 +1038,7 @@ static void test_parse() {
     test_parse_miss_key();
     test_parse_miss_colon();
     test_parse_miss_comma_or_curly_bracket();
+    test_parse_invalid_utf8();
 }
 
 
@@ -681,14 +1056,30 @@ static void test_stringify_number() {
     TEST_ROUNDTRIP("1.234e-20");
 
     TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
-    TEST_ROUNDTRIP("4.9406564584124654e-324"); /* minimum denormal */
-    TEST_ROUNDTRIP("-4.9406564584124654e-324");
-    TEST_ROUNDTRIP("2.2250738585072009e-308");  /* Max subnormal double */
-    TEST_ROUNDTRIP("-2.2250738585072009e-308");
+    TEST_ROUNDTRIP("5e-324"); /* minimum denormal, shortest form of 4.9406564584124654e-324 */
+    TEST_ROUNDTRIP("-5e-324");
+    TEST_ROUNDTRIP("2.225073858507201e-308");  /* Max subnormal double */
+    TEST_ROUNDTRIP("-2.225073858507201e-308");
     TEST_ROUNDTRIP("2.2250738585072014e-308");  /* Min normal positive double */
     TEST_ROUNDTRIP("-2.2250738585072014e-308");
     TEST_ROUNDTRIP("1.7976931348623157e+308");  /* Max double */
     TEST_ROUNDTRIP("-1.7976931348623157e+308");
+
+    /* 最短表示 */
+    TEST_ROUNDTRIP("0.1");
+    TEST_ROUNDTRIP("0.3");
+    TEST_ROUNDTRIP("0.0001");
+    TEST_ROUNDTRIP("1e-05");
+    TEST_ROUNDTRIP("123456.789");
+    TEST_ROUNDTRIP("1e+17");
+    TEST_ROUNDTRIP("12345678901234568");
+    TEST_ROUNDTRIP("9007199254740991"); /* 2^53 - 1 */
+    TEST_ROUNDTRIP("-9007199254740992");
+
+    TEST_ROUNDTRIP("9007199254740993");
+    TEST_ROUNDTRIP("9223372036854775807");
+    TEST_ROUNDTRIP("-9223372036854775808");
+    TEST_ROUNDTRIP("18446744073709551615");
 }
 
 static void test_stringify_string() {
@@ -709,6 +1100,93 @@ static void test_stringify_object() {
     TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
 }
 
+/* 收集 lept_stringify_to 的输出, 第 fail 次调用时返回错误 */
+typedef struct {
+    char* s;
+    size_t len, max;
+    int calls, fail;
+} test_writer;
+
+static int test_write(void* ctx, const char* data, size_t len) {
+    test_writer* w = (test_writer*)ctx;
+    if (++w->calls == w->fail)
+        return 42;
+    w->s = (char*)realloc(w->s, w->len + len);
+    memcpy(w->s + w->len, data, len);
+    w->len += len;
+    if (len > w->max)
+        w->max = len;
+    return 0;
+}
+
+/* 和 lept_stringify 的结果比较 */
+static void test_stringify_to_value(lept_value* v) {
+    test_writer w = {NULL, 0, 0, 0, 0};
+    size_t length;
+    char* json = lept_stringify(v, &length);
+    EXPECT_EQ_INT(0, lept_stringify_to(v, test_write, &w));
+    EXPECT_EQ_SIZE_T(length, w.len);
+    EXPECT_TRUE(w.len == length && memcmp(json, w.s, length) == 0);
+    EXPECT_TRUE(w.max <= 2 * 64 * 1024); // 缓冲区大小是固定的
+    free(json);
+    free(w.s);
+}
+
+static void test_stringify_to() {
+    lept_value v;
+    test_writer w = {NULL, 0, 0, 0, 0};
+    char* s, *json;
+    size_t i, length;
+    FILE* fp;
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"n\":null,\"s\":\"a\\u0001\\n\",\"a\":[1,2.5,-3]}"));
+    test_stringify_to_value(&v);
+    lept_free(&v);
+
+    /* 比缓冲区大得多的字符串, 包含需要转义的字符 */
+    s = (char*)malloc(300000);
+    for (i = 0; i < 300000; i++)
+        s[i] = (char)(i % 97 == 0 ? '\n' : i % 89 == 0 ? 1 : 'a' + i % 26);
+    lept_set_string(&v, s, 300000);
+    test_stringify_to_value(&v);
+    lept_free(&v);
+
+    /* 很多小元素的数组 */
+    lept_set_array(&v, 0);
+    for (i = 0; i < 100000; i++)
+        lept_set_number(lept_pushback_array_element(&v), i * 0.5);
+    lept_set_string(lept_pushback_array_element(&v), s, 300000);
+    test_stringify_to_value(&v);
+
+    /* write 出错后停止输出 */
+    w.fail = 2;
+    EXPECT_EQ_INT(42, lept_stringify_to(&v, test_write, &w));
+    EXPECT_EQ_INT(2, w.calls);
+    free(w.s);
+
+    json = lept_stringify(&v, &length);
+    if ((fp = tmpfile()) != NULL) {
+        char* buf = (char*)malloc(length);
+        EXPECT_EQ_INT(0, lept_stringify_file(&v, fp));
+        rewind(fp);
+        EXPECT_EQ_SIZE_T(length, fread(buf, 1, length, fp));
+        EXPECT_TRUE(memcmp(json, buf, length) == 0);
+        fclose(fp);
+
+        fp = tmpfile();
+        EXPECT_EQ_INT(0, lept_stringify_fd(&v, fileno(fp)));
+        rewind(fp);
+        EXPECT_EQ_SIZE_T(length, fread(buf, 1, length, fp));
+        EXPECT_TRUE(memcmp(json, buf, length) == 0);
+        fclose(fp);
+        free(buf);
+    }
+    free(json);
+    free(s);
+    lept_free(&v);
+}
+
 static void test_stringify() {
     TEST_ROUNDTRIP("null");
     TEST_ROUNDTRIP("false");
@@ -717,14 +1195,1222 @@ static void test_stringify() {
     test_stringify_string();
     test_stringify_array();
     test_stringify_object();
+    test_stringify_to();
 }
+/* 把 SAX 事件记录成文本, stop 为第几个事件时停止 */
+typedef struct {
+    char buf[256];
+    size_t len;
+    int count, stop;
+} test_sax_log;
+
+static int test_sax_event(void* userdata, const char* s, size_t len) {
+    test_sax_log* log = (test_sax_log*)userdata;
+    memcpy(log->buf + log->len, s, len);
+    log->len += len;
+    log->buf[log->len++] = ' ';
+    log->buf[log->len] = '\0';
+    return ++log->count != log->stop;
+}
+
+static int test_sax_null(void* userdata) { return test_sax_event(userdata, "null", 4); }
+static int test_sax_boolean(void* userdata, int b) { return b ? test_sax_event(userdata, "true", 4) : test_sax_event(userdata, "false", 5); }
+static int test_sax_string(void* userdata, const char* s, size_t len) { return test_sax_event(userdata, s, len); }
+static int test_sax_key(void* userdata, const char* k, size_t klen) {
+    test_sax_event(userdata, k, klen);
+    return test_sax_event(userdata, ":", 1);
+}
+static int test_sax_start_object(void* userdata) { return test_sax_event(userdata, "{", 1); }
+static int test_sax_start_array(void* userdata) { return test_sax_event(userdata, "[", 1); }
+
+static int test_sax_number(void* userdata, const lept_value* n) {
+    char buf[32];
+    if (lept_is_integer(n))
+        sprintf(buf, "i%lld", (long long)lept_get_int64(n));
+    else
+        sprintf(buf, "%g", lept_get_number(n));
+    return test_sax_event(userdata, buf, strlen(buf));
+}
+
+static int test_sax_end_object(void* userdata, size_t size) {
+    char buf[32];
+    sprintf(buf, "}%lu", (unsigned long)size);
+    return test_sax_event(userdata, buf, strlen(buf));
+}
+
+static int test_sax_end_array(void* userdata, size_t size) {
+    char buf[32];
+    sprintf(buf, "]%lu", (unsigned long)size);
+    return test_sax_event(userdata, buf, strlen(buf));
+}
+
+static const lept_handler test_sax_handler = {
+    test_sax_null, test_sax_boolean, test_sax_number, test_sax_string, test_sax_key,
+    test_sax_start_object, test_sax_end_object, test_sax_start_array, test_sax_end_array
+};
+
+#define TEST_SAX(expect, json)\
+    do {\
+        test_sax_log log;\
+        log.len = 0;\
+        log.count = log.stop = 0;\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_sax(json, &test_sax_handler, &log));\
+        EXPECT_EQ_STRING(expect, log.buf, log.len);\
+    } while(0)
+
+static void test_parse_sax() {
+    test_sax_log log;
+    TEST_SAX("null ", " null ");
+    TEST_SAX("true ", "true");
+    TEST_SAX("false ", "false");
+    TEST_SAX("i-12 ", "-12");
+    TEST_SAX("1.5 ", "1.5");
+    TEST_SAX("Hello\nWorld ", "\"Hello\\nWorld\"");
+    TEST_SAX("[ ]0 ", "[ ]");
+    TEST_SAX("{ }0 ", "{ }");
+    TEST_SAX("[ null false i1 \"x ]4 ", "[ null , false , 1 , \"\\\"x\" ]");
+    TEST_SAX("{ a : [ i1 [ ]0 ]2 b : { c : true }1 }2 ", "{ \"a\" : [ 1, [] ] , \"b\" : { \"c\" : true } }");
+
+    /* 回调返回 0 时停止, 后面的事件不再发出 */
+    log.len = 0;
+    log.count = 0;
+    log.stop = 3;
+    EXPECT_EQ_INT(LEPT_PARSE_STOPPED, lept_parse_sax("[1, 2, 3, 4]", &test_sax_handler, &log));
+    EXPECT_EQ_STRING("[ i1 i2 ", log.buf, log.len);
+
+    /* 未设置的回调直接跳过 */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_sax("{\"a\":[1,\"b\",null,true,{}]}", &test_sax_null_handler, NULL));
+}
+
+/* 在任意位置分块, 结果都和 lept_parse 相同 */
+static void test_parse_stream() {
+    static const char* json[] = {
+        "null", " true ", "false", "0", "-12345678901234567890", "1.5e-300", "12345678901234567890123",
+        "\"\"", "\"Hello\\nWorld\"", "\"\\\"\\\\\"", "\"\\u00A2\\u20AC\\uD834\\uDD1E\"",
+        "[ ]", "{ }", "[ null , false , true , 123 , \"abc\", [ ], { } ]",
+        "{ \"n\" : null , \"a\" : [ 1, 2, [ 3 ] ] , \"o\" : { \"\\u0041\" : \"b\\\\\" } }",
+        "{\"k0\":0,\"k1\":1,\"k2\":2,\"k3\":3,\"k4\":4,\"k5\":5,\"k6\":6,\"k7\":7,\"k8\":8,"
+        "\"k9\":9,\"k10\":10,\"k11\":11,\"k12\":12,\"k13\":13,\"k14\":14,\"k15\":15,\"k16\":16}"
+    };
+    size_t i, chunk;
+    for (i = 0; i < sizeof(json) / sizeof(json[0]); i++) {
+        lept_value v1, v2;
+        lept_init(&v1);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v1, json[i]));
+        for (chunk = 1; chunk <= 8; chunk++) {
+            EXPECT_EQ_INT(LEPT_PARSE_OK, test_stream_parse(&v2, json[i], chunk));
+            EXPECT_TRUE(lept_is_equal(&v1, &v2));
+            lept_free(&v2);
+        }
+        lept_free(&v1);
+    }
+}
+
+/* 在每个位置截断, lept_parse_n 的结果都和 lept_parse 解析截断后的字符串相同 */
+static void test_parse_length() {
+    static const char* json[] = {
+        "null", "true", "false", "-1.25e+10", "12345678901234567890", "\"a\\u00A2\\uD834\\uDD1E\\\\\"",
+        "[ null , 1 , \"abc\" , [ true ] ]", "{ \"a\" : { \"b\" : false } , \"c\" : -0.5 }"
+    };
+    char buf[64];
+    size_t i, len;
+    for (i = 0; i < sizeof(json) / sizeof(json[0]); i++) {
+        for (len = 0; len <= strlen(json[i]); len++) {
+            lept_value v1, v2;
+            memcpy(buf, json[i], len);
+            buf[len] = '\0';
+            lept_init(&v1);
+            EXPECT_EQ_INT(lept_parse(&v1, buf), test_parse_n(&v2, json[i], len));
+            EXPECT_TRUE(lept_is_equal(&v1, &v2));
+            lept_free(&v1);
+            lept_free(&v2);
+        }
+    }
+    /* 输入中间的 '\0' 是普通的字节, 不是输入的结尾 */
+    {
+        static const struct { const char* json; size_t len; int error; } nul[] = {
+            { "\"a\0b\"", 5, LEPT_PARSE_INVALID_STRING_CHAR },
+            { "\"a\\n\0\"", 6, LEPT_PARSE_INVALID_STRING_CHAR },
+            { "\"a\0", 3, LEPT_PARSE_INVALID_STRING_CHAR },
+            { "\0", 1, LEPT_PARSE_INVALID_VALUE },
+            { " \0 1", 4, LEPT_PARSE_INVALID_VALUE },
+            { "[1,\0]", 5, LEPT_PARSE_INVALID_VALUE },
+            { "{\"a\":\0}", 7, LEPT_PARSE_INVALID_VALUE },
+            { "1\0", 2, LEPT_PARSE_ROOT_NOT_SINGULAR }
+        };
+        lept_value v;
+        lept_stream_parser* p;
+        int ret;
+        for (i = 0; i < sizeof(nul) / sizeof(nul[0]); i++) {
+            lept_init(&v);
+            EXPECT_EQ_INT(nul[i].error, test_parse_n(&v, nul[i].json, nul[i].len));
+            EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+            EXPECT_EQ_INT(nul[i].error, lept_validate(nul[i].json, nul[i].len));
+            p = lept_stream_create(&v);
+            if ((ret = lept_stream_feed(p, nul[i].json, nul[i].len)) == LEPT_PARSE_OK)
+                ret = lept_stream_finish(p);
+            EXPECT_EQ_INT(nul[i].error, ret);
+            lept_stream_destroy(p);
+            lept_free(&v);
+        }
+    }
+}
+
+/* 前面加 0..70 个空白, 让每个字符都落在 64 字节块的不同位置 */
+static void test_parse_fast() {
+    static const char* json[] = {
+        "null", "-1.25e+10", "\"\"", "\"a\\\\\\\\\\\"b\"", "\"\\u00A2\\uD834\\uDD1E\\\\\"",
+        "[ null , 1 , \"a,b]\" , [ true ] ]", "{ \"a\" : { \"b\\\"\" : false } , \"c\" : -0.5 }", "[1,2,3]  ",
+        "{\"abcdefghijklmnopqrstuvwxyz\":\"0123456789abcdefghijklmnopqrstuvwxyz\",\"\":[]}",
+        "[1 2]", "[1,2,]", "{\"a\":1,}", "{\"a\" 1}", "123abc", "[\"a\"b]", "{\"a\"x:1}", "[truex]", "\"abc",
+        "[\"\\\"]", "[\\\"a\"]", "\"\\", "[1]x", "[[[]]", "{\"a\":[1,{\"b\":[]}]}  \t", "[\"a\tb\"]",
+        "{\"a\x01\":1}", "[\"\xC3\xA9\", \"\xC3\"]", "{\"a\":1 \"b\":2}", "{1:2}", "[,]", "{\"a\":}", "]"
+    };
+    char buf[256];
+    size_t i, n;
+    lept_value v1, v2;
+    for (i = 0; i < sizeof(json) / sizeof(json[0]); i++) {
+        for (n = 0; n <= 70; n++) {
+            memset(buf, ' ', n);
+            strcpy(buf + n, json[i]);
+            lept_init(&v1);
+            EXPECT_EQ_INT(lept_parse(&v1, buf), lept_parse_fast(&v2, buf));
+            EXPECT_TRUE(lept_is_equal(&v1, &v2));
+            lept_free(&v1);
+            lept_free(&v2);
+        }
+    }
+}
+
+/* 比 LEPT_STRUCTURAL_WINDOW 大的输入, 字符串和转义跨过窗口的边界 */
+static void test_parse_fast_large() {
+    lept_value v1, v2;
+    char* json = (char*)malloc(300000);
+    size_t i, k = 0;
+    json[k++] = '[';
+    for (i = 0; k < 200000; i++) {
+        if (i > 0) json[k++] = ',';
+        switch (i % 4) {
+            case 0: k += sprintf(json + k, "\"%lu\\\\\\\"x\"", (unsigned long)i); break;
+            case 1: k += sprintf(json + k, " %lu ", (unsigned long)i); break;
+            case 2: k += sprintf(json + k, "{\"k\":[%lu]}", (unsigned long)i); break;
+            default: /* 没有转义的长字符串 */
+                json[k++] = '"';
+                memset(json + k, 'a' + (int)(i % 26), i % 1000);
+                k += i % 1000;
+                json[k++] = '"';
+        }
+    }
+    json[k++] = ']';
+    json[k] = '\0';
+    lept_init(&v1);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v1, json));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_fast(&v2, json));
+    EXPECT_TRUE(lept_is_equal(&v1, &v2));
+    lept_free(&v2);
+    json[k - 1] = ','; // 最后的错误在很远的位置
+    EXPECT_EQ_INT(LEPT_PARSE_EXPECT_VALUE, lept_parse_fast(&v2, json));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v2));
+    lept_free(&v1);
+    free(json);
+}
+
+static void test_parse_tape() {
+    static const char* json[] = {
+        "null", "false", "true", "-1.5", "9223372036854775807", "18446744073709551615", "\"Hello\\u0000World\"",
+        "[]", "{}", "[null,false,true,123,\"abc\",[1,[2,[3]]],{}]",
+        "{\"n\":null,\"a\":[1,2,3],\"o\":{\"x\":\"y\"},\"a\":\"dup\"}"
+    };
+    lept_tape t, t2;
+    lept_value v1, v2;
+    char* s1, *s2;
+    size_t i, k, n1, n2;
+    for (i = 0; i < sizeof(json) / sizeof(json[0]); i++) {
+        lept_init(&v1);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v1, json[i]));
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_tape_parse(&t, json[i]));
+        EXPECT_EQ_INT(lept_get_type(&v1), lept_tape_get_type(&t, 0));
+        EXPECT_EQ_SIZE_T(t.size, lept_tape_next(&t, 0));
+        lept_tape_to_value(&t, 0, &v2);
+        s1 = lept_stringify(&v1, &n1);
+        s2 = lept_stringify(&v2, &n2);
+        EXPECT_TRUE(n1 == n2 && memcmp(s1, s2, n1) == 0); // 有重复的 key, 不能用 lept_is_equal
+        free(s1);
+        free(s2);
+        lept_free(&v2);
+        /* lept_value -> tape 得到相同的 tape */
+        lept_tape_from_value(&t2, &v1);
+        EXPECT_EQ_SIZE_T(t.size, t2.size);
+        EXPECT_EQ_SIZE_T(t.strings_size, t2.strings_size);
+        EXPECT_TRUE(memcmp(t.words, t2.words, t.size * sizeof(uint64_t)) == 0);
+        lept_tape_free(&t2);
+        lept_tape_free(&t);
+        lept_free(&v1);
+    }
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_tape_parse(&t, "{\"n\":null,\"a\":[1,2.5,\"s\"],\"o\":{\"x\":true},\"z\":\"end\"}"));
+    EXPECT_EQ_SIZE_T(4, lept_tape_get_size(&t, 0));
+    k = lept_tape_find(&t, 0, "a", 1);
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_tape_get_type(&t, k));
+    EXPECT_EQ_SIZE_T(3, lept_tape_get_size(&t, k));
+    k = lept_tape_child(&t, k);
+    EXPECT_EQ_DOUBLE(1.0, lept_tape_get_number(&t, k));
+    k = lept_tape_next(&t, k);
+    EXPECT_EQ_DOUBLE(2.5, lept_tape_get_number(&t, k));
+    k = lept_tape_next(&t, k);
+    EXPECT_EQ_STRING("s", lept_tape_get_string(&t, k), lept_tape_get_string_length(&t, k));
+    k = lept_tape_find(&t, 0, "o", 1);
+    EXPECT_TRUE(lept_tape_get_boolean(&t, lept_tape_find(&t, k, "x", 1)));
+    EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_tape_find(&t, k, "y", 1));
+    /* 跳过整个子树 */
+    k = lept_tape_next(&t, k);
+    EXPECT_EQ_STRING("z", lept_tape_get_string(&t, k), lept_tape_get_string_length(&t, k));
+    k = lept_tape_find(&t, 0, "z", 1);
+    EXPECT_EQ_STRING("end", lept_tape_get_string(&t, k), lept_tape_get_string_length(&t, k));
+    lept_tape_free(&t);
+}
+
+static void test_cursor_error(int error, const char* json, const char* path) {
+    lept_doc d;
+    lept_cursor c, e;
+    int ret;
+    lept_doc_init(&d, json, strlen(json));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_root(&d, &c));
+    /* path 中每个字符是一步: c 进入第一个子节点, n 移到下一个兄弟节点 */
+    for (ret = LEPT_PARSE_OK; *path != '\0' && ret == LEPT_PARSE_OK; path++) {
+        if (*path == 'c') {
+            ret = lept_cursor_child(&c, &e);
+            c = e;
+        }
+        else
+            ret = lept_cursor_next(&c);
+    }
+    EXPECT_EQ_INT(error, ret);
+    lept_doc_free(&d);
+}
+
+static void test_parse_cursor() {
+    static const char json[] =
+        " {\"skip\" : [\"]}\\\"[{\", {\"a\":[1,{}]}, \"\\\\\"] ,"
+        " \"n\": -1.5e2, \"t\" : true, \"f\":false, \"z\":null,"
+        " \"o\": {\"a\\u0062c\": \"x\\ty\", \"arr\": [ 10, 20 , 30 ]},"
+        " \"s\": \"Hello\\u0000World\" } ";
+    lept_doc d;
+    lept_cursor root, c, e;
+    lept_value v1, v2;
+    const char* s;
+    size_t len;
+    double n;
+    int b, ret;
+
+    lept_doc_init(&d, json, sizeof(json) - 1);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_root(&d, &root));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_cursor_get_type(&root));
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_find(&root, "n", 1, &c));
+    EXPECT_EQ_INT(LEPT_NUMBER, lept_cursor_get_type(&c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_number(&c, &n));
+    EXPECT_EQ_DOUBLE(-150.0, n);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_find(&root, "t", 1, &c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_boolean(&c, &b));
+    EXPECT_TRUE(b);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_find(&root, "f", 1, &c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_boolean(&c, &b));
+    EXPECT_FALSE(b);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_find(&root, "z", 1, &c));
+    EXPECT_EQ_INT(LEPT_NULL, lept_cursor_get_type(&c));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_cursor_get_boolean(&c, &b));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_find(&root, "s", 1, &c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_string(&c, &s, &len));
+    EXPECT_EQ_STRING("Hello\0World", s, len);
+    EXPECT_EQ_INT(LEPT_CURSOR_END, lept_cursor_find(&root, "x", 1, &c));
+    EXPECT_EQ_INT(LEPT_CURSOR_END, lept_cursor_find(&root, "", 0, &c));
+
+    /* key 中有转义时解码后比较 */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_find(&root, "o", 1, &c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_find(&c, "abc", 3, &e));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_key(&e, &s, &len));
+    EXPECT_EQ_STRING("abc", s, len);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_string(&e, &s, &len));
+    EXPECT_EQ_STRING("x\ty", s, len);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_find(&c, "arr", 3, &e));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_child(&e, &c));
+    EXPECT_TRUE(c.key == NULL);
+    for (n = 10.0, ret = LEPT_PARSE_OK; ret == LEPT_PARSE_OK; ret = lept_cursor_next(&c), n += 10.0) {
+        double m;
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_number(&c, &m));
+        EXPECT_EQ_DOUBLE(n, m);
+    }
+    EXPECT_EQ_INT(LEPT_CURSOR_END, ret);
+    EXPECT_EQ_DOUBLE(40.0, n);
+
+    /* 依次访问所有成员, 跳过的子树中有引号和括号 */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_child(&root, &c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_key(&c, &s, &len));
+    EXPECT_EQ_STRING("skip", s, len);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_value(&c, &v1));
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&v1));
+    EXPECT_EQ_SIZE_T(3, lept_get_array_size(&v1));
+    EXPECT_EQ_STRING("]}\"[{", lept_get_string(lept_get_array_element(&v1, 0)), lept_get_string_length(lept_get_array_element(&v1, 0)));
+    lept_free(&v1);
+    for (len = 1; (ret = lept_cursor_next(&c)) == LEPT_PARSE_OK; len++)
+        ;
+    EXPECT_EQ_INT(LEPT_CURSOR_END, ret);
+    EXPECT_EQ_SIZE_T(7, len);
+
+    /* get_value 和 lept_parse 的结果相同 */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_value(&root, &v1));
+    lept_init(&v2);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v2, json));
+    EXPECT_TRUE(lept_is_equal(&v1, &v2));
+    lept_free(&v1);
+    lept_free(&v2);
+    lept_doc_free(&d);
+
+    /* 空数组和空对象 */
+    lept_doc_init(&d, "[ [], { } ]", 11);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_root(&d, &root));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_child(&root, &c));
+    EXPECT_EQ_INT(LEPT_CURSOR_END, lept_cursor_child(&c, &e));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_next(&c));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_cursor_get_type(&c));
+    EXPECT_EQ_INT(LEPT_CURSOR_END, lept_cursor_find(&c, "a", 1, &e));
+    EXPECT_EQ_INT(LEPT_CURSOR_END, lept_cursor_next(&c));
+    lept_doc_free(&d);
+
+    /* 只读取 len 个字节 */
+    lept_doc_init(&d, "[1,2]", 4);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_root(&d, &root));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_child(&root, &c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_next(&c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_number(&c, &n));
+    EXPECT_EQ_DOUBLE(2.0, n);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_cursor_next(&c));
+    lept_doc_free(&d);
+
+    /* 标量后面紧跟其它字符时和 lept_parse 一样报错 */
+    lept_doc_init(&d, "[123abc, truex, falsey, 1.5\"x\", -2]", 35);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_root(&d, &root));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_child(&root, &c));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_cursor_get_number(&c, &n));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_next(&c));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_cursor_get_boolean(&c, &b));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_next(&c));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_cursor_get_boolean(&c, &b));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_next(&c));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_cursor_get_number(&c, &n));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_next(&c));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_number(&c, &n));
+    EXPECT_EQ_DOUBLE(-2.0, n);
+    lept_doc_free(&d);
+    lept_doc_init(&d, "true", 3);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_root(&d, &root));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_cursor_get_boolean(&root, &b));
+    lept_doc_free(&d);
+    lept_doc_init(&d, "7 ", 2);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_root(&d, &root));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_number(&root, &n));
+    EXPECT_EQ_DOUBLE(7.0, n);
+    lept_doc_free(&d);
+
+    lept_doc_init(&d, " ", 1);
+    EXPECT_EQ_INT(LEPT_PARSE_EXPECT_VALUE, lept_doc_root(&d, &root));
+    lept_doc_free(&d);
+
+    /* 转义的引号出现在每一个位置, 包括按块扫描时块的最后一个字节 */
+    for (len = 0; len < 70; len++) {
+        char buf[96];
+        memcpy(buf, "[[\"", 3);
+        memset(buf + 3, 'a', len);
+        memcpy(buf + 3 + len, "\\\"]\"],1]", 8);
+        lept_doc_init(&d, buf, len + 11);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_doc_root(&d, &root));
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_child(&root, &c));
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_next(&c));
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_cursor_get_number(&c, &n));
+        EXPECT_EQ_DOUBLE(1.0, n);
+        EXPECT_EQ_INT(LEPT_CURSOR_END, lept_cursor_next(&c));
+        lept_doc_free(&d);
+    }
+
+    test_cursor_error(LEPT_PARSE_EXPECT_VALUE, "[", "c");
+    test_cursor_error(LEPT_PARSE_EXPECT_VALUE, "[1,", "cn");
+    test_cursor_error(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1 2]", "cn");
+    test_cursor_error(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[[1,2]", "cn");
+    test_cursor_error(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[[[1]", "ccn");
+    test_cursor_error(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1 \"b\":2}", "cn");
+    test_cursor_error(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{\"b\":1}", "cn");
+    test_cursor_error(LEPT_PARSE_MISS_QUOTATION_MARK, "[\"abc]", "cn");
+    test_cursor_error(LEPT_PARSE_MISS_QUOTATION_MARK, "[\"abc\\\"]", "cn");
+    test_cursor_error(LEPT_PARSE_MISS_QUOTATION_MARK, "{\"a", "c");
+    test_cursor_error(LEPT_PARSE_MISS_KEY, "{1:2}", "c");
+    test_cursor_error(LEPT_PARSE_MISS_KEY, "{\"a\":1,}", "cn");
+    test_cursor_error(LEPT_PARSE_MISS_COLON, "{\"a\" 1}", "c");
+    test_cursor_error(LEPT_PARSE_EXPECT_VALUE, "{\"a\": ", "c");
+}
+
+#define TEST_PROJECTED(expect, json, paths)\
+    do {\
+        lept_value v;\
+        char* s;\
+        size_t length;\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_projected(&v, json, paths, sizeof(paths) / sizeof(paths[0])));\
+        s = lept_stringify(&v, &length);\
+        EXPECT_EQ_STRING(expect, s, length);\
+        free(s);\
+        lept_free(&v);\
+    } while(0)
+
+static void test_parse_projected() {
+    static const char json[] =
+        "{\"a\":{\"b\":1,\"z\":[1,2]},\"c\":[{\"x\":1},{\"x\":\"y\",\"w\":2},3],"
+        " \"d\":{\"e\":[true]}, \"f\":\"skip\", \"a\\u002Fb\":\"slash\", \"d\":null}";
+    static const char* const p1[] = { "/a/b", "/c/1/x", "/d" };
+    static const char* const p2[] = { "/f/g", "/c/x" };
+    static const char* const p3[] = { "/c/1", "/c/1/x", "/a~1b" };
+    static const char* const p4[] = { "/a/b", "" };
+    static const char* const p5[] = { "/2" };
+    static const char* const p6[] = { "/c/-", "/a/01", "/z" };
+    static const char* const bad[] = { "/a", "a" };
+    lept_value v, full;
+    char* s1, *s2;
+    size_t i, n1, n2;
+
+    TEST_PROJECTED("{\"a\":{\"b\":1},\"c\":[null,{\"x\":\"y\"}],\"d\":{\"e\":[true]},\"d\":null}", json, p1);
+    /* 经过标量的 path 不保留它, 对象中没有下标 */
+    TEST_PROJECTED("{\"c\":[]}", json, p2);
+    TEST_PROJECTED("{\"c\":[null,{\"x\":\"y\",\"w\":2}],\"a/b\":\"slash\"}", json, p3);
+    TEST_PROJECTED("{\"a\":{},\"c\":[]}", json, p6);
+    TEST_PROJECTED("[null,null,2]", "[0, [1], 2, {\"x\":3}]", p5);
+    TEST_PROJECTED("[null]", "[0]", p5);
+    TEST_PROJECTED("null", "\"root\"", p5);
+
+    /* "" 选中整个文档; 有重复的 key, 不能用 lept_is_equal */
+    lept_init(&full);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&full, json));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_projected(&v, json, p4, 2));
+    s1 = lept_stringify(&full, &n1);
+    s2 = lept_stringify(&v, &n2);
+    EXPECT_TRUE(n1 == n2 && memcmp(s1, s2, n1) == 0);
+    free(s1);
+    free(s2);
+    lept_free(&v);
+
+    /* 每个 path 得到的值和完整解析相同 */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_projected(&v, json, p1, 3));
+    for (i = 0; i < 3; i++) {
+        lept_pointer p;
+        EXPECT_EQ_INT(0, lept_pointer_compile(&p, p1[i]));
+        EXPECT_TRUE(lept_is_equal(lept_pointer_get(&full, &p), lept_pointer_get(&v, &p)));
+        lept_pointer_free(&p);
+    }
+    lept_free(&v);
+    lept_free(&full);
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_projected(&v, json, NULL, 0));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(&v));
+    EXPECT_EQ_SIZE_T(0, lept_get_object_size(&v));
+    lept_free(&v);
+
+    EXPECT_EQ_INT(LEPT_POINTER_INVALID, lept_parse_projected(&v, json, bad, 2));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    /* 跳过的值和 lept_validate 一样检查 UTF-8 */
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_UTF8, lept_parse_projected(&v, "{\"a\":1,\"b\":\"\xC3\"}", p1, 3));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_parse_projected(&v, "{\"a\":{\"b\":1},\"c\":[{\"x\":1 2}]}", p1, 3));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_parse_projected(&v, "{\"a\":{\"b\":1},\"c\":[0,{\"x\":[1 2]}]}", p1, 3));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+}
+
+#define TEST_CBOR(expect, json)\
+    do {\
+        lept_value v;\
+        char* data, *json2;\
+        size_t length;\
+        lept_init(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+        data = lept_encode_cbor(&v, &length);\
+        EXPECT_EQ_STRING(expect, data, length);\
+        lept_free(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_decode_cbor(&v, data, length));\
+        json2 = lept_stringify(&v, &length);\
+        EXPECT_EQ_STRING(json, json2, length);\
+        lept_free(&v);\
+        free(data);\
+        free(json2);\
+    } while(0)
+
+#define TEST_CBOR_NUMBER(expect, data)\
+    do {\
+        lept_value v;\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_decode_cbor(&v, data, sizeof(data) - 1));\
+        EXPECT_EQ_INT(LEPT_NUMBER, lept_get_type(&v));\
+        EXPECT_EQ_DOUBLE(expect, lept_get_number(&v));\
+        lept_free(&v);\
+    } while(0)
+
+#define TEST_CBOR_ERROR(error, data)\
+    do {\
+        lept_value v;\
+        EXPECT_EQ_INT(error, lept_decode_cbor(&v, data, sizeof(data) - 1));\
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));\
+    } while(0)
+
+static void test_cbor() {
+    lept_value v;
+    char json[1024], *data, *json2;
+    size_t i, n, length;
+
+    TEST_CBOR("\xF6", "null");
+    TEST_CBOR("\xF4", "false");
+    TEST_CBOR("\xF5", "true");
+    /* 整数使用最短的编码 */
+    TEST_CBOR("\x00", "0");
+    TEST_CBOR("\x17", "23");
+    TEST_CBOR("\x18\x18", "24");
+    TEST_CBOR("\x19\x03\xE8", "1000");
+    TEST_CBOR("\x1A\x00\x0F\x42\x40", "1000000");
+    TEST_CBOR("\x1B\x00\x00\x00\xE8\xD4\xA5\x10\x00", "1000000000000");
+    TEST_CBOR("\x1B\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF", "18446744073709551615");
+    TEST_CBOR("\x20", "-1");
+    TEST_CBOR("\x39\x03\xE7", "-1000");
+    TEST_CBOR("\x3B\x7F\xFF\xFF\xFF\xFF\xFF\xFF\xFF", "-9223372036854775808");
+    TEST_CBOR("\xFB\x3F\xF8\x00\x00\x00\x00\x00\x00", "1.5");
+    TEST_CBOR("\xFB\x7E\x37\xE4\x3C\x88\x00\x75\x9C", "1e+300");
+    TEST_CBOR("\x60", "\"\"");
+    TEST_CBOR("\x64" "IETF", "\"IETF\"");
+    TEST_CBOR("\x63" "a" "\0" "b", "\"a\\u0000b\"");
+    TEST_CBOR("\x78\x1A" "abcdefghijklmnopqrstuvwxyz", "\"abcdefghijklmnopqrstuvwxyz\"");
+    TEST_CBOR("\x80", "[]");
+    TEST_CBOR("\x82\x01\x82\x02\x03", "[1,[2,3]]");
+    TEST_CBOR("\xA0", "{}");
+    TEST_CBOR("\xA2\x61" "a" "\x01\x61" "b" "\x82\x02\x03", "{\"a\":1,\"b\":[2,3]}");
+
+    /* 半精度和单精度 */
+    TEST_CBOR_NUMBER(1.0, "\xF9\x3C\x00");
+    TEST_CBOR_NUMBER(-4.0, "\xF9\xC4\x00");
+    TEST_CBOR_NUMBER(65504.0, "\xF9\x7B\xFF");
+    TEST_CBOR_NUMBER(5.960464477539063e-8, "\xF9\x00\x01");
+    TEST_CBOR_NUMBER(100000.0, "\xFA\x47\xC3\x50\x00");
+    TEST_CBOR_NUMBER(-18446744073709551616.0, "\x3B\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF");
+
+    TEST_CBOR_ERROR(LEPT_PARSE_EXPECT_VALUE, "");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\x18");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\x1C");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\x62" "a");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\x83\x01\x62" "ab");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\xA2\x61" "a" "\x01\x61" "b");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\x9F\x01\xFF");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\x41\x00");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\xC1\x00");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\xF7");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\xF9\x7E\x00");
+    TEST_CBOR_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "\xF9\xFC\x00");
+    TEST_CBOR_ERROR(LEPT_PARSE_MISS_KEY, "\xA1\x01\x02");
+    TEST_CBOR_ERROR(LEPT_PARSE_MISS_KEY, "\xA2\x61" "a" "\x01\x02\x03");
+    TEST_CBOR_ERROR(LEPT_PARSE_ROOT_NOT_SINGULAR, "\x01\x02");
+    TEST_CBOR_ERROR(LEPT_PARSE_ROOT_NOT_SINGULAR, "\x81\x01\x01");
+    /* 个数和长度超过剩下的数据, 不能按它分配内存 */
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\x9B\x00\x00\x00\x01\x00\x00\x00\x00\x01");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\xBA\x7F\xFF\xFF\xFF\x61" "a" "\x01");
+    TEST_CBOR_ERROR(LEPT_PARSE_INVALID_VALUE, "\x7B\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF" "a");
+
+    /* 大对象解码后带索引, 长 key 和短 key 都能找到 */
+    n = 0;
+    json[n++] = '{';
+    for (i = 0; i < 40; i++)
+        n += sprintf(json + n, "%s\"%s%u\":%u", i > 0 ? "," : "", i % 2 ? "key" : "a_much_longer_key_", (unsigned)i, (unsigned)i);
+    json[n++] = '}';
+    json[n] = '\0';
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    data = lept_encode_cbor(&v, &length);
+    lept_free(&v);
+    EXPECT_TRUE(length < n);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_decode_cbor(&v, data, length));
+    EXPECT_EQ_SIZE_T(40, lept_get_object_size(&v));
+    EXPECT_EQ_SIZE_T(40, lept_get_object_capacity(&v));
+    EXPECT_TRUE(v.flags & LEPT_FLAG_INDEXED);
+    for (i = 0; i < 40; i++) {
+        char key[32];
+        size_t klen = (size_t)sprintf(key, "%s%u", i % 2 ? "key" : "a_much_longer_key_", (unsigned)i);
+        EXPECT_EQ_SIZE_T(i, lept_find_object_index(&v, key, klen));
+    }
+    json2 = lept_stringify(&v, &length);
+    EXPECT_TRUE(length == n && memcmp(json, json2, n) == 0);
+    lept_free(&v);
+    free(data);
+    free(json2);
+
+    /* 任意截断都返回错误, 不泄漏内存 */
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"a\":[1,-2,3.5,\"x\"],\"a_much_longer_key\":{\"b\":[null,true,\"a long string value\"]}}"));
+    data = lept_encode_cbor(&v, &length);
+    lept_free(&v);
+    for (i = 1; i < length; i++) {
+        EXPECT_EQ_INT(LEPT_PARSE_INVALID_VALUE, lept_decode_cbor(&v, data, i));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    }
+    free(data);
+}
+
+static void test_parse_arena() {
+    lept_arena a;
+    lept_value v, e;
+    char* json;
+    size_t i, length;
+    static const char doc[] = "{\"n\":null,\"s\":\"abc\",\"a\":[1,2,\"x\"],\"o\":{\"k\":\"v\"}}";
+
+    lept_arena_init(&a, 64);
+    for (i = 0; i < 2; i++) {
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_arena(&a, &v, doc));
+        EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(&v));
+        EXPECT_EQ_SIZE_T(4, lept_get_object_size(&v));
+        EXPECT_EQ_STRING("s", lept_get_object_key(&v, 1), lept_get_object_key_length(&v, 1));
+        EXPECT_EQ_STRING("abc", lept_get_string(lept_get_object_value(&v, 1)), lept_get_string_length(lept_get_object_value(&v, 1)));
+        json = lept_stringify(&v, &length);
+        EXPECT_EQ_STRING(doc, json, length);
+        free(json);
+
+        /* 修改 arena 中的值时, 会先复制到堆上 */
+        lept_init(&e);
+        lept_set_string(&e, "Hello", 5);
+        lept_move(lept_pushback_array_element(lept_find_object_value(&v, "a", 1)), &e);
+        lept_move(lept_set_object_value(lept_find_object_value(&v, "o", 1), "w", 1), &e);
+        lept_remove_object_value(&v, 0);
+        EXPECT_EQ_SIZE_T(4, lept_get_array_size(lept_find_object_value(&v, "a", 1)));
+        EXPECT_EQ_SIZE_T(2, lept_get_object_size(lept_find_object_value(&v, "o", 1)));
+        EXPECT_EQ_SIZE_T(3, lept_get_object_size(&v));
+        lept_free(&v);
+        lept_arena_reset(&a);
+    }
+
+    lept_init(&v);
+    v.type = LEPT_FALSE;
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_parse_arena(&a, &v, "{\"a\":[\"b\"],\"c\":1"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    lept_arena_destroy(&a);
+}
+
+static void test_parse_pooled() {
+    lept_key_pool p;
+    lept_value v, e;
+    char key[32];
+    const char* k;
+    char* json;
+    size_t i, length;
+    static const char doc[] = "[{\"id\":1,\"customer_account_id\":\"a\",\"shipping_address\":{\"customer_account_id\":2}},"
+                              "{\"id\":3,\"customer_account_id\":\"b\",\"shipping_address\":null}]";
+
+    lept_key_pool_init(&p);
+    for (i = 0; i < 2; i++) {
+        lept_value *r0, *r1;
+        lept_init(&v);
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_pooled(&p, &v, doc));
+        json = lept_stringify(&v, &length);
+        EXPECT_EQ_STRING(doc, json, length);
+        free(json);
+        /* 相同的长 key 共用池中的同一个指针, 池在多次解析之间共用 */
+        r0 = lept_get_array_element(&v, 0);
+        r1 = lept_get_array_element(&v, 1);
+        k = lept_key_pool_intern(&p, "customer_account_id", 19);
+        EXPECT_TRUE(lept_get_object_key(r0, 1) == k);
+        EXPECT_TRUE(lept_get_object_key(r1, 1) == k);
+        EXPECT_TRUE(lept_get_object_key(lept_get_object_value(r0, 2), 0) == k);
+        EXPECT_TRUE(lept_get_object_key(r0, 2) == lept_get_object_key(r1, 2));
+        EXPECT_EQ_SIZE_T(2, p.size);
+        EXPECT_EQ_SIZE_T(1, lept_find_object_index(r0, k, 19));
+        EXPECT_EQ_SIZE_T(1, lept_find_object_index(r0, "customer_account_id", 19));
+
+        /* 修改时借用的 key 先复制到堆上 */
+        lept_init(&e);
+        lept_copy(&e, r1);
+        EXPECT_TRUE(lept_is_equal(&e, r1));
+        lept_set_number(lept_set_object_value(r1, "billing_address_line", 20), 4);
+        lept_remove_object_value(r0, 1);
+        EXPECT_EQ_SIZE_T(4, lept_get_object_size(r1));
+        EXPECT_EQ_SIZE_T(2, lept_get_object_size(r0));
+        EXPECT_TRUE(lept_get_object_key(r1, 1) != k);
+        EXPECT_FALSE(lept_is_equal(&e, r1));
+        lept_free(&e);
+        lept_free(&v);
+    }
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, lept_parse_pooled(&p, &v, "[{\"shipping_address\":[\"b\"],\"a_very_long_key_name\":1"));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_SIZE_T(3, p.size);
+
+    /* 扩容后原来的 key 还能找到 */
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "pooled_key_%lu", (unsigned long)i);
+        EXPECT_TRUE(strcmp(key, lept_key_pool_intern(&p, key, strlen(key))) == 0);
+    }
+    EXPECT_EQ_SIZE_T(1003, p.size);
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "pooled_key_%lu", (unsigned long)i);
+        k = lept_key_pool_intern(&p, key, strlen(key));
+        EXPECT_TRUE(lept_key_pool_intern(&p, k, strlen(k)) == k);
+    }
+    EXPECT_EQ_SIZE_T(1003, p.size);
+    lept_key_pool_destroy(&p);
+}
+
+static void test_parse_insitu() {
+    lept_value v;
+    char json[] = "{\"k\\u0041\":[\"Hello\\nWorld\",\"\\uD834\\uDD1E\"],\"s\":\"abc\"}";
+    char bad[] = "[\"a\",\"\\v\"]";
+    char text[] = "\"0123456789\\tabcdefghijklmnopqrstuvwxyz\\u00A20123456789abcdefghijklmnopqrstuvwxyz\"";
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_insitu(&v, json));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(&v));
+    EXPECT_EQ_STRING("kA", lept_get_object_key(&v, 0), lept_get_object_key_length(&v, 0));
+    EXPECT_TRUE(lept_get_object_key(&v, 0) > json && lept_get_object_key(&v, 0) < json + sizeof(json));
+    {
+        lept_value* a = lept_get_object_value(&v, 0);
+        EXPECT_EQ_STRING("Hello\nWorld", lept_get_string(lept_get_array_element(a, 0)), lept_get_string_length(lept_get_array_element(a, 0)));
+        EXPECT_EQ_STRING("\xF0\x9D\x84\x9E", lept_get_string(lept_get_array_element(a, 1)), lept_get_string_length(lept_get_array_element(a, 1)));
+    }
+    EXPECT_EQ_STRING("abc", lept_get_string(lept_get_object_value(&v, 1)), lept_get_string_length(lept_get_object_value(&v, 1)));
+    lept_set_string(lept_set_object_value(&v, "t", 1), "x", 1);
+    EXPECT_EQ_SIZE_T(3, lept_get_object_size(&v));
+    lept_free(&v);
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_insitu(&v, text));
+    EXPECT_EQ_STRING("0123456789\tabcdefghijklmnopqrstuvwxyz\xC2\xA2" "0123456789abcdefghijklmnopqrstuvwxyz", lept_get_string(&v), lept_get_string_length(&v));
+    lept_free(&v);
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_STRING_ESCAPE, lept_parse_insitu(&v, bad));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+}
+
+#define TEST_FILE_PATH "leptjson_test_file.json"
+
+static void test_write_file(const char* data, size_t len) {
+    FILE* fp = fopen(TEST_FILE_PATH, "wb");
+    fwrite(data, 1, len, fp);
+    fclose(fp);
+}
+
+static void test_parse_file() {
+    lept_value v;
+    lept_file_map map;
+    char json[4096];
+    const char* doc = "{\"a\":[1,2.5,\"x\\ny\"],\"b\":true}";
+
+    test_write_file(doc, strlen(doc));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_file(&v, TEST_FILE_PATH, 0));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_get_type(&v));
+    EXPECT_EQ_STRING("x\ny", lept_get_string(lept_get_array_element(lept_find_object_value(&v, "a", 1), 2)), 3);
+    lept_free(&v);
+
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_file_insitu(&v, TEST_FILE_PATH, LEPT_FILE_POPULATE, &map));
+    EXPECT_EQ_SIZE_T(strlen(doc), map.size);
+    EXPECT_EQ_STRING("a", lept_get_object_key(&v, 0), lept_get_object_key_length(&v, 0));
+    EXPECT_TRUE(lept_get_object_key(&v, 0) > map.data && lept_get_object_key(&v, 0) < map.data + map.size);
+    lept_free(&v);
+    lept_file_unmap(&map);
+    /* 私有映射, 文件没有被修改 */
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_file(&v, TEST_FILE_PATH, 0));
+    EXPECT_EQ_STRING("x\ny", lept_get_string(lept_get_array_element(lept_find_object_value(&v, "a", 1), 2)), 3);
+    lept_free(&v);
+
+    /* 文件正好占满一页, 最后是数字, 后面没有 '\0' */
+    memset(json, ' ', sizeof(json));
+    memcpy(json + sizeof(json) - 5, "12345", 5);
+    test_write_file(json, sizeof(json));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse_file(&v, TEST_FILE_PATH, 0));
+    EXPECT_EQ_DOUBLE(12345.0, lept_get_number(&v));
+    lept_free(&v);
+    memcpy(json + sizeof(json) - 5, "\"abcd", 5);
+    test_write_file(json, sizeof(json));
+    EXPECT_EQ_INT(LEPT_PARSE_MISS_QUOTATION_MARK, lept_parse_file(&v, TEST_FILE_PATH, 0));
+    json[sizeof(json) - 1] = '\\';
+    test_write_file(json, sizeof(json));
+    EXPECT_EQ_INT(LEPT_PARSE_INVALID_STRING_ESCAPE, lept_parse_file_insitu(&v, TEST_FILE_PATH, 0, &map));
+    EXPECT_TRUE(map.data == NULL);
+
+    test_write_file("", 0);
+    EXPECT_EQ_INT(LEPT_PARSE_EXPECT_VALUE, lept_parse_file(&v, TEST_FILE_PATH, 0));
+    remove(TEST_FILE_PATH);
+
+    /* I/O 错误和解析错误分开 */
+    EXPECT_EQ_INT(LEPT_FILE_IO_ERROR, lept_parse_file(&v, TEST_FILE_PATH, 0));
+    EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&v));
+    EXPECT_EQ_INT(LEPT_FILE_IO_ERROR, lept_parse_file_insitu(&v, TEST_FILE_PATH, 0, &map));
+}
+
+static void test_snapshot() {
+    lept_value v, v2;
+    lept_snapshot s, s2;
+    size_t a, k, i, n;
+    char json[2048], key[32];
+    uint64_t* buf;
+    FILE* fp;
+    const char* doc = "{\"b\":[1,-2,2.5,\"x\\u0000y\",[],{}],\"a\":{\"n\":null,\"t\":true,\"f\":false},"
+                      "\"big\":18446744073709551615,\"\":\"empty\",\"a\":\"dup\"}";
+
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, doc));
+    EXPECT_EQ_INT(0, lept_snapshot_write(&v, TEST_FILE_PATH));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_snapshot_open(&s, TEST_FILE_PATH, 0));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_snapshot_get_type(&s, 0));
+    EXPECT_EQ_SIZE_T(5, lept_snapshot_get_size(&s, 0));
+
+    /* 数组按下标访问 */
+    a = lept_snapshot_find(&s, 0, "b", 1);
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_snapshot_get_type(&s, a));
+    EXPECT_EQ_SIZE_T(6, lept_snapshot_get_size(&s, a));
+    EXPECT_EQ_DOUBLE(-2.0, lept_snapshot_get_number(&s, lept_snapshot_get_element(&s, a, 1)));
+    EXPECT_EQ_DOUBLE(2.5, lept_snapshot_get_number(&s, lept_snapshot_get_element(&s, a, 2)));
+    k = lept_snapshot_get_element(&s, a, 3);
+    EXPECT_EQ_STRING("x\0y", lept_snapshot_get_string(&s, k), lept_snapshot_get_string_length(&s, k));
+    EXPECT_EQ_SIZE_T(0, lept_snapshot_get_size(&s, lept_snapshot_get_element(&s, a, 4)));
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_snapshot_get_type(&s, lept_snapshot_get_element(&s, a, 5)));
+    EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_snapshot_find(&s, lept_snapshot_get_element(&s, a, 5), "a", 1));
+    /* 下标访问和顺序遍历得到相同的节点 */
+    for (i = 0, k = lept_snapshot_child(&s, a); i < 6; i++, k = lept_snapshot_next(&s, k))
+        EXPECT_EQ_SIZE_T(k, lept_snapshot_get_element(&s, a, i));
+
+    /* 重复的 key 和 lept_find_object_value 一样返回第一个 */
+    a = lept_snapshot_find(&s, 0, "a", 1);
+    EXPECT_EQ_INT(LEPT_OBJECT, lept_snapshot_get_type(&s, a));
+    EXPECT_EQ_INT(LEPT_NULL, lept_snapshot_get_type(&s, lept_snapshot_find(&s, a, "n", 1)));
+    EXPECT_TRUE(lept_snapshot_get_boolean(&s, lept_snapshot_find(&s, a, "t", 1)));
+    EXPECT_FALSE(lept_snapshot_get_boolean(&s, lept_snapshot_find(&s, a, "f", 1)));
+    EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_snapshot_find(&s, a, "x", 1));
+    EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_snapshot_find(&s, 0, "bb", 2));
+    k = lept_snapshot_find(&s, 0, "", 0);
+    EXPECT_EQ_STRING("empty", lept_snapshot_get_string(&s, k), lept_snapshot_get_string_length(&s, k));
+
+    /* 遍历成员保持原来的顺序, 复制出来和原来的值相同 */
+    k = lept_snapshot_child(&s, 0);
+    EXPECT_EQ_STRING("b", lept_snapshot_get_string(&s, k), lept_snapshot_get_string_length(&s, k));
+    lept_snapshot_to_value(&s, lept_snapshot_find(&s, 0, "big", 3), &v2);
+    EXPECT_TRUE(lept_get_uint64(&v2) == UINT64_MAX);
+    lept_free(&v2);
+    lept_snapshot_to_value(&s, 0, &v2);
+    {
+        char* s1, *s2;
+        size_t n1, n2;
+        s1 = lept_stringify(&v, &n1);
+        s2 = lept_stringify(&v2, &n2);
+        EXPECT_TRUE(n1 == n2 && memcmp(s1, s2, n1) == 0);
+        free(s1);
+        free(s2);
+    }
+    lept_free(&v2);
+
+    /* 内存中的快照, 位置都是相对的 */
+    n = s.map.size;
+    buf = (uint64_t*)malloc(n);
+    memcpy(buf, s.map.data, n);
+    lept_snapshot_close(&s);
+    EXPECT_TRUE(s.words == NULL && s.map.data == NULL);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_snapshot_view(&s2, buf, n));
+    a = lept_snapshot_find(&s2, 0, "b", 1);
+    EXPECT_EQ_DOUBLE(1.0, lept_snapshot_get_number(&s2, lept_snapshot_get_element(&s2, a, 0)));
+    lept_snapshot_close(&s2);
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_INVALID, lept_snapshot_view(&s2, buf, n - 8));
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_INVALID, lept_snapshot_view(&s2, buf, 16));
+    buf[0] ^= 1;
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_INVALID, lept_snapshot_view(&s2, buf, n));
+    EXPECT_TRUE(s2.words == NULL);
+    free(buf);
+    lept_free(&v);
+
+    /* 标量作为根 */
+    lept_init(&v);
+    lept_set_string(&v, "root", 4);
+    EXPECT_EQ_INT(0, lept_snapshot_write(&v, TEST_FILE_PATH));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_snapshot_open(&s, TEST_FILE_PATH, LEPT_FILE_POPULATE));
+    EXPECT_EQ_STRING("root", lept_snapshot_get_string(&s, 0), lept_snapshot_get_string_length(&s, 0));
+    lept_snapshot_close(&s);
+    lept_free(&v);
+
+    /* 大对象: 每个 key 都能通过二分查找找到 */
+    n = 0;
+    json[n++] = '{';
+    for (i = 0; i < 100; i++)
+        n += sprintf(json + n, "%s\"%s%u\":%u", i > 0 ? "," : "", i % 3 ? "k" : "longer_key_", (unsigned)(i * 7919 % 1000), (unsigned)i);
+    json[n++] = '}';
+    json[n] = '\0';
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_EQ_INT(0, lept_snapshot_write(&v, TEST_FILE_PATH));
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_snapshot_open(&s, TEST_FILE_PATH, 0));
+    for (i = 0; i < 100; i++) {
+        size_t klen = (size_t)sprintf(key, "%s%u", i % 3 ? "k" : "longer_key_", (unsigned)(i * 7919 % 1000));
+        EXPECT_EQ_DOUBLE((double)i, lept_snapshot_get_number(&s, lept_snapshot_find(&s, 0, key, klen)));
+    }
+    EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_snapshot_find(&s, 0, "k1", 2));
+    EXPECT_EQ_SIZE_T(LEPT_KEY_NOT_EXIST, lept_snapshot_find(&s, 0, "longer_key_", 11));
+    lept_snapshot_close(&s);
+    lept_free(&v);
+
+    /* JSON 文件不是快照 */
+    test_write_file(doc, strlen(doc));
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_INVALID, lept_snapshot_open(&s, TEST_FILE_PATH, 0));
+    EXPECT_TRUE(s.words == NULL && s.map.data == NULL);
+    if ((fp = fopen(TEST_FILE_PATH, "wb")) != NULL)
+        fclose(fp);
+    EXPECT_EQ_INT(LEPT_SNAPSHOT_INVALID, lept_snapshot_open(&s, TEST_FILE_PATH, 0));
+    remove(TEST_FILE_PATH);
+    EXPECT_EQ_INT(LEPT_FILE_IO_ERROR, lept_snapshot_open(&s, TEST_FILE_PATH, 0));
+    EXPECT_EQ_INT(LEPT_FILE_IO_ERROR, lept_snapshot_write(&v, "no_such_dir/leptjson_snapshot"));
+}
+
+/* NDJSON 回调: 按顺序时检查 id 连续, marks[offset] 记录每一行 (不同的行写不同的位置, 多线程回调也没有问题) */
+typedef struct {
+    char* marks;
+    size_t count, next_id, errors, stop;
+    int ordered;
+} test_ndjson;
+
+static int test_ndjson_line(void* userdata, size_t offset, lept_value* v, int ret) {
+    test_ndjson* t = (test_ndjson*)userdata;
+    t->marks[offset] = ret == LEPT_PARSE_OK ? 1 : 2;
+    if (t->ordered) {
+        if (ret == LEPT_PARSE_OK) {
+            if ((size_t)lept_get_number(lept_find_object_value(v, "id", 2)) != t->next_id)
+                t->errors++;
+            t->next_id++;
+        } else {
+            if (lept_get_type(v) != LEPT_NULL)
+                t->errors++;
+            t->next_id++;
+        }
+        return ++t->count != t->stop;
+    }
+    return 1;
+}
+
+/* 生成 n 行, 每 1000 行有一行错误, 中间夹着空行和 \r\n */
+static char* test_make_ndjson(size_t n, size_t* len) {
+    char* json = (char*)malloc(n * 80 + 1);
+    size_t i, k = 0;
+    for (i = 0; i < n; i++) {
+        if (i % 1000 == 999)
+            k += sprintf(json + k, "{\"id\":%lu,}\n", (unsigned long)i);
+        else
+            k += sprintf(json + k, "{\"id\":%lu,\"name\":\"line %lu\",\"tags\":[1,2,3]}%s", (unsigned long)i, (unsigned long)i,
+                         i % 7 == 0 ? "\r\n\n  \n" : i + 1 < n ? "\n" : "");
+    }
+    *len = k;
+    return json;
+}
+
+static void test_ndjson_check(const char* json, size_t len, int nthreads, int ordered) {
+    test_ndjson t = {NULL, 0, 0, 0, 0, 0};
+    size_t i, lines = 0, bad = 0, missing = 0;
+    t.marks = (char*)calloc(len + 1, 1);
+    t.ordered = ordered;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_ndjson_parse_parallel(json, len, nthreads, ordered, test_ndjson_line, &t));
+    EXPECT_EQ_SIZE_T(0, t.errors);
+    for (i = 0; i < len; i++)
+        if (json[i] == '{' && (i == 0 || json[i - 1] == '\n')) {
+            lines++;
+            bad += json[i + strcspn(json + i, "\n") - 1] == ',' || json[i + strcspn(json + i, "\n") - 2] == ',';
+            missing += t.marks[i] == 0;
+        }
+    for (i = 0; i < len; i++)
+        if (t.marks[i] != 0)
+            lines--, bad -= t.marks[i] == 2;
+    EXPECT_EQ_SIZE_T(0, missing);
+    EXPECT_EQ_SIZE_T(0, lines);
+    EXPECT_EQ_SIZE_T(0, bad);
+    free(t.marks);
+}
+
+static void test_parse_ndjson() {
+    test_ndjson t = {NULL, 0, 0, 0, 0, 1};
+    size_t len;
+    char* json = test_make_ndjson(40000, &len); // 大于 LEPT_NDJSON_CHUNK_SIZE 的几倍
+
+    test_ndjson_check(json, len, 1, 1);
+    test_ndjson_check(json, len, 4, 1);
+    test_ndjson_check(json, len, 4, 0);
+    test_ndjson_check(json, len, 0, 0);
+    test_ndjson_check(json, 0, 4, 1);
+    test_ndjson_check("\n \n", 3, 4, 1);
+
+    /* 按顺序时回调要求停止之后不再回调 */
+    t.marks = (char*)calloc(len, 1);
+    t.stop = 10;
+    EXPECT_EQ_INT(LEPT_PARSE_STOPPED, lept_ndjson_parse_parallel(json, len, 4, 1, test_ndjson_line, &t));
+    EXPECT_EQ_SIZE_T(10, t.count);
+    free(t.marks);
+
+    test_write_file(json, len);
+    t.marks = (char*)calloc(len, 1);
+    t.stop = t.count = t.next_id = 0;
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_ndjson_parse_file(TEST_FILE_PATH, 0, 1, test_ndjson_line, &t));
+    EXPECT_EQ_SIZE_T(40000, t.count);
+    EXPECT_EQ_SIZE_T(0, t.errors);
+    free(t.marks);
+    remove(TEST_FILE_PATH);
+    EXPECT_EQ_INT(LEPT_FILE_IO_ERROR, lept_ndjson_parse_file(TEST_FILE_PATH, 0, 1, test_ndjson_line, &t));
+    free(json);
+}
+
+/* 紧凑布局中 type/flags 和容量共用 32 位, 设置容量不能改变类型 */
+static void test_access_compact() {
+#if defined(LEPT_COMPACT)
+    lept_value a;
+    size_t i;
+    if (sizeof(void*) == 8)
+        EXPECT_EQ_SIZE_T(16, sizeof(lept_value));
+    lept_init(&a);
+    lept_set_array(&a, (size_t)1 << 20);
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&a));
+    EXPECT_EQ_SIZE_T((size_t)1 << 20, lept_get_array_capacity(&a));
+    for (i = 0; i < ((size_t)1 << 20) + 1; i++)
+        lept_set_number(lept_pushback_array_element(&a), (double)i);
+    EXPECT_EQ_INT(LEPT_ARRAY, lept_get_type(&a));
+    EXPECT_EQ_SIZE_T((size_t)1 << 21, lept_get_array_capacity(&a));
+    EXPECT_EQ_DOUBLE((double)(1 << 20), lept_get_number(lept_get_array_element(&a, (size_t)1 << 20)));
+    lept_free(&a);
+
+    /* 解析超过容量上限的数组返回错误, 不截断容量 */
+    {
+        size_t n = LEPT_COMPACT_MAX_CAPACITY + 1, len = 2 * n + 1;
+        char* json = (char*)malloc(len + 1);
+        lept_stream_parser* p;
+        json[0] = '[';
+        for (i = 0; i < n; i++)
+            memcpy(json + 1 + 2 * i, "0,", 2);
+        json[len - 1] = ']';
+        json[len] = '\0';
+        EXPECT_EQ_INT(LEPT_PARSE_TOO_LARGE, lept_parse(&a, json));
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&a));
+        p = lept_stream_create(&a);
+        lept_stream_feed(p, json, len);
+        EXPECT_EQ_INT(LEPT_PARSE_TOO_LARGE, lept_stream_finish(p));
+        lept_stream_destroy(p);
+        EXPECT_EQ_INT(LEPT_NULL, lept_get_type(&a));
+        /* 正好是上限 */
+        json[len - 3] = ']';
+        json[len - 2] = '\0';
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&a, json));
+        EXPECT_EQ_SIZE_T(LEPT_COMPACT_MAX_CAPACITY, lept_get_array_size(&a));
+        EXPECT_EQ_SIZE_T(LEPT_COMPACT_MAX_CAPACITY, lept_get_array_capacity(&a));
+        lept_free(&a);
+        free(json);
+    }
+#endif
+}
+
+#define TEST_POINTER(json, path, expect) \
+    do {\
+        lept_pointer p;\
+        lept_value v, *e;\
+        char* actual;\
+        size_t length;\
+        lept_init(&v);\
+        EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));\
+        EXPECT_EQ_INT(0, lept_pointer_compile(&p, path));\
+        e = lept_pointer_get(&v, &p);\
+        EXPECT_TRUE(e != NULL);\
+        if (e != NULL) {\
+            actual = lept_stringify(e, &length);\
+            EXPECT_EQ_STRING(expect, actual, length);\
+            free(actual);\
+        }\
+        lept_pointer_free(&p);\
+        lept_free(&v);\
+    } while(0)
+
+static void test_pointer_missing(const char* json, const char* path) {
+    lept_pointer p;
+    lept_value v;
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, json));
+    EXPECT_EQ_INT(0, lept_pointer_compile(&p, path));
+    EXPECT_TRUE(lept_pointer_get(&v, &p) == NULL);
+    lept_pointer_free(&p);
+    lept_free(&v);
+}
+
+static void test_access_pointer() {
+    /* RFC 6901 第 5 节的例子 */
+    static const char doc[] = "{\"foo\":[\"bar\",\"baz\"],\"\":0,\"a/b\":1,\"c%d\":2,\"e^f\":3,\"g|h\":4,"
+                              "\"i\\\\j\":5,\"k\\\"l\":6,\" \":7,\"m~n\":8}";
+    lept_pointer p;
+    lept_value v;
+    TEST_POINTER(doc, "", doc);
+    TEST_POINTER(doc, "/foo", "[\"bar\",\"baz\"]");
+    TEST_POINTER(doc, "/foo/0", "\"bar\"");
+    TEST_POINTER(doc, "/", "0");
+    TEST_POINTER(doc, "/a~1b", "1");
+    TEST_POINTER(doc, "/c%d", "2");
+    TEST_POINTER(doc, "/e^f", "3");
+    TEST_POINTER(doc, "/g|h", "4");
+    TEST_POINTER(doc, "/i\\j", "5");
+    TEST_POINTER(doc, "/k\"l", "6");
+    TEST_POINTER(doc, "/ ", "7");
+    TEST_POINTER(doc, "/m~0n", "8");
+
+    test_pointer_missing(doc, "/foo/2");
+    test_pointer_missing(doc, "/foo/-");
+    test_pointer_missing(doc, "/foo/01");
+    test_pointer_missing(doc, "/foo/1x");
+    test_pointer_missing(doc, "/foo/99999999999999999999999");
+    test_pointer_missing(doc, "/foo/0/x");
+    test_pointer_missing(doc, "/bar");
+    TEST_POINTER("{\"a\":{\"b\":[1,{\"c\":[true]}]}}", "/a/b/1/c/0", "true");
+    TEST_POINTER("{\"10\":1}", "/10", "1");
+
+    EXPECT_EQ_INT(LEPT_POINTER_INVALID, lept_pointer_compile(&p, "foo"));
+    EXPECT_EQ_INT(LEPT_POINTER_INVALID, lept_pointer_compile(&p, "/a~2"));
+    EXPECT_EQ_INT(LEPT_POINTER_INVALID, lept_pointer_compile(&p, "/a~"));
+
+    /* 设置: 对象追加新成员, 数组替换或者在末尾追加, 上一层必须存在 */
+    lept_init(&v);
+    EXPECT_EQ_INT(LEPT_PARSE_OK, lept_parse(&v, "{\"a\":[1,2],\"b\":{}}"));
+    EXPECT_EQ_INT(0, lept_pointer_compile(&p, "/a/0"));
+    lept_set_number(lept_pointer_set(&v, &p), 10);
+    lept_pointer_free(&p);
+    EXPECT_EQ_INT(0, lept_pointer_compile(&p, "/a/-"));
+    lept_set_number(lept_pointer_set(&v, &p), 3);
+    lept_pointer_free(&p);
+    EXPECT_EQ_INT(0, lept_pointer_compile(&p, "/a/3"));
+    lept_set_number(lept_pointer_set(&v, &p), 4);
+    lept_pointer_free(&p);
+    EXPECT_EQ_INT(0, lept_pointer_compile(&p, "/a/5"));
+    EXPECT_TRUE(lept_pointer_set(&v, &p) == NULL);
+    lept_pointer_free(&p);
+    EXPECT_EQ_INT(0, lept_pointer_compile(&p, "/b/c~1d"));
+    lept_set_string(lept_pointer_set(&v, &p), "x", 1);
+    lept_set_string(lept_pointer_set(&v, &p), "y", 1);
+    lept_pointer_free(&p);
+    EXPECT_EQ_INT(0, lept_pointer_compile(&p, "/c/d"));
+    EXPECT_TRUE(lept_pointer_set(&v, &p) == NULL);
+    lept_pointer_free(&p);
+    {
+        char* json;
+        size_t length;
+        json = lept_stringify(&v, &length);
+        EXPECT_EQ_STRING("{\"a\":[10,2,3,4],\"b\":{\"c/d\":\"y\"}}", json, length);
+        free(json);
+    }
+    lept_free(&v);
+}
+
 static void test_access() {
     test_access_null();
     test_access_boolean();
     test_access_number();
+    test_access_integer();
     test_access_string();
+    test_access_short_string();
     test_access_array();
     test_access_object();
+    test_access_object_index();
+    test_access_compact();
+    test_access_pointer();
 }
 
 int main() {
@@ -735,6 +2421,21 @@ int main() {
     test_move();
     test_swap();
     test_access();
+    test_parse_sax();
+    test_parse_file();
+    test_snapshot();
+    test_parse_ndjson();
+    test_parse_stream();
+    test_parse_length();
+    test_parse_fast();
+    test_parse_fast_large();
+    test_parse_tape();
+    test_parse_cursor();
+    test_parse_projected();
+    test_cbor();
+    test_parse_arena();
+    test_parse_pooled();
+    test_parse_insitu();
     printf("%d/%d (%3.2f%%) passed\n", test_pass, test_count, test_pass * 100.0 / test_count);
     return main_ret;
 }
\ No newline at end of file